@@ -0,0 +1,111 @@
+/*
+  alloc_bench.cpp
+  Counts the heap allocations the typechecker makes on a generated program
+  of N classes, each calling its parent's four-argument method from a
+  method body, and fails if checking a call allocates. Checking a dispatch
+  used to copy the callee's formal list and the call's argument list; the
+  AST hands both out by const reference now (the static_asserts below),
+  so the count of allocations per extra call must stay at zero.
+
+    cmake --build build --target allocbench && build/allocbench [n]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "bench_util.h"
+#include "tree.h"
+
+using namespace std;
+
+/* the child lists that typechecking walks, which must not be copies */
+static_assert(is_same<decltype(declval<Program &>().get_stmt_list()),
+                      const StmtList &>::value);
+static_assert(is_same<decltype(declval<ClassStmt &>().get_feature_list()),
+                      const FeatureList &>::value);
+static_assert(is_same<decltype(declval<MethodStmt &>().get_formal_list()),
+                      const FormalList &>::value);
+static_assert(is_same<decltype(declval<MethodStmt &>().get_stmt_list()),
+                      const StmtList &>::value);
+static_assert(is_same<decltype(declval<DispatchExpr &>().get_args()),
+                      const ExprList &>::value);
+static_assert(is_same<decltype(declval<ListConstExpr &>().get_exprlist()),
+                      const ExprList &>::value);
+
+static bool counting = false;
+static size_t allocs = 0;
+
+void *operator new(size_t size) {
+  if (counting) allocs++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw bad_alloc();
+  return p;
+}
+
+/* out of line, or GCC inlines it and flags free() on memory from new */
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  free(p);
+}
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+
+/* N classes, each with CALLS calls of its parent's method */
+static string program(int n, int calls) {
+  string s;
+  for (int i = 0; i < n; i++) {
+    string c = "C" + to_string(i);
+    s += "class " + c;
+    if (i > 0) s += " inherits C" + to_string((i - 1) / 4);
+    s += " {\n  int m" + to_string(i) + "(int a, int b, int c, int d) {\n";
+    s += "    return a + b * c - d;\n  }\n";
+    if (i > 0) {
+      string p = "C" + to_string((i - 1) / 4);
+      s += "  int run(" + p + " o, int t) {\n";
+      for (int k = 0; k < calls; k++) {
+        s += "    t = o.m" + to_string((i - 1) / 4) + "(t, 1, 2, t);\n";
+      }
+      s += "    return t;\n  }\n";
+    }
+    s += "}\n";
+  }
+  return s;
+}
+
+/* the allocations made by typechecking SRC, or -1 if it does not check */
+static long typecheck_allocs(const string &src) {
+  BenchSource file("alloc_bench", src);
+  if (file.path.empty()) return -1;
+  BenchProgram prog(file.path);
+  if (!prog.parsed) return -1;
+
+  allocs = 0;
+  counting = true;
+  int errors = prog.typechecker.typecheck();
+  counting = false;
+  return errors ? -1 : (long)allocs;
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 3000;
+  const int extra = 8;
+  long base = typecheck_allocs(program(n, 1));
+  long more = typecheck_allocs(program(n, 1 + extra));
+  if (base < 0 || more < 0) {
+    fprintf(stderr, "alloc_bench: the generated program does not check\n");
+    return 1;
+  }
+  long calls = (long)(n - 1) * extra;
+  printf("%d classes: %ld typecheck allocations, %ld more for %ld more "
+         "calls\n",
+         n, base, more - base, calls);
+  if (more != base) {
+    printf("FAIL: checking a call allocates (%.2f per call)\n",
+           (double)(more - base) / calls);
+    return 1;
+  }
+  printf("ok: checking a call allocates nothing\n");
+  return 0;
+}
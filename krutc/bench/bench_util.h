@@ -0,0 +1,74 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "astarena.h"
+#include "parser.h"
+#include "typechecker.h"
+#include "typecontext.h"
+
+/*
+  What the benchmarks share: a clock, a generated program written out to a
+  .krut file for the compiler to read, and that file parsed and ready to
+  typecheck. Each benchmark keeps only its generator and its measurement.
+*/
+
+/* seconds since an arbitrary start */
+static inline double now() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+/* SRC in a new /tmp/NAME_XXXXXX.krut, removed again when this goes out of
+   scope. PATH is empty if the file could not be written */
+class BenchSource {
+ public:
+  std::string path;
+
+  BenchSource(const char *name, const std::string &src) {
+    std::string tmp = std::string("/tmp/") + name + "_XXXXXX.krut";
+    int fd = mkstemps(&tmp[0], 5);
+    if (fd < 0) {
+      perror(name);
+      return;
+    }
+    bool written = write(fd, src.data(), src.size()) == (ssize_t)src.size();
+    close(fd);
+    if (!written) {
+      perror(name);
+      unlink(tmp.c_str());
+      return;
+    }
+    path = tmp;
+  }
+  ~BenchSource() {
+    if (!path.empty()) unlink(path.c_str());
+  }
+  BenchSource(const BenchSource &) = delete;
+  BenchSource &operator=(const BenchSource &) = delete;
+};
+
+/* the program in PATH, parsed, with a typechecker over it that has not run
+   yet. PARSED is false if it has lexer or parser errors */
+struct BenchProgram {
+  AstArena arena;
+  TypeContext types;
+  Parser parser;
+  Program program;
+  TypeChecker typechecker;
+  bool parsed;
+
+  explicit BenchProgram(const std::string &path)
+      : types(arena),
+        parser(path, arena, types, false, false),
+        program(parser.parse_program()),
+        typechecker(program, arena, types, false, path),
+        parsed(parser.check_lexer_errors() && !parser.parser_errors) {}
+};
+
+#endif  // BENCH_UTIL_H
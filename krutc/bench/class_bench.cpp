@@ -0,0 +1,78 @@
+/*
+  class_bench.cpp
+  Times TypeChecker::typecheck() on a generated program of N classes
+  in a deep multiple-inheritance hierarchy: class Ci inherits
+  C(i-1) and up to two other earlier classes. Every instance is assigned
+  to a variable of a random ancestor type, and every class makes one
+  dispatch with an argument of a far-away subclass, so the checker asks
+  conforms() about pairs all over the hierarchy. Reports the best of 3
+  checks.
+
+    cmake --build build --target classbench && build/classbench [n]
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "bench_util.h"
+
+using namespace std;
+
+/* the same programs on every run */
+static uint64_t rng = 1;
+static int below(int n) {
+  rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (int)((rng >> 33) % n);
+}
+
+static string program(int n) {
+  rng = 1;
+  string s;
+  for (int i = 0; i < n; i++) {
+    string c = to_string(i);
+    s += "class C" + c;
+    if (i > 0) {
+      int a = below(i), b = below(i);
+      s += " inherits C" + to_string(i - 1);
+      if (a != i - 1) s += ", C" + to_string(a);
+      if (b != i - 1 && b != a) s += ", C" + to_string(b);
+    }
+    s += " { int a" + c + " = " + c + "; int m" + c + "(C0 x) { return " +
+         c + "; } }\n";
+  }
+  for (int i = 0; i < n; i++) {
+    s += "C" + to_string(i) + " o" + to_string(i) + " = new C" +
+         to_string(i) + ";\n";
+  }
+  for (int i = 0; i < n; i++) {
+    string c = to_string(i);
+    s += "C" + to_string(below(i + 1)) + " p" + c + " = o" + c + ";\n";
+    s += "int q" + c + " = o" + c + ".m" + c + "(o" + to_string(n - 1 - i % 7) +
+         ");\n";
+  }
+  return s;
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 3000;
+  BenchSource src("class_bench", program(n));
+  if (src.path.empty()) return 1;
+
+  double best = -1;
+  for (int run = 0; run < 3; run++) {
+    BenchProgram prog(src.path);
+    if (!prog.parsed) return 1;
+    double t = now();
+    int errors = prog.typechecker.typecheck();
+    t = now() - t;
+    if (errors) {
+      fprintf(stderr, "class_bench: the generated program does not check\n");
+      return 1;
+    }
+    if (best < 0 || t < best) best = t;
+  }
+  printf("%d classes: typecheck %.3f s\n", n, best);
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+  dict_bench.cpp
+  Times the runtime's dict (see runtime.h) against std::unordered_map on
+  the same work: inserting int keys, looking up keys that are and are not
+  there, overwriting, removing, and the same with string keys. Both hold
+  int64_t keys and values, and strings as KrutString pointers, hashed and
+  compared by contents, the way compiled KrutC code uses them.
+
+    cmake --build build --target dictbench && build/dictbench [n]
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "runtime.h"
+
+using namespace std;
+
+static double now() {
+  using namespace chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+/* keys in no particular order, as a program's would be */
+static int64_t key(int64_t i) { return i * 0x9E3779B97F4A7C15LL >> 16; }
+
+/* the keys 0 .. N-1 looked up in another order than they were inserted
+   in, so that neither table gains from allocating in key order */
+static int64_t other(int64_t i, int64_t n) { return key(i * 7919 % n); }
+
+struct StrHash {
+  size_t operator()(KrutString *s) const {
+    return hash<string_view>()(string_view(s->data, s->len));
+  }
+};
+struct StrEq {
+  bool operator()(KrutString *a, KrutString *b) const {
+    return krut_str_eq(a, b);
+  }
+};
+
+/* runs F, and prints how long it took as one column of NAME's row */
+template <class F>
+static int64_t time_it(const char *name, const char *impl, F f) {
+  double start = now();
+  int64_t r = f();
+  printf("%-22s %-14s %8.3f s  (%lld)\n", name, impl, now() - start,
+         (long long)r);
+  return r;
+}
+
+int main(int argc, char **argv) {
+  int64_t n = argc > 1 ? atoll(argv[1]) : 1000000;
+  vector<KrutString *> strs;
+  for (int64_t i = 0; i < n / 4; i++) {
+    string s = "key" + to_string(key(i));
+    strs.push_back(krut_str_new(s.data(), s.size()));
+  }
+
+  KrutDict *d = krut_dict_new(KRUT_KIND_BITS, KRUT_KIND_BITS);
+  unordered_map<int64_t, int64_t> m;
+  time_it("insert int", "dict", [&] {
+    for (int64_t i = 0; i < n; i++) krut_dict_insert(d, key(i), i);
+    return krut_dict_length(d);
+  });
+  time_it("insert int", "unordered_map", [&] {
+    for (int64_t i = 0; i < n; i++) m[key(i)] = i;
+    return (int64_t)m.size();
+  });
+
+  time_it("get int (hits)", "dict", [&] {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < n; i++) sum += krut_dict_get(d, other(i, n), 0);
+    return sum;
+  });
+  time_it("get int (hits)", "unordered_map", [&] {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < n; i++) sum += m.find(other(i, n))->second;
+    return sum;
+  });
+
+  time_it("contains int (misses)", "dict", [&] {
+    int64_t hits = 0;
+    for (int64_t i = n; i < 2 * n; i++) hits += krut_dict_contains(d, key(i));
+    return hits;
+  });
+  time_it("contains int (misses)", "unordered_map", [&] {
+    int64_t hits = 0;
+    for (int64_t i = n; i < 2 * n; i++) hits += m.count(key(i));
+    return hits;
+  });
+
+  time_it("overwrite int", "dict", [&] {
+    for (int64_t i = 0; i < n; i++) krut_dict_insert(d, key(i), -i);
+    return krut_dict_length(d);
+  });
+  time_it("overwrite int", "unordered_map", [&] {
+    for (int64_t i = 0; i < n; i++) m[key(i)] = -i;
+    return (int64_t)m.size();
+  });
+
+  time_it("remove int", "dict", [&] {
+    for (int64_t i = 0; i < n; i += 2) krut_dict_remove(d, key(i));
+    return krut_dict_length(d);
+  });
+  time_it("remove int", "unordered_map", [&] {
+    for (int64_t i = 0; i < n; i += 2) m.erase(key(i));
+    return (int64_t)m.size();
+  });
+
+  KrutDict *sd = krut_dict_new(KRUT_KIND_STR, KRUT_KIND_BITS);
+  unordered_map<KrutString *, int64_t, StrHash, StrEq> sm;
+  int64_t ns = strs.size();
+  time_it("insert string", "dict", [&] {
+    for (int64_t i = 0; i < ns; i++) krut_dict_insert(sd, (int64_t)strs[i], i);
+    return krut_dict_length(sd);
+  });
+  time_it("insert string", "unordered_map", [&] {
+    for (int64_t i = 0; i < ns; i++) sm[strs[i]] = i;
+    return (int64_t)sm.size();
+  });
+
+  time_it("get string (hits)", "dict", [&] {
+    int64_t sum = 0;
+    for (int r = 0; r < 4; r++) {
+      for (int64_t i = 0; i < ns; i++) {
+        sum += krut_dict_get(sd, (int64_t)strs[i], 0);
+      }
+    }
+    return sum;
+  });
+  time_it("get string (hits)", "unordered_map", [&] {
+    int64_t sum = 0;
+    for (int r = 0; r < 4; r++) {
+      for (int64_t i = 0; i < ns; i++) sum += sm.find(strs[i])->second;
+    }
+    return sum;
+  });
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+  jobs_bench.cpp
+  Times TypeChecker::typecheck() with -j 1, 2, 4 and 8 (or the thread
+  counts given) on a generated program of 100 classes of 100 methods
+  each, 10k method bodies with loops, branches, lists and calls. Reports
+  the best of 7 checks per thread count; the speedup is bounded by the
+  cores the machine has.
+
+    cmake --build build --target jobsbench && build/jobsbench [jobs ...]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+
+using namespace std;
+
+#define CLASSES 100
+#define METHODS 100
+
+static string program() {
+  string s = "int helper(int x, list<int> xs) {\n";
+  s += "  return x + xs.length();\n}\n";
+  for (int c = 0; c < CLASSES; c++) {
+    string k = to_string(c);
+    s += "int g" + k + " = " + k + ";\n";
+    s += "class K" + k;
+    if (c > 0) s += " inherits K" + to_string(c - 1);
+    s += " {\n  int a" + k + " = " + k + ";\n";
+    for (int m = 0; m < METHODS; m++) {
+      string i = to_string(m);
+      s += "  int f" + k + "_" + i + "(int x, list<int> xs) {\n";
+      s += "    int t = x * " + i + " + g" + k + " + a" + k + ";\n";
+      s += "    list<int> ys = [t, x, " + i + "];\n";
+      s += "    for (int k = 0; k < x; k += 1) {\n";
+      s += "      if (k > t) { t = t - k; } else { t = t + xs[k]; }\n";
+      s += "      ys.push_back(t);\n    }\n";
+      s += "    while (t > 100) { t = t / 2 + ys.length(); }\n";
+      if (m > 0) s += "    t = t + helper(t, ys);\n";
+      s += "    return t;\n  }\n";
+    }
+    s += "}\n";
+  }
+  return s;
+}
+
+/* seconds to typecheck the program in PATH on JOBS threads, or -1 if it
+   does not check */
+static double typecheck_time(const string &path, int jobs) {
+  BenchProgram prog(path);
+  if (!prog.parsed) return -1;
+
+  prog.typechecker.jobs = jobs;
+  double t = now();
+  int errors = prog.typechecker.typecheck();
+  t = now() - t;
+  return errors ? -1 : t;
+}
+
+int main(int argc, char **argv) {
+  vector<int> jobs;
+  for (int i = 1; i < argc; i++) jobs.push_back(atoi(argv[i]));
+  if (jobs.empty()) jobs = {1, 2, 4, 8};
+
+  BenchSource src("jobs_bench", program());
+  if (src.path.empty()) return 1;
+
+  printf("%d method bodies, %u cores\n", CLASSES * METHODS,
+         thread::hardware_concurrency());
+  int status = 0;
+  for (int j : jobs) {
+    double best = -1;
+    for (int run = 0; run < 7; run++) {
+      double t = typecheck_time(src.path, j);
+      if (t < 0) {
+        fprintf(stderr, "jobs_bench: the generated program does not check\n");
+        status = 1;
+        break;
+      }
+      if (best < 0 || t < best) best = t;
+    }
+    if (status) break;
+    printf("-j %-2d %8.1f ms\n", j, best * 1000);
+  }
+  return status;
+}
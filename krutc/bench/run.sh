@@ -0,0 +1,56 @@
+#!/bin/bash
+# Runs every benchmark here under the JIT (`krutc run`), the bytecode
+# interpreter alone (-interp) and the interpreter with tiering (-tiered),
+# checks each mode's output against the benchmark's .out file, and prints
+# the best wall time of each in seconds.  Then runs the small programs in
+# semantics/ once per mode and checks them against their .out files too.
+#
+#   bench/run.sh [path/to/krutc] [runs]
+
+KRUTC=${1:-$(dirname "$0")/../build/krutc}
+RUNS=${2:-3}
+MODES=("" -interp -tiered)
+TIMEFORMAT=%R
+OUT=/tmp/krut-bench.out
+
+cd "$(dirname "$0")" || exit 1
+status=0
+
+# Sets mark to "!" and records a failure unless $OUT matches $1's .out file.
+check() {
+  mark=
+  if ! diff -q "${1%.krut}.out" $OUT >/dev/null; then
+    mark="!"
+    status=1
+  fi
+}
+
+printf "%-14s %10s %10s %10s\n" benchmark jit interp tiered
+for f in *.krut; do
+  line=$(printf "%-14s" "${f%.krut}")
+  for mode in "${MODES[@]}"; do
+    best=
+    for ((i = 0; i < RUNS; i++)); do
+      t=$( { time "$KRUTC" run "$f" $mode >$OUT 2>/dev/null; } 2>&1)
+      if [ -z "$best" ] || awk "BEGIN { exit !($t < $best) }"; then best=$t; fi
+    done
+    check "$f"
+    line="$line $(printf "%10s" "$best$mark")"
+  done
+  echo "$line"
+done
+
+echo
+printf "%-14s %10s %10s %10s\n" semantics jit interp tiered
+for f in semantics/*.krut; do
+  line=$(printf "%-14s" "$(basename "${f%.krut}")")
+  for mode in "${MODES[@]}"; do
+    "$KRUTC" run "$f" $mode >$OUT 2>/dev/null
+    check "$f"
+    line="$line $(printf "%10s" "ok$mark")"
+  done
+  echo "$line"
+done
+
+[ $status = 0 ] || echo "!: output differs from the expected .out file"
+exit $status
@@ -0,0 +1,79 @@
+/*
+  token_bench.cpp
+  Lexes a generated program of N classes (about 77 tokens and 390 bytes
+  each, with comments, literals and every kind of token the parser sees)
+  through a TokenBuffer, and reports the heap bytes and allocations per
+  token and the time taken. The default of 20000 classes is a 7.7 MB
+  file of 1.54M tokens.
+
+    cmake --build build --target tokenbench && build/tokenbench [n]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "bench_util.h"
+#include "tokenbuffer.h"
+
+using namespace std;
+
+static size_t bytes = 0;
+static size_t allocs = 0;
+
+void *operator new(size_t size) {
+  bytes += size;
+  allocs++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw bad_alloc();
+  return p;
+}
+
+/* out of line, or GCC inlines it and flags free() on memory from new */
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  free(p);
+}
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+
+static string program(int n) {
+  string s;
+  for (int i = 0; i < n; i++) {
+    string c = to_string(i), field = "model_year_" + c;
+    s += "class Car" + c + " inherits Vehicle" + to_string(i % 7) + " {\n";
+    s += "  int " + field + " = " + c + " * 2 + 3;\n";
+    s += "  list<int> readings = [1, 2, 3, " + c + "];\n";
+    s += "  /* multi line\n     comment " + c + " */\n";
+    s += "  int drive(int miles, deci rate) {\n";
+    s += "    -- single line comment\n";
+    s += "    string s = \"owner number " + c + "\";\n";
+    s += "    for (int k = 0; k < miles; k += 1) {\n";
+    s += "      " + field + " = " + field + " + k * 2 - 1;\n";
+    s += "    }\n    return " + field + ";\n  }\n}\n";
+  }
+  return s;
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 20000;
+  BenchSource src("token_bench", program(n));
+  if (src.path.empty()) return 1;
+
+  size_t bytes0 = bytes, allocs0 = allocs;
+  double t = now();
+  size_t tokens = 0;
+  {
+    TokenBuffer tb(src.path, false);
+    while (tb.has_next()) {
+      tb.get_next();
+      tokens++;
+    }
+  }
+  t = now() - t;
+
+  bytes -= bytes0;
+  allocs -= allocs0;
+  printf("%zu tokens: %.1f bytes/token, %.2f allocations/token, %.3f s\n",
+         tokens, (double)bytes / tokens, (double)allocs / tokens, t);
+  return 0;
+}
@@ -0,0 +1,1230 @@
+#include "bccompiler.h"
+
+#include <cstring>
+
+#include "constants.h"
+#include "lowering.h"
+#include "tree.h"
+
+using namespace std;
+using namespace basic_classes;
+using namespace lexing;
+using namespace typechecking;
+
+//////////////////////////////////////////////////////////////
+//
+// Emitting code
+//
+//////////////////////////////////////////////////////////////
+
+static void op(BcCompiler &bc, Opcode o, initializer_list<int32_t> operands) {
+  vector<int32_t> &code = bc.method->code;
+  bc.last_op = code.size();
+  code.push_back(o);
+  code.insert(code.end(), operands);
+}
+
+/* a register for a value that is read once */
+static int temp(BcCompiler &bc) {
+  int r = bc.top++;
+  if (bc.top > bc.method->nregs) bc.method->nregs = bc.top;
+  return r;
+}
+
+/* where to put a value computed from register A: A itself if it is a
+   temporary, which nothing reads again */
+static int dest(BcCompiler &bc, int a) {
+  return a >= bc.locals_end ? a : temp(bc);
+}
+
+static int dest(BcCompiler &bc, int a, int b) {
+  return a >= bc.locals_end ? a : dest(bc, b);
+}
+
+static int load_const(BcCompiler &bc, int64_t v) {
+  auto it = bc.const_index.find(v);
+  if (it == bc.const_index.end()) {
+    it = bc.const_index.emplace(v, bc.module.consts.size()).first;
+    bc.module.consts.push_back(v);
+  }
+  int d = temp(bc);
+  op(bc, OP_LOADK, {d, it->second});
+  return d;
+}
+
+static int load_deci(BcCompiler &bc, double d) {
+  int64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return load_const(bc, bits);
+}
+
+/* an instruction ending in a jump target, which is patched later; returns
+   where the target goes */
+static int jump(BcCompiler &bc, Opcode o, initializer_list<int32_t> operands) {
+  op(bc, o, operands);
+  bc.method->code.push_back(0);
+  return bc.method->code.size() - 1;
+}
+
+/* the offset of the next instruction, which a jump goes to */
+static int label(BcCompiler &bc) {
+  bc.last_label = bc.method->code.size();
+  return bc.last_label;
+}
+
+/* points the jump at AT to the next instruction */
+static void patch(BcCompiler &bc, int at) {
+  bc.method->code[at] = label(bc);
+}
+
+/* true if opcode O writes the register in its first operand */
+static bool writes_first(int32_t o) {
+  switch (o) {
+    case OP_STORE_GLOBAL:
+    case OP_STORE_FIELD:
+    case OP_RETURN:
+      return false;
+    default:
+      return o < OP_JUMP || o > OP_JGE_IK;
+  }
+}
+
+/* copies register V, a value read only here, to register R. If V is a
+   temporary the last instruction wrote, and no jump lands after it, that
+   instruction writes R instead */
+static void move_reg(BcCompiler &bc, int r, int v) {
+  if (r == v) return;
+  vector<int32_t> &code = bc.method->code;
+  if (v >= bc.locals_end && bc.last_op >= 0 &&
+      bc.last_label != (int)code.size() && writes_first(code[bc.last_op]) &&
+      code[bc.last_op + 1] == v) {
+    code[bc.last_op + 1] = r;
+    return;
+  }
+  op(bc, OP_MOVE, {r, v});
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Calls
+//
+//////////////////////////////////////////////////////////////
+
+/*
+  A call's arguments go in consecutive registers from the first free one,
+  its base, where the call then leaves its value:
+    int base = bc.top;
+    arg(bc, ...); arg(bc, ...);
+    call_native(bc, "krut_...", base);
+*/
+static void arg(BcCompiler &bc, int r) { op(bc, OP_MOVE, {temp(bc), r}); }
+
+static int emit(BcCompiler &bc, ExprStmt *e, Type_ *want);
+
+static void arg(BcCompiler &bc, ExprStmt *e, Type_ *want) {
+  int r = temp(bc);
+  move_reg(bc, r, emit(bc, e, want));
+  bc.top = r + 1;
+}
+
+static void const_arg(BcCompiler &bc, int64_t v) {
+  int r = temp(bc);
+  move_reg(bc, r, load_const(bc, v));
+  bc.top = r + 1;
+}
+
+static int call_native(BcCompiler &bc, const string &name, int base) {
+  if (bc.top == base) temp(bc); /* no arguments, but a value */
+  op(bc, OP_CALL_NATIVE, {base, bc_native(name), base});
+  bc.top = base + 1;
+  return base;
+}
+
+static void c_string_arg(BcCompiler &bc, const string &s) {
+  bc.module.strings.push_back(s);
+  const_arg(bc, (int64_t)bc.module.strings.back().c_str());
+}
+
+static int new_string(BcCompiler &bc, const string &s) {
+  int base = bc.top;
+  c_string_arg(bc, s);
+  const_arg(bc, s.size());
+  return call_native(bc, "krut_str_new", base);
+}
+
+/* fails at run time; the value is a placeholder */
+static int unsupported(BcCompiler &bc, int lineno, const string &what) {
+  int base = bc.top;
+  const_arg(bc, lineno);
+  c_string_arg(bc, what);
+  return call_native(bc, "krut_unsupported", base);
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Values
+//
+//////////////////////////////////////////////////////////////
+
+static int unary(BcCompiler &bc, Opcode o, int a) {
+  int d = dest(bc, a);
+  op(bc, o, {d, a});
+  return d;
+}
+
+static int binary(BcCompiler &bc, Opcode o, int a, int b) {
+  int d = dest(bc, a, b);
+  op(bc, o, {d, a, b});
+  return d;
+}
+
+/* a value converted to type T keeps only the bits T has */
+static int narrow(BcCompiler &bc, int r, Type_ *t) {
+  if (type_class(t) == T_CHAR) return unary(bc, OP_NARROW_C, r);
+  if (type_class(t) == T_BOOL) return unary(bc, OP_NARROW_B, r);
+  return r;
+}
+
+/* see convert() in codegen.cpp */
+static int convert(BcCompiler &bc, int r, Type_ *from, Type_ *to) {
+  if (!to || type_class(to) == T_VOID) return r;
+  TypeClass f = type_class(from), t = type_class(to);
+  if (f == t || t == T_OBJECT || f == T_VOID) return r;
+  bool f_int = f == T_INT || f == T_CHAR || f == T_BOOL;
+  bool t_int = t == T_INT || t == T_CHAR || t == T_BOOL;
+  if (f_int && t == T_DECI) return unary(bc, OP_I2D, r);
+  if (f == T_DECI && t_int) return narrow(bc, unary(bc, OP_D2I, r), to);
+  return narrow(bc, r, to);
+}
+
+static int to_bool(BcCompiler &bc, int r, Type_ *t) {
+  switch (type_class(t)) {
+    case T_BOOL:
+      return r;
+    case T_DECI:
+      return unary(bc, OP_D2B, r);
+    default:
+      return unary(bc, OP_I2B, r);
+  }
+}
+
+static int default_value(BcCompiler &bc, Type_ *t) {
+  int base = bc.top;
+  switch (type_class(t)) {
+    case T_STRING:
+      return new_string(bc, "");
+    case T_LIST:
+      const_arg(bc, elem_kind(t->get_nested_type()));
+      const_arg(bc, 0);
+      return call_native(bc, "krut_list_new", base);
+    case T_SET:
+      const_arg(bc, elem_kind(t->get_nested_type()));
+      return call_native(bc, "krut_set_new", base);
+    case T_DICT:
+      const_arg(bc, elem_kind(t->get_nested_type()));
+      const_arg(bc, elem_kind(t->get_value_type()));
+      return call_native(bc, "krut_dict_new", base);
+    default:
+      return load_const(bc, 0);
+  }
+}
+
+/* compiles E, then converts its value to type WANT (NULL: as it is) */
+static int emit(BcCompiler &bc, ExprStmt *e, Type_ *want) {
+  Type_ *saved = bc.expected_type;
+  bc.expected_type = want;
+  int r = e->compile(bc);
+  bc.expected_type = saved;
+  return convert(bc, r, e->get_type(), want);
+}
+
+static void compile_stmts(BcCompiler &bc, const StmtList &stmts) {
+  for (Stmt *s : stmts) {
+    bc.top = bc.locals_end;
+    bc.expected_type = NULL;
+    s->compile(bc);
+  }
+  bc.top = bc.locals_end;
+}
+
+static bool is_assign(const string &o) {
+  return o == Define || o == PlusEquals || o == MinusEquals ||
+         o == TimesEquals || o == DivideEquals;
+}
+
+/* true if evaluating E may assign to a variable */
+static bool assigns(ExprStmt *e) {
+  if (!e) return false;
+  switch (e->get_stmttype()) {
+    case BINOP_EXPR: {
+      BinopExpr *b = static_cast<BinopExpr *>(e);
+      return is_assign(b->get_op()) || assigns(b->get_lhs()) ||
+             assigns(b->get_rhs());
+    }
+    case DISPATCH_EXPR: {
+      DispatchExpr *d = static_cast<DispatchExpr *>(e);
+      if (assigns(d->get_calling_expr())) return true;
+      for (ExprStmt *a : d->get_args()) {
+        if (assigns(a)) return true;
+      }
+      return false;
+    }
+    case SUBLIST_EXPR: {
+      SublistExpr *s = static_cast<SublistExpr *>(e);
+      return assigns(s->get_list_name()) || assigns(s->get_st_idx()) ||
+             assigns(s->get_end_idx());
+    }
+    case LIST_ELEM_REF: {
+      ListElemRef *ref = static_cast<ListElemRef *>(e);
+      return assigns(ref->get_list_name()) || assigns(ref->get_index());
+    }
+    case LIST_CONST_EXPR:
+      for (ExprStmt *x : static_cast<ListConstExpr *>(e)->get_exprlist()) {
+        if (assigns(x)) return true;
+      }
+      return false;
+    case SET_CONST_EXPR:
+      for (ExprStmt *x : static_cast<SetConstExpr *>(e)->get_exprset()) {
+        if (assigns(x)) return true;
+      }
+      return false;
+    default:
+      return false;
+  }
+}
+
+/* the value register R holds now, even if evaluating LATER assigns to the
+   variable R is */
+static int keep(BcCompiler &bc, int r, ExprStmt *later) {
+  if (r >= bc.locals_end || !assigns(later)) return r;
+  int t = temp(bc);
+  op(bc, OP_MOVE, {t, r});
+  return t;
+}
+
+/* true if E is an int constant that fits in an operand */
+static bool immediate(ExprStmt *e, int32_t &imm) {
+  if (e->get_stmttype() != INT_CONST_EXPR) return false;
+  long v = static_cast<IntConstExpr *>(e)->get_val();
+  if (v < INT32_MIN || v > INT32_MAX) return false;
+  imm = v;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Variables
+//
+//////////////////////////////////////////////////////////////
+
+static Symbol intern(const string &name) {
+  return SymbolTable::global().intern(name);
+}
+
+static BcVar *lookup_var(BcCompiler &bc, Symbol name) {
+  for (auto it = bc.scopes.rbegin(); it != bc.scopes.rend(); ++it) {
+    auto v = it->find(name);
+    if (v != it->end()) return &v->second;
+  }
+  return NULL;
+}
+
+/* the slot of attribute NAME in the layout of this_class, or -1 */
+static int field_slot(BcCompiler &bc, Symbol name) {
+  if (!bc.this_class) return -1;
+  const AttrTable::Entry *e = bc.attrs[bc.this_class]->lookup(name);
+  return e ? e->slot : -1;
+}
+
+static int load_var(BcCompiler &bc, BcVar &var, Symbol name) {
+  if (var.kind == BcVar::LOCAL) return var.index;
+  int d = temp(bc);
+  if (var.kind == BcVar::GLOBAL) {
+    op(bc, OP_LOAD_GLOBAL, {d, var.index});
+  } else {
+    op(bc, OP_LOAD_FIELD, {d, field_slot(bc, name)});
+  }
+  return d;
+}
+
+/* stores register V; returns the register that holds the value after */
+static int store_var(BcCompiler &bc, BcVar &var, Symbol name, int v) {
+  switch (var.kind) {
+    case BcVar::LOCAL:
+      move_reg(bc, var.index, v);
+      return var.index;
+    case BcVar::GLOBAL:
+      op(bc, OP_STORE_GLOBAL, {var.index, v});
+      return v;
+    case BcVar::FIELD:
+      op(bc, OP_STORE_FIELD, {field_slot(bc, name), v});
+      return v;
+  }
+  return v;
+}
+
+/* a register for a variable, above the ones declared so far */
+static int new_local(BcCompiler &bc) {
+  int r = bc.locals_end++;
+  if (bc.top < bc.locals_end) temp(bc);
+  bc.method->nlocals = bc.locals_end;
+  return r;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Methods and classes
+//
+//////////////////////////////////////////////////////////////
+
+static BcMethod *new_method(BcCompiler &bc, const string &name,
+                            MethodStmt *stmt) {
+  bc.module.methods.push_back(make_unique<BcMethod>());
+  BcMethod *m = bc.module.methods.back().get();
+  m->name = name;
+  m->stmt = stmt;
+  return m;
+}
+
+static int method_index(BcCompiler &bc, BcMethod *m) {
+  for (size_t i = 0; i < bc.module.methods.size(); i++) {
+    if (bc.module.methods[i].get() == m) return i;
+  }
+  return -1;
+}
+
+/* saves the method being compiled, so that one can be compiled in the
+   middle of another; see SavedFunction */
+struct SavedMethod {
+  BcCompiler &bc;
+  BcMethod *method;
+  MethodStmt *curr_method;
+  BcClass *this_class;
+  int locals_end, top, last_op, last_label;
+  vector<BcLoop> loops;
+
+  SavedMethod(BcCompiler &bc)
+      : bc(bc),
+        method(bc.method),
+        curr_method(bc.curr_method),
+        this_class(bc.this_class),
+        locals_end(bc.locals_end),
+        top(bc.top),
+        last_op(bc.last_op),
+        last_label(bc.last_label),
+        loops(move(bc.loops)) {
+    bc.loops.clear();
+  }
+
+  ~SavedMethod() {
+    bc.method = method;
+    bc.curr_method = curr_method;
+    bc.this_class = this_class;
+    bc.locals_end = locals_end;
+    bc.top = top;
+    bc.last_op = last_op;
+    bc.last_label = last_label;
+    bc.loops = move(loops);
+  }
+};
+
+/* starts compiling BM, whose first NARGS registers are its arguments */
+static void begin_method(BcCompiler &bc, BcMethod *bm, int nargs) {
+  bc.method = bm;
+  bm->nargs = bm->nlocals = bm->nregs = nargs;
+  bc.locals_end = bc.top = nargs;
+  bc.last_op = bc.last_label = -1;
+}
+
+/* compiles the body of method M as BM; if CLS is set, as a method of CLS,
+   whose `this` is register 0 */
+static void compile_method_body(BcCompiler &bc, MethodStmt *m, BcClass *cls,
+                                BcMethod *bm) {
+  SavedMethod saved(bc);
+  begin_method(bc, bm, (cls ? 1 : 0) + m->get_formal_list().size());
+  bc.curr_method = m;
+  bc.this_class = cls;
+  bc.scopes.emplace_back();
+
+  int n = cls ? 1 : 0;
+  for (FormalStmt *formal : m->get_formal_list()) {
+    bc.scopes.back()[intern(formal->get_name())] = {BcVar::LOCAL, n++,
+                                                   formal->get_type()};
+  }
+
+  compile_stmts(bc, m->get_stmt_list());
+  op(bc, OP_RETURN, {load_const(bc, 0)});
+  bc.scopes.pop_back();
+}
+
+/* CLS's init(this), see emit_class_init(); it returns `this`, which is
+   what OP_NEW leaves */
+static void compile_class_init(BcCompiler &bc, BcClass *cls) {
+  SavedMethod saved(bc);
+  begin_method(bc, cls->init, 1);
+  bc.curr_method = NULL;
+  bc.this_class = cls;
+
+  bc.scopes.emplace_back();
+  for (const AttrTable::Entry &e : bc.attrs[cls]->get_entries()) {
+    AttrStmt *a = e.feature;
+    int v = a->get_init() ? emit(bc, a->get_init(), a->get_type())
+                          : default_value(bc, a->get_type());
+    op(bc, OP_STORE_FIELD, {e.slot, v});
+    bc.scopes.back()[e.name] = {BcVar::FIELD, 0, a->get_type()};
+    bc.top = bc.locals_end;
+  }
+  bc.scopes.pop_back();
+  op(bc, OP_RETURN, {0});
+}
+
+/* true if A's entries are the first entries of B, in the same slots */
+template <class T>
+static bool is_prefix(const FeatureTable<T> &a, const FeatureTable<T> &b) {
+  if (a.size() > b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a.get_entries()[i].name != b.get_entries()[i].name) return false;
+  }
+  return true;
+}
+
+/* see CodeGen::declare_classes(), declare_methods() and build_vtables() */
+static void declare(BcCompiler &bc, Program &program) {
+  BcModule &module = bc.module;
+  TypeChecker &tc = bc.typechecker;
+
+  for (Stmt *s : program) {
+    if (MethodStmt *m = dynamic_cast<MethodStmt *>(s)) {
+      BcMethod *bm = new_method(bc, m->get_name(), m);
+      bm->tierable = true;
+      module.global_methods[m] = bm;
+      if (m->get_name() == Main) module.main = bm;
+      continue;
+    }
+    ClassStmt *cs = dynamic_cast<ClassStmt *>(s);
+    if (!cs) continue;
+    BcClass *&cls = bc.classes[cs->get_name()];
+    if (!cls) {
+      module.classes.push_back(make_unique<BcClass>());
+      cls = module.classes.back().get();
+      cls->name = cs->get_name();
+      cls->id = module.classes.size() - 1;
+      cls->header[0] = cls->name.c_str();
+      cls->header[1] = cls;
+      bc.attrs[cls] = tc.get_attr_table(cls->name);
+      cls->nattrs = bc.attrs[cls]->size();
+      cls->init = new_method(bc, cls->name + ".init", NULL);
+    }
+    cls->stmt = cs;
+  }
+
+  /* each class's own methods */
+  unordered_map<MethodStmt *, BcClass *> owner;
+  for (auto &cls : module.classes) {
+    for (Feature *f : cls->stmt->get_feature_list()) {
+      if (!f->is_method()) continue;
+      MethodStmt *m = static_cast<MethodStmt *>(f);
+      BcMethod *bm = new_method(bc, cls->name + "." + m->get_name(), m);
+      bc.method_bodies[m].push_back({cls.get(), bm});
+      owner[m] = cls.get();
+    }
+  }
+
+  vector<string> order;
+  for (auto &cls : module.classes) order.push_back(cls->name);
+  bc.vtable_slots = vtable_slots(tc, order);
+
+  /* the method in each slot; an inherited method is shared unless the
+     layouts differ, then the subclass gets its own copy */
+  for (auto &cls : module.classes) {
+    const MethodTable *methods = tc.get_method_table(cls->name);
+    for (const MethodTable::Entry &e : methods->get_entries()) {
+      MethodStmt *m = e.feature;
+      BcClass *o = owner[m];
+      if (!is_prefix(*bc.attrs[o], *bc.attrs[cls.get()])) o = cls.get();
+      BcMethod *bm = NULL;
+      for (auto &body : bc.method_bodies[m]) {
+        if (body.first == o) bm = body.second;
+      }
+      if (!bm) {
+        bm = new_method(bc, cls->name + "." + m->get_name(), m);
+        bc.method_bodies[m].push_back({cls.get(), bm});
+      }
+      size_t slot = bc.vtable_slots.at(e.name);
+      if (cls->vtable.size() <= slot) cls->vtable.resize(slot + 1);
+      cls->vtable[slot] = bm;
+    }
+  }
+}
+
+unique_ptr<BcModule> compile_bytecode(Program &program,
+                                      TypeChecker &typechecker) {
+  unique_ptr<BcModule> module = make_unique<BcModule>();
+  BcCompiler bc(*module, typechecker);
+  declare(bc, program);
+
+  module->top = new_method(bc, "<top>", NULL);
+  begin_method(bc, module->top, 0);
+  bc.scopes.emplace_back(); /* the globals */
+  compile_stmts(bc, program.get_stmt_list());
+  op(bc, OP_RETURN, {load_const(bc, 0)});
+  bc.scopes.pop_back();
+
+  size_t n = module->global_index.size();
+  module->globals = make_unique<int64_t[]>(n ? n : 1);
+  return module;
+}
+
+//////////////////////////////////////////////////////////////
+//
+//
+// STATEMENTS
+//
+//
+//////////////////////////////////////////////////////////////
+
+/* statements return -1; the temporaries they used are free after */
+
+int ExprStmt::compile(BcCompiler &bc) { return load_const(bc, 0); }
+int FormalStmt::compile(BcCompiler &) { return -1; }
+
+int ClassStmt::compile(BcCompiler &bc) {
+  auto it = bc.classes.find(name);
+  if (it == bc.classes.end() || it->second->stmt != this) {
+    /* only classes in the outer scope are classes */
+    return -1;
+  }
+
+  /* the class's methods see its attributes declared before them */
+  bc.scopes.emplace_back();
+  for (Feature *f : feature_list) {
+    if (f->is_method()) {
+      MethodStmt *m = static_cast<MethodStmt *>(f);
+      for (auto &body : bc.method_bodies[m]) {
+        compile_method_body(bc, m, body.first, body.second);
+      }
+    } else {
+      AttrStmt *a = static_cast<AttrStmt *>(f);
+      bc.scopes.back()[intern(a->get_name())] = {BcVar::FIELD, 0,
+                                                 a->get_type()};
+    }
+  }
+  bc.scopes.pop_back();
+
+  compile_class_init(bc, it->second);
+  return -1;
+}
+
+int AttrStmt::compile(BcCompiler &bc) {
+  /* the initializer still sees the variable this one shadows */
+  int v = init ? emit(bc, init, type) : default_value(bc, type);
+  BcVar var;
+  if (bc.method == bc.module.top) {
+    var = {BcVar::GLOBAL, (int)bc.module.global_index.size(), type};
+    bc.module.global_index[this] = var.index;
+  } else {
+    var = {BcVar::LOCAL, new_local(bc), type};
+  }
+  Symbol sym = intern(name);
+  store_var(bc, var, sym, v);
+  bc.scopes.back()[sym] = var;
+  return -1;
+}
+
+int MethodStmt::compile(BcCompiler &bc) {
+  /* class methods are compiled by their ClassStmt */
+  auto it = bc.module.global_methods.find(this);
+  if (it != bc.module.global_methods.end()) {
+    compile_method_body(bc, this, NULL, it->second);
+  }
+  return -1;
+}
+
+/* a jump taken when condition C is false; comparing ints and jumping is
+   one instruction */
+static int jump_unless(BcCompiler &bc, ExprStmt *c) {
+  if (c->get_stmttype() == BINOP_EXPR) {
+    BinopExpr *b = static_cast<BinopExpr *>(c);
+    const string &o = b->get_op();
+    Type_ *t = operand_type(b->get_lhs()->get_type(), b->get_rhs()->get_type());
+    TypeClass tc = type_class(t);
+    /* the opposite comparison, which decis do not have because of NaN */
+    Opcode j = o == Equal         ? OP_JNE_I
+               : o == NotEqual    ? OP_JEQ_I
+               : o == LessThan    ? OP_JGE_I
+               : o == LEQ         ? OP_JGT_I
+               : o == GreaterThan ? OP_JLE_I
+               : o == GEQ         ? OP_JLT_I
+                                  : OP_JUMP;
+    if (j != OP_JUMP && (tc == T_INT || tc == T_CHAR || tc == T_BOOL)) {
+      int a = emit(bc, b->get_lhs(), t);
+      int32_t imm;
+      if (tc == T_INT && immediate(b->get_rhs(), imm)) {
+        return jump(bc, (Opcode)(j - OP_JEQ_I + OP_JEQ_IK), {a, imm});
+      }
+      a = keep(bc, a, b->get_rhs());
+      return jump(bc, j, {a, emit(bc, b->get_rhs(), t)});
+    }
+  }
+  int r = to_bool(bc, emit(bc, c, NULL), c->get_type());
+  return jump(bc, OP_JUMP_IF_FALSE, {r});
+}
+
+int IfStmt::compile(BcCompiler &bc) {
+  int to_else = jump_unless(bc, pred);
+  compile_stmts(bc, then_branch);
+  if (else_branch.empty()) {
+    patch(bc, to_else);
+    return -1;
+  }
+  int to_end = jump(bc, OP_JUMP, {});
+  patch(bc, to_else);
+  compile_stmts(bc, else_branch);
+  patch(bc, to_end);
+  return -1;
+}
+
+int WhileStmt::compile(BcCompiler &bc) {
+  int cond = label(bc);
+  int to_end = jump_unless(bc, pred);
+
+  bc.loops.emplace_back();
+  compile_stmts(bc, stmt_list);
+  BcLoop loop = move(bc.loops.back());
+  bc.loops.pop_back();
+  for (int at : loop.conts) bc.method->code[at] = cond;
+  op(bc, OP_LOOP, {cond});
+
+  patch(bc, to_end);
+  for (int at : loop.breaks) patch(bc, at);
+  return -1;
+}
+
+int ForStmt::compile(BcCompiler &bc) {
+  if (stmt) {
+    bc.expected_type = NULL;
+    stmt->compile(bc);
+    bc.top = bc.locals_end;
+  }
+  int cond_at = label(bc);
+  int to_end = cond ? jump_unless(bc, cond) : -1;
+
+  bc.loops.emplace_back();
+  compile_stmts(bc, stmt_list);
+  BcLoop loop = move(bc.loops.back());
+  bc.loops.pop_back();
+
+  for (int at : loop.conts) patch(bc, at);
+  if (repeat) {
+    emit(bc, repeat, NULL);
+    bc.top = bc.locals_end;
+  }
+  op(bc, OP_LOOP, {cond_at});
+
+  if (to_end >= 0) patch(bc, to_end);
+  for (int at : loop.breaks) patch(bc, at);
+  return -1;
+}
+
+int BreakStmt::compile(BcCompiler &bc) {
+  if (!bc.loops.empty()) {
+    bc.loops.back().breaks.push_back(jump(bc, OP_JUMP, {}));
+  }
+  return -1;
+}
+
+int ContStmt::compile(BcCompiler &bc) {
+  if (!bc.loops.empty()) {
+    bc.loops.back().conts.push_back(jump(bc, OP_JUMP, {}));
+  }
+  return -1;
+}
+
+/////////////////////////////////////////////////////////////////
+//
+//
+// EXPRESSIONS
+//
+//
+/////////////////////////////////////////////////////////////////
+
+/* expressions return the register holding their value, 0 if they have
+   none (void) */
+
+int ReturnExpr::compile(BcCompiler &bc) {
+  if (!bc.curr_method) {
+    /* a return outside of a method only evaluates its expression */
+    return expr ? emit(bc, expr, NULL) : load_const(bc, 0);
+  }
+  Type_ *ret_type = bc.curr_method->get_ret_type();
+  int r;
+  if (expr && type_class(ret_type) != T_VOID) {
+    r = emit(bc, expr, ret_type);
+  } else {
+    if (expr) emit(bc, expr, NULL);
+    r = load_const(bc, 0);
+  }
+  op(bc, OP_RETURN, {r});
+  return r;
+}
+
+int IntConstExpr::compile(BcCompiler &bc) { return load_const(bc, val); }
+
+int DeciConstExpr::compile(BcCompiler &bc) { return load_deci(bc, val); }
+
+int StrConstExpr::compile(BcCompiler &bc) {
+  /* strings are mutable, so each evaluation makes a new one */
+  return new_string(bc, get_value());
+}
+
+int CharConstExpr::compile(BcCompiler &bc) {
+  return load_const(bc, (unsigned char)get_char());
+}
+
+int BoolConstExpr::compile(BcCompiler &bc) {
+  return load_const(bc, val ? 1 : 0);
+}
+
+int SetConstExpr::compile(BcCompiler &bc) {
+  /* an empty literal holds what the variable it is assigned to holds */
+  Type_ *t = get_type() ? get_type() : bc.expected_type;
+  if (type_class(t) == T_DICT) return default_value(bc, t); /* `{}` */
+  Type_ *elem = t ? t->get_nested_type() : NULL;
+  int s = bc.top;
+  const_arg(bc, elem_kind(elem));
+  call_native(bc, "krut_set_new", s);
+  for (ExprStmt *e : exprset) {
+    int base = bc.top;
+    arg(bc, s);
+    arg(bc, e, elem);
+    call_native(bc, "krut_set_insert", base);
+    bc.top = s + 1;
+  }
+  return s;
+}
+
+int ListConstExpr::compile(BcCompiler &bc) {
+  /* an empty literal holds what the variable it is assigned to holds */
+  Type_ *t = get_type() ? get_type() : bc.expected_type;
+  Type_ *elem = t ? t->get_nested_type() : NULL;
+  int l = bc.top;
+  const_arg(bc, elem_kind(elem));
+  const_arg(bc, exprlist.size());
+  call_native(bc, "krut_list_new", l);
+  for (ExprStmt *e : exprlist) {
+    int base = bc.top;
+    arg(bc, l);
+    arg(bc, e, elem);
+    call_native(bc, "krut_list_push_back", base);
+    bc.top = l + 1;
+  }
+  return l;
+}
+
+int ListElemRef::compile(BcCompiler &bc) {
+  Type_ *t = list_name->get_type();
+  if (type_class(t) == T_STRING) {
+    int s = keep(bc, emit(bc, list_name, NULL), index);
+    int i = emit(bc, index, NULL);
+    int d = dest(bc, s, i);
+    op(bc, OP_GET_S, {d, s, i, lineno});
+    return d;
+  }
+  if (type_class(t) != T_LIST) {
+    emit(bc, list_name, NULL);
+    emit(bc, index, NULL);
+    return unsupported(bc, lineno, "`" + t->to_str() + "` cannot be indexed");
+  }
+  int base = bc.top;
+  arg(bc, list_name, NULL);
+  arg(bc, index, NULL);
+  const_arg(bc, lineno);
+  return narrow(bc, call_native(bc, "krut_list_get", base),
+                t->get_nested_type());
+}
+
+int SublistExpr::compile(BcCompiler &bc) {
+  Type_ *t = get_list_name()->get_type();
+  bool is_string = type_class(t) == T_STRING;
+  if (!is_string && type_class(t) != T_LIST) {
+    emit(bc, get_list_name(), NULL);
+    return unsupported(bc, lineno, "`" + t->to_str() + "` cannot be sliced");
+  }
+
+  /* l[:m] starts at 0, l[n:] ends at the length */
+  int base = bc.top;
+  arg(bc, get_list_name(), NULL);
+  if (get_st_idx()) {
+    arg(bc, get_st_idx(), NULL);
+  } else {
+    const_arg(bc, 0);
+  }
+  if (end_idx) {
+    arg(bc, end_idx, NULL);
+  } else if (is_string) {
+    op(bc, OP_LEN_S, {temp(bc), base});
+  } else {
+    int len = bc.top;
+    arg(bc, base);
+    call_native(bc, "krut_list_length", len);
+  }
+  const_arg(bc, lineno);
+  return call_native(bc, is_string ? "krut_str_slice" : "krut_list_slice",
+                     base);
+}
+
+int ObjectIdExpr::compile(BcCompiler &bc) {
+  BcVar *var = lookup_var(bc, sym);
+  if (!var || (var->kind == BcVar::FIELD && field_slot(bc, sym) < 0)) {
+    return load_const(bc, 0);
+  }
+  return load_var(bc, *var, sym);
+}
+
+/* a call to a builtin global method; see emit_builtin() */
+static int compile_builtin(BcCompiler &bc, DispatchExpr *d) {
+  const string &name = d->get_name();
+  ExprStmt *arg_expr = d->get_args()[0];
+  Type_ *formal = d->get_method()->get_formal_list()[0]->get_type();
+  int base = bc.top;
+
+  if (name == Type_Of) {
+    Type_ *t = arg_expr->get_type();
+    if (type_class(t) == T_CLASS) {
+      arg(bc, arg_expr, NULL);
+      return call_native(bc, "krut_class_name", base);
+    }
+    emit(bc, arg_expr, NULL);
+    bc.top = base;
+    return new_string(bc, t ? t->to_str() : Object);
+  }
+  if (name == Abs) return unary(bc, OP_ABS_I, emit(bc, arg_expr, formal));
+
+  arg(bc, arg_expr, formal);
+  if (name == Print) return call_native(bc, "krut_print", base);
+  if (name == Input) return call_native(bc, "krut_input", base);
+  if (name == To_String) return call_native(bc, "krut_to_string", base);
+  if (name == Sum) return call_native(bc, "krut_sum", base);
+  if (name == Min || name == Max) {
+    const_arg(bc, d->lineno);
+    return call_native(bc, name == Min ? "krut_min" : "krut_max", base);
+  }
+  if (name == Kill) return call_native(bc, "krut_kill", base);
+  return unsupported(bc, d->lineno,
+                     "builtin `" + name + "` is not implemented");
+}
+
+/* a call to a method of a string, list, set or dict, which is in register
+   BASE */
+static int compile_container_call(BcCompiler &bc, DispatchExpr *d, Type_ *t,
+                                  int base) {
+  const string &name = d->get_name();
+  MethodStmt *m = d->get_method();
+  if (type_class(t) == T_STRING && name == Length) {
+    op(bc, OP_LEN_S, {base, base});
+    return base;
+  }
+  string prefix = type_class(t) == T_STRING ? "krut_str_"
+                  : type_class(t) == T_LIST ? "krut_list_"
+                  : type_class(t) == T_DICT ? "krut_dict_"
+                                            : "krut_set_";
+
+  const FormalList &formals = m->get_formal_list();
+  for (size_t i = 0; i < formals.size(); i++) {
+    arg(bc, d->get_args()[i], formals[i]->get_type());
+  }
+  if (name == Front || name == Back || name == Pop_Front ||
+      name == Pop_Back || name == Get) {
+    const_arg(bc, d->lineno); /* fails when empty, or on a missing key */
+  }
+  return narrow(bc, call_native(bc, prefix + name, base), m->get_ret_type());
+}
+
+int DispatchExpr::compile(BcCompiler &bc) {
+  if (!method) return load_const(bc, 0);
+
+  const FormalList &formals = method->get_formal_list();
+  int base = bc.top;
+  if (!calling_expr) {
+    if (method->is_builtin()) return compile_builtin(bc, this);
+    BcMethod *callee = bc.module.global_methods[method];
+    for (size_t i = 0; i < formals.size(); i++) {
+      arg(bc, args[i], formals[i]->get_type());
+    }
+    if (bc.top == base) temp(bc);
+    op(bc, OP_CALL, {base, method_index(bc, callee), base});
+    bc.top = base + 1;
+    bc.method->callees.push_back(callee);
+    return base;
+  }
+
+  Type_ *t = calling_expr->get_type();
+  switch (type_class(t)) {
+    case T_STRING:
+    case T_LIST:
+    case T_SET:
+    case T_DICT:
+      arg(bc, calling_expr, NULL);
+      return compile_container_call(bc, this, t, base);
+    case T_CLASS:
+      arg(bc, calling_expr, NULL);
+      for (size_t i = 0; i < formals.size(); i++) {
+        arg(bc, args[i], formals[i]->get_type());
+      }
+      op(bc, OP_CALL_VIRTUAL,
+         {base, bc.vtable_slots.at(intern(method->get_name())), base, lineno});
+      bc.top = base + 1;
+      /* the JIT does not share objects with the interpreter */
+      bc.method->tierable = false;
+      return narrow(bc, base, method->get_ret_type());
+    default:
+      emit(bc, calling_expr, NULL);
+      return unsupported(bc, lineno, "`" + t->to_str() + "` has no methods");
+  }
+}
+
+/* see emit_arith() */
+static int compile_arith(BcCompiler &bc, char o, int a, int b, Type_ *t,
+                         int lineno) {
+  int base = bc.top;
+  switch (type_class(t)) {
+    case T_INT:
+    case T_CHAR:
+    case T_BOOL: {
+      if (o == '/') {
+        int d = dest(bc, a, b);
+        op(bc, OP_DIV_I, {d, a, b, lineno});
+        return narrow(bc, d, t);
+      }
+      Opcode code = o == '+' ? OP_ADD_I : o == '-' ? OP_SUB_I : OP_MUL_I;
+      return narrow(bc, binary(bc, code, a, b), t);
+    }
+    case T_DECI: {
+      Opcode code = o == '+'   ? OP_ADD_D
+                    : o == '-' ? OP_SUB_D
+                    : o == '*' ? OP_MUL_D
+                               : OP_DIV_D;
+      return binary(bc, code, a, b);
+    }
+    case T_STRING:
+      if (o == '+') return binary(bc, OP_CONCAT_S, a, b);
+      break;
+    case T_LIST:
+      if (o != '+') break;
+      arg(bc, a);
+      arg(bc, b);
+      return call_native(bc, "krut_list_concat", base);
+    case T_SET:
+      if (o != '+' && o != '-') break;
+      arg(bc, a);
+      arg(bc, b);
+      return call_native(
+          bc, o == '+' ? "krut_set_union" : "krut_set_difference", base);
+    default:
+      break;
+  }
+  return unsupported(bc, lineno, string("operator `") + o +
+                                     "` is not defined on `" + t->to_str() +
+                                     "`");
+}
+
+/* true if O with right side RHS is an int A + I or A - I, for an
+   immediate I, which is then what to add */
+static bool adds_imm(char o, Type_ *t, ExprStmt *rhs, int32_t &imm) {
+  if ((o != '+' && o != '-') || type_class(t) != T_INT) return false;
+  if (!immediate(rhs, imm) || imm == INT32_MIN) return false;
+  if (o == '-') imm = -imm;
+  return true;
+}
+
+static int add_imm(BcCompiler &bc, int a, int32_t imm) {
+  int d = dest(bc, a);
+  op(bc, OP_ADD_IK, {d, a, imm});
+  return d;
+}
+
+/* see emit_compare() */
+static int compile_compare(BcCompiler &bc, const string &o, int a, int b,
+                           Type_ *t, int lineno) {
+  bool eq = o == Equal, ne = o == NotEqual;
+  /* the order of OP_EQ_I .. OP_GE_I, and of the deci and string forms */
+  int index = eq                 ? 0
+              : ne               ? 1
+              : o == LessThan    ? 2
+              : o == LEQ         ? 3
+              : o == GreaterThan ? 4
+                                 : 5;
+  int base = bc.top;
+  switch (type_class(t)) {
+    case T_DECI:
+      return binary(bc, (Opcode)(OP_EQ_D + index), a, b);
+    case T_STRING:
+      return binary(bc, (Opcode)(OP_EQ_S + index), a, b);
+    case T_LIST:
+    case T_SET:
+    case T_DICT:
+      if (eq || ne) {
+        arg(bc, a);
+        arg(bc, b);
+        int d = call_native(bc,
+                            type_class(t) == T_LIST  ? "krut_list_eq"
+                            : type_class(t) == T_SET ? "krut_set_eq"
+                                                     : "krut_dict_eq",
+                            base);
+        return ne ? unary(bc, OP_NOT, d) : d;
+      }
+      return unsupported(bc, lineno, "operator `" + o +
+                                         "` is not defined on `" +
+                                         t->to_str() + "`");
+    case T_CLASS:
+      if (eq || ne) break;
+      return unsupported(bc, lineno, "operator `" + o +
+                                         "` is not defined on `" +
+                                         t->to_str() + "`");
+    default:
+      break;
+  }
+  return binary(bc, (Opcode)(OP_EQ_I + index), a, b);
+}
+
+/* the left side of an assignment: a variable, or an element of a list or
+   string, whose container and index are in registers */
+struct BcLValue {
+  Type_ *type = NULL;
+  BcVar *var = NULL;
+  Symbol sym;
+  int container = -1;
+  int index = -1;
+  bool is_string = false;
+};
+
+/* RHS is evaluated after the left side, and may change what it read */
+static bool compile_lvalue(BcCompiler &bc, ExprStmt *e, ExprStmt *rhs,
+                           BcLValue &lv) {
+  if (e->get_stmttype() == OBJECTID_EXPR) {
+    ObjectIdExpr *id = static_cast<ObjectIdExpr *>(e);
+    lv.var = lookup_var(bc, id->get_sym());
+    lv.sym = id->get_sym();
+    if (!lv.var) return false;
+    if (lv.var->kind == BcVar::FIELD && field_slot(bc, lv.sym) < 0) {
+      return false;
+    }
+    lv.type = lv.var->type;
+    return true;
+  }
+  if (e->get_stmttype() == LIST_ELEM_REF) {
+    ListElemRef *ref = static_cast<ListElemRef *>(e);
+    Type_ *t = ref->get_list_name()->get_type();
+    if (type_class(t) != T_STRING && type_class(t) != T_LIST) return false;
+    lv.container = emit(bc, ref->get_list_name(), NULL);
+    lv.container = keep(bc, keep(bc, lv.container, ref->get_index()), rhs);
+    lv.index = keep(bc, emit(bc, ref->get_index(), NULL), rhs);
+    lv.is_string = type_class(t) == T_STRING;
+    lv.type = lv.is_string ? e->get_type() : t->get_nested_type();
+    return true;
+  }
+  return false;
+}
+
+static int load_lvalue(BcCompiler &bc, BcLValue &lv, int lineno) {
+  if (lv.var) return load_var(bc, *lv.var, lv.sym);
+  if (lv.is_string) {
+    int d = temp(bc);
+    op(bc, OP_GET_S, {d, lv.container, lv.index, lineno});
+    return d;
+  }
+  int base = bc.top;
+  arg(bc, lv.container);
+  arg(bc, lv.index);
+  const_arg(bc, lineno);
+  return narrow(bc, call_native(bc, "krut_list_get", base), lv.type);
+}
+
+/* stores register V; returns the register that holds the value after */
+static int store_lvalue(BcCompiler &bc, BcLValue &lv, int v, int lineno) {
+  if (lv.var) return store_var(bc, *lv.var, lv.sym, v);
+  int base = bc.top;
+  arg(bc, lv.container);
+  arg(bc, lv.index);
+  arg(bc, v);
+  const_arg(bc, lineno);
+  call_native(bc, lv.is_string ? "krut_str_set" : "krut_list_set", base);
+  return v;
+}
+
+/* =, +=, -=, *= and /=; the value is the one assigned */
+static int compile_assign(BcCompiler &bc, BinopExpr *e) {
+  ExprStmt *lhs = e->get_lhs(), *rhs = e->get_rhs();
+  const string &o = e->get_op();
+  BcLValue lv;
+  if (!compile_lvalue(bc, lhs, rhs, lv)) {
+    /* the typechecker allows assigning to a value; it has no effect */
+    return emit(bc, rhs, NULL);
+  }
+
+  int v;
+  Type_ *rt = rhs->get_type();
+  if (o == Define) {
+    v = emit(bc, rhs, lv.type);
+  } else {
+    Type_ *t = operand_type(lv.type, rt);
+    int cur = convert(bc, load_lvalue(bc, lv, e->lineno), lv.type, t);
+    int32_t imm;
+    if (adds_imm(o[0], t, rhs, imm)) {
+      v = add_imm(bc, cur, imm);
+    } else {
+      cur = keep(bc, cur, rhs);
+      v = compile_arith(bc, o[0], cur, emit(bc, rhs, t), t, e->lineno);
+    }
+    v = convert(bc, v, t, lv.type);
+  }
+  v = store_lvalue(bc, lv, v, e->lineno);
+  return convert(bc, v, lv.type, result_type(lv.type, rt));
+}
+
+/* && and ||, which skip their right side when the left decides */
+static int compile_logical(BcCompiler &bc, BinopExpr *e) {
+  bool is_and = e->get_op() == And;
+  int l = to_bool(bc, emit(bc, e->get_lhs(), NULL), e->get_lhs()->get_type());
+  int d = dest(bc, l);
+  move_reg(bc, d, l);
+  int to_end = jump(bc, is_and ? OP_JUMP_IF_FALSE : OP_JUMP_IF_TRUE, {d});
+  int r = to_bool(bc, emit(bc, e->get_rhs(), NULL), e->get_rhs()->get_type());
+  move_reg(bc, d, r);
+  patch(bc, to_end);
+  bc.top = d + 1;
+  return d;
+}
+
+int BinopExpr::compile(BcCompiler &bc) {
+  if (op == And || op == Or) return compile_logical(bc, this);
+  if (is_assign(op)) return compile_assign(bc, this);
+
+  Type_ *lt = lhs->get_type(), *rt = rhs->get_type();
+  Type_ *t = operand_type(lt, rt);
+  bool arith = op == Plus || op == Minus || op == Times || op == Divide;
+  int a = emit(bc, lhs, t);
+  int32_t imm;
+  if (arith && adds_imm(op[0], t, rhs, imm)) {
+    return convert(bc, add_imm(bc, a, imm), t, result_type(lt, rt));
+  }
+  a = keep(bc, a, rhs);
+  int b = emit(bc, rhs, t);
+  if (arith) {
+    return convert(bc, compile_arith(bc, op[0], a, b, t, lineno), t,
+                   result_type(lt, rt));
+  }
+  return compile_compare(bc, op, a, b, t, lineno);
+}
+
+int NewExpr::compile(BcCompiler &bc) {
+  auto it = bc.classes.find(newclass);
+  if (it != bc.classes.end()) {
+    int base = temp(bc);
+    op(bc, OP_NEW, {base, it->second->id, base});
+    bc.method->tierable = false;
+    return base;
+  }
+  /* new on a builtin type: its default value */
+  return get_type() ? default_value(bc, get_type()) : load_const(bc, 0);
+}
@@ -1,26 +1,1050 @@
-
 #include "codegen.h"
 
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
 
-#include "llvm/IR/Value.h"
+#include "codegencontext.h"
+#include "constants.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/raw_ostream.h"
+#include "lowering.h"
+#include "runtime.h"
 #include "tree.h"
 
 using namespace std;
 using namespace llvm;
+using namespace basic_classes;
+using namespace lexing;
+using namespace typechecking;
+
+/*
+  How a KrutC type is represented:
+    int -> i64, deci -> double, bool -> i1, char -> i8, void -> void
+    object -> i64, a slot holding the bits of any other type
+    string, list<T>, set<T>, class instances -> i8*, see runtime.h
+  Class methods all take and return slots (this, then one i64 per formal),
+  so an override is called the same way as the method it overrides.
+*/
+static Type *llvm_type(CodeGenContext &cg, Type_ *t) {
+  switch (type_class(t)) {
+    case T_VOID:
+      return cg.builder.getVoidTy();
+    case T_INT:
+    case T_OBJECT:
+      return cg.builder.getInt64Ty();
+    case T_DECI:
+      return cg.builder.getDoubleTy();
+    case T_BOOL:
+      return cg.builder.getInt1Ty();
+    case T_CHAR:
+      return cg.builder.getInt8Ty();
+    default:
+      return cg.builder.getInt8PtrTy();
+  }
+}
+
+//////////////////////////////////////////////////////////////
+//
+// The runtime library
+//
+//////////////////////////////////////////////////////////////
+
+/* runtime.h as LLVM sees it: the return type, then the argument types.
+   v void, l int64_t, i int, p any pointer */
+static const unordered_map<string, const char *> RUNTIME_SIGS = {
+    {"krut_init", "vpip"},
+    {"krut_args", "p"},
+    {"krut_div_by_zero", "vl"},
+    {"krut_null_dispatch", "vl"},
+    {"krut_unsupported", "vlp"},
+    {"krut_alloc", "pl"},
+    {"krut_class_name", "pp"},
+    {"krut_str_new", "ppl"},
+    {"krut_str_concat", "ppp"},
+    {"krut_str_eq", "lpp"},
+    {"krut_str_cmp", "lpp"},
+    {"krut_str_length", "lp"},
+    {"krut_str_clear", "vp"},
+    {"krut_str_is_empty", "lp"},
+    {"krut_str_front", "lpl"},
+    {"krut_str_back", "lpl"},
+    {"krut_str_get", "lpll"},
+    {"krut_str_set", "vplll"},
+    {"krut_str_slice", "pplll"},
+    {"krut_list_new", "pll"},
+    {"krut_list_length", "lp"},
+    {"krut_list_clear", "vp"},
+    {"krut_list_is_empty", "lp"},
+    {"krut_list_push_back", "vpl"},
+    {"krut_list_push_front", "vpl"},
+    {"krut_list_pop_back", "vpl"},
+    {"krut_list_pop_front", "vpl"},
+    {"krut_list_front", "lpl"},
+    {"krut_list_back", "lpl"},
+    {"krut_list_contains", "lpl"},
+    {"krut_list_get", "lpll"},
+    {"krut_list_set", "vplll"},
+    {"krut_list_slice", "pplll"},
+    {"krut_list_concat", "ppp"},
+    {"krut_list_eq", "lpp"},
+    {"krut_set_new", "pl"},
+    {"krut_set_length", "lp"},
+    {"krut_set_clear", "vp"},
+    {"krut_set_is_empty", "lp"},
+    {"krut_set_insert", "vpl"},
+    {"krut_set_remove", "lpl"},
+    {"krut_set_contains", "lpl"},
+    {"krut_set_union", "ppp"},
+    {"krut_set_difference", "ppp"},
+    {"krut_set_eq", "lpp"},
+    {"krut_dict_new", "pll"},
+    {"krut_dict_length", "lp"},
+    {"krut_dict_clear", "vp"},
+    {"krut_dict_is_empty", "lp"},
+    {"krut_dict_get", "lpll"},
+    {"krut_dict_insert", "vpll"},
+    {"krut_dict_remove", "lpl"},
+    {"krut_dict_contains", "lpl"},
+    {"krut_dict_keys", "pp"},
+    {"krut_dict_values", "pp"},
+    {"krut_dict_eq", "lpp"},
+    {"krut_print", "vp"},
+    {"krut_input", "pp"},
+    {"krut_to_string", "pl"},
+    {"krut_sum", "lp"},
+    {"krut_min", "lpl"},
+    {"krut_max", "lpl"},
+    {"krut_kill", "vp"},
+};
+
+static bool runtime_noreturn(const string &name) {
+  return name == "krut_div_by_zero" || name == "krut_null_dispatch" ||
+         name == "krut_unsupported" || name == "krut_kill";
+}
+
+static Type *sig_type(CodeGenContext &cg, char c) {
+  switch (c) {
+    case 'v':
+      return cg.builder.getVoidTy();
+    case 'l':
+      return cg.builder.getInt64Ty();
+    case 'i':
+      return cg.builder.getInt32Ty();
+    default:
+      return cg.builder.getInt8PtrTy();
+  }
+}
+
+static Function *runtime_fn(CodeGenContext &cg, const string &name) {
+  Function *f = cg.module.getFunction(name);
+  if (f) return f;
+
+  const char *sig = RUNTIME_SIGS.at(name);
+  vector<Type *> params;
+  for (const char *c = sig + 1; *c; c++) {
+    params.push_back(sig_type(cg, *c));
+  }
+  FunctionType *ft = FunctionType::get(sig_type(cg, sig[0]), params, false);
+  f = Function::Create(ft, Function::ExternalLinkage, name, cg.module);
+  if (runtime_noreturn(name)) f->setDoesNotReturn();
+  return f;
+}
+
+/* calls runtime function NAME; pointer arguments are cast to i8* */
+static Value *call_rt(CodeGenContext &cg, const string &name,
+                      vector<Value *> args) {
+  Function *f = runtime_fn(cg, name);
+  for (size_t i = 0; i < args.size(); i++) {
+    Type *param = f->getFunctionType()->getParamType(i);
+    if (args[i]->getType() != param && param->isPointerTy()) {
+      args[i] = cg.builder.CreateBitCast(args[i], param);
+    }
+  }
+  return cg.builder.CreateCall(f, args);
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Blocks
+//
+//////////////////////////////////////////////////////////////
+
+static BasicBlock *new_block(CodeGenContext &cg, const string &name) {
+  return BasicBlock::Create(cg.llvm, name, cg.func);
+}
+
+static bool terminated(CodeGenContext &cg) {
+  return cg.builder.GetInsertBlock()->getTerminator() != NULL;
+}
+
+/* code after a return, break, continue or kill() goes in a block of its
+   own, which nothing branches to */
+static void dead_block(CodeGenContext &cg) {
+  cg.builder.SetInsertPoint(new_block(cg, "dead"));
+}
+
+/* a call into the runtime that never returns */
+static void call_noreturn(CodeGenContext &cg, const string &name,
+                          vector<Value *> args) {
+  call_rt(cg, name, move(args));
+  cg.builder.CreateUnreachable();
+  dead_block(cg);
+}
+
+/* a pointer to the first char of a NUL-terminated copy of S */
+static Constant *c_string(CodeGenContext &cg, const string &s) {
+  GlobalVariable *&g = cg.str_consts[s];
+  if (!g) g = cg.builder.CreateGlobalString(s, "str", 0, &cg.module);
+  Constant *zero = cg.builder.getInt32(0);
+  return ConstantExpr::getInBoundsGetElementPtr(g->getValueType(), g,
+                                                ArrayRef<Constant *>{zero,
+                                                                     zero});
+}
+
+static Value *line_of(CodeGenContext &cg, int lineno) {
+  return cg.builder.getInt64(lineno);
+}
+
+static void unsupported(CodeGenContext &cg, int lineno, const string &what) {
+  call_noreturn(cg, "krut_unsupported",
+                {line_of(cg, lineno), c_string(cg, what)});
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Values
+//
+//////////////////////////////////////////////////////////////
+
+static Value *to_slot(CodeGenContext &cg, Value *v) {
+  IRBuilder<> &b = cg.builder;
+  Type *t = v->getType();
+  if (t->isIntegerTy(64)) return v;
+  if (t->isDoubleTy()) return b.CreateBitCast(v, b.getInt64Ty());
+  if (t->isIntegerTy()) return b.CreateZExt(v, b.getInt64Ty());
+  if (t->isPointerTy()) return b.CreatePtrToInt(v, b.getInt64Ty());
+  return b.getInt64(0);
+}
+
+/* the value of type T whose bits slot V holds; NULL if T is void */
+static Value *from_slot(CodeGenContext &cg, Value *v, Type_ *t) {
+  IRBuilder<> &b = cg.builder;
+  Type *lt = llvm_type(cg, t);
+  if (lt->isVoidTy()) return NULL;
+  if (lt->isIntegerTy(64)) return v;
+  if (lt->isDoubleTy()) return b.CreateBitCast(v, lt);
+  if (lt->isIntegerTy()) return b.CreateTrunc(v, lt);
+  return b.CreateIntToPtr(v, lt);
+}
+
+static Value *zero_value(CodeGenContext &cg, Type_ *t) {
+  Type *lt = llvm_type(cg, t);
+  return lt->isVoidTy() ? NULL : Constant::getNullValue(lt);
+}
+
+static Value *new_string(CodeGenContext &cg, const string &s) {
+  return call_rt(cg, "krut_str_new",
+                 {c_string(cg, s), cg.builder.getInt64(s.size())});
+}
+
+/* the value of a variable of type T that is declared without one */
+static Value *default_value(CodeGenContext &cg, Type_ *t) {
+  switch (type_class(t)) {
+    case T_STRING:
+      return new_string(cg, "");
+    case T_LIST:
+      return call_rt(cg, "krut_list_new",
+                     {cg.builder.getInt64(elem_kind(t->get_nested_type())),
+                      cg.builder.getInt64(0)});
+    case T_SET:
+      return call_rt(cg, "krut_set_new",
+                     {cg.builder.getInt64(elem_kind(t->get_nested_type()))});
+    case T_DICT:
+      return call_rt(cg, "krut_dict_new",
+                     {cg.builder.getInt64(elem_kind(t->get_nested_type())),
+                      cg.builder.getInt64(elem_kind(t->get_value_type()))});
+    default:
+      return zero_value(cg, t);
+  }
+}
+
+/* converts V, of type FROM, to type TO (the typechecker has checked that
+   one conforms to the other, or that they are int and deci) */
+static Value *convert(CodeGenContext &cg, Value *v, Type_ *from, Type_ *to) {
+  IRBuilder<> &b = cg.builder;
+  if (!to || type_class(to) == T_VOID) return v;
+  if (!v) return zero_value(cg, to);
+  Type *lt = llvm_type(cg, to);
+  Type *vt = v->getType();
+  if (vt == lt) return v;
+  if (type_class(to) == T_OBJECT) return to_slot(cg, v);
+  if (from && type_class(from) == T_OBJECT) return from_slot(cg, v, to);
+  if (vt->isIntegerTy() && lt->isDoubleTy()) return b.CreateSIToFP(v, lt);
+  if (vt->isDoubleTy() && lt->isIntegerTy()) return b.CreateFPToSI(v, lt);
+  if (vt->isPointerTy() && lt->isPointerTy()) return b.CreateBitCast(v, lt);
+  return from_slot(cg, to_slot(cg, v), to);
+}
+
+static Value *to_bool(CodeGenContext &cg, Value *v) {
+  IRBuilder<> &b = cg.builder;
+  if (!v) return b.getFalse();
+  Type *t = v->getType();
+  if (t->isIntegerTy(1)) return v;
+  if (t->isIntegerTy()) return b.CreateICmpNE(v, ConstantInt::get(t, 0));
+  if (t->isDoubleTy()) return b.CreateFCmpUNE(v, ConstantFP::get(t, 0.0));
+  return b.CreateIsNotNull(v);
+}
+
+/* emits E, then converts its value to type WANT (NULL: as it is) */
+static Value *emit(CodeGenContext &cg, ExprStmt *e, Type_ *want) {
+  Type_ *saved = cg.expected_type;
+  cg.expected_type = want;
+  Value *v = e->codegen(cg);
+  cg.expected_type = saved;
+  return convert(cg, v, e->get_type(), want);
+}
+
+static void emit_stmts(CodeGenContext &cg, const StmtList &stmts) {
+  for (Stmt *s : stmts) {
+    cg.expected_type = NULL;
+    s->codegen(cg);
+  }
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Lists
+//
+//////////////////////////////////////////////////////////////
+
+/* true if every list of type T stores its elements the same way, so
+   generated code can read and write them itself; a list<object> can be
+   any list */
+static bool flat_list(Type_ *t) {
+  return type_class(t) == T_LIST &&
+         type_class(t->get_nested_type()) != T_OBJECT;
+}
+
+/* how a flat list stores an element of type ELEM: see elem_kind() */
+static Type *stored_type(CodeGenContext &cg, Type_ *elem) {
+  Type *lt = llvm_type(cg, elem);
+  return lt->isIntegerTy(1) ? cg.builder.getInt8Ty() : lt;
+}
+
+/* the address of field N (len, cap, data) of the KrutList L */
+static Value *list_field(CodeGenContext &cg, Value *l, unsigned n) {
+  IRBuilder<> &b = cg.builder;
+  if (!cg.list_type) {
+    Type *i64 = b.getInt64Ty();
+    cg.list_type = StructType::create(
+        cg.llvm, {i64, i64, b.getInt8PtrTy(), i64, i64}, "KrutList");
+  }
+  l = b.CreateBitCast(l, cg.list_type->getPointerTo());
+  return b.CreateStructGEP(cg.list_type, l, n);
+}
+
+static Value *list_length(CodeGenContext &cg, Value *l) {
+  return cg.builder.CreateLoad(cg.builder.getInt64Ty(), list_field(cg, l, 0),
+                               "len");
+}
+
+/* the address of element I of L, a flat list of ELEMs */
+static Value *list_data(CodeGenContext &cg, Value *l, Value *i, Type_ *elem) {
+  IRBuilder<> &b = cg.builder;
+  Type *st = stored_type(cg, elem);
+  Value *data = b.CreateLoad(b.getInt8PtrTy(), list_field(cg, l, 2));
+  data = b.CreateBitCast(data, st->getPointerTo());
+  return b.CreateInBoundsGEP(st, data, i);
+}
+
+/* the same, once I is checked against the length; out of range, the
+   runtime reports it as krut_list_get() would */
+static Value *list_elem(CodeGenContext &cg, Value *l, Value *i, Type_ *elem,
+                        int lineno) {
+  IRBuilder<> &b = cg.builder;
+  BasicBlock *out_bb = new_block(cg, "index.out");
+  BasicBlock *in_bb = new_block(cg, "index");
+  b.CreateCondBr(b.CreateICmpUGE(i, list_length(cg, l)), out_bb, in_bb);
+  b.SetInsertPoint(out_bb);
+  call_rt(cg, "krut_list_get", {l, i, line_of(cg, lineno)});
+  b.CreateUnreachable();
+  b.SetInsertPoint(in_bb);
+  return list_data(cg, l, i, elem);
+}
+
+static Value *load_elem(CodeGenContext &cg, Value *ptr, Type_ *elem) {
+  IRBuilder<> &b = cg.builder;
+  Value *v = b.CreateLoad(stored_type(cg, elem), ptr);
+  Type *lt = llvm_type(cg, elem);
+  return v->getType() == lt ? v : b.CreateTrunc(v, lt);
+}
+
+static void store_elem(CodeGenContext &cg, Value *ptr, Value *v,
+                       Type_ *elem) {
+  IRBuilder<> &b = cg.builder;
+  Type *st = stored_type(cg, elem);
+  b.CreateStore(v->getType() == st ? v : b.CreateZExt(v, st), ptr);
+}
+
+/* L.push_back(V) on a flat list: a store while there is room, else the
+   runtime grows it */
+static void list_push_back(CodeGenContext &cg, Value *l, Value *v,
+                           Type_ *elem) {
+  IRBuilder<> &b = cg.builder;
+  Value *len = list_length(cg, l);
+  Value *cap = b.CreateLoad(b.getInt64Ty(), list_field(cg, l, 1), "cap");
+  BasicBlock *store_bb = new_block(cg, "push.store");
+  BasicBlock *grow_bb = new_block(cg, "push.grow");
+  BasicBlock *done_bb = new_block(cg, "push.done");
+  b.CreateCondBr(b.CreateICmpSLT(len, cap), store_bb, grow_bb);
+  b.SetInsertPoint(store_bb);
+  store_elem(cg, list_data(cg, l, len, elem), v, elem);
+  b.CreateStore(b.CreateAdd(len, b.getInt64(1)), list_field(cg, l, 0));
+  b.CreateBr(done_bb);
+  b.SetInsertPoint(grow_bb);
+  call_rt(cg, "krut_list_push_back", {l, to_slot(cg, v)});
+  b.CreateBr(done_bb);
+  b.SetInsertPoint(done_bb);
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Variables
+//
+//////////////////////////////////////////////////////////////
+
+static Symbol intern(const string &name) {
+  return SymbolTable::global().intern(name);
+}
+
+static CodeGenVar *lookup_var(CodeGenContext &cg, Symbol name) {
+  for (auto it = cg.scopes.rbegin(); it != cg.scopes.rend(); ++it) {
+    auto v = it->find(name);
+    if (v != it->end()) return &v->second;
+  }
+  return NULL;
+}
+
+/* the address of VAR; a field is looked up in the layout of this_class */
+static Value *var_ptr(CodeGenContext &cg, CodeGenVar &var, Symbol name) {
+  if (var.kind != CodeGenVar::FIELD) return var.ptr;
+  CodeGenClass *cls = cg.this_class;
+  if (!cls) return NULL;
+  auto field = cls->field_index.find(name);
+  if (field == cls->field_index.end()) return NULL;
+  Value *obj = cg.builder.CreateBitCast(cg.this_ptr, cls->type->getPointerTo());
+  return cg.builder.CreateStructGEP(cls->type, obj, field->second);
+}
+
+/* storage for a new variable: a local in a method, else a global */
+static CodeGenVar new_var(CodeGenContext &cg, Type_ *type,
+                          const string &name) {
+  Type *lt = llvm_type(cg, type);
+  if (cg.curr_method) {
+    BasicBlock &entry = cg.func->getEntryBlock();
+    IRBuilder<> b(&entry, entry.begin());
+    return {CodeGenVar::LOCAL, b.CreateAlloca(lt, NULL, name), type};
+  }
+  GlobalVariable *g =
+      new GlobalVariable(cg.module, lt, false, GlobalValue::InternalLinkage,
+                         Constant::getNullValue(lt), name);
+  return {CodeGenVar::GLOBAL, g, type};
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Functions
+//
+//////////////////////////////////////////////////////////////
+
+/* the type of every class method with NUM_FORMALS formals */
+static FunctionType *class_method_type(CodeGenContext &cg,
+                                       size_t num_formals) {
+  vector<Type *> params(num_formals + 1, cg.builder.getInt64Ty());
+  params[0] = cg.builder.getInt8PtrTy();
+  return FunctionType::get(cg.builder.getInt64Ty(), params, false);
+}
+
+static FunctionType *global_method_type(CodeGenContext &cg, MethodStmt *m) {
+  vector<Type *> params;
+  for (FormalStmt *f : m->get_formal_list()) {
+    params.push_back(llvm_type(cg, f->get_type()));
+  }
+  return FunctionType::get(llvm_type(cg, m->get_ret_type()), params, false);
+}
+
+/*
+  Saves the state of the function being emitted and restores it on
+  destruction, so a function can be emitted in the middle of another (a
+  method is emitted where it is defined, which is usually inside main).
+*/
+struct SavedFunction {
+  CodeGenContext &cg;
+  IRBuilderBase::InsertPoint ip;
+  Function *func;
+  MethodStmt *curr_method;
+  CodeGenClass *this_class;
+  Value *this_ptr;
+  vector<CodeGenLoop> loops;
+
+  SavedFunction(CodeGenContext &cg)
+      : cg(cg),
+        ip(cg.builder.saveIP()),
+        func(cg.func),
+        curr_method(cg.curr_method),
+        this_class(cg.this_class),
+        this_ptr(cg.this_ptr),
+        loops(move(cg.loops)) {
+    cg.loops.clear();
+  }
+
+  ~SavedFunction() {
+    cg.builder.restoreIP(ip);
+    cg.func = func;
+    cg.curr_method = curr_method;
+    cg.this_class = this_class;
+    cg.this_ptr = this_ptr;
+    cg.loops = move(loops);
+  }
+};
+
+/* returns V (already of the method's return type, or NULL) */
+static void emit_return(CodeGenContext &cg, Value *v) {
+  IRBuilder<> &b = cg.builder;
+  if (cg.this_class) {
+    b.CreateRet(v ? to_slot(cg, v) : b.getInt64(0));
+    return;
+  }
+  Type_ *ret_type = cg.curr_method->get_ret_type();
+  if (type_class(ret_type) == T_VOID) {
+    b.CreateRetVoid();
+  } else {
+    b.CreateRet(v ? v : zero_value(cg, ret_type));
+  }
+}
+
+/* emits the body of method M as function F. If CLS is set, M is a method
+   of class CLS (or inherited by it) and its fields are read with CLS's
+   layout */
+static void emit_method_body(CodeGenContext &cg, MethodStmt *m,
+                             CodeGenClass *cls, Function *f) {
+  SavedFunction saved(cg);
+  cg.func = f;
+  cg.curr_method = m;
+  cg.this_class = cls;
+  cg.builder.SetInsertPoint(BasicBlock::Create(cg.llvm, "entry", f));
+  cg.scopes.emplace_back();
+
+  Function::arg_iterator arg = f->arg_begin();
+  if (cls) cg.this_ptr = &*arg++;
+  for (FormalStmt *formal : m->get_formal_list()) {
+    Value *v = &*arg++;
+    if (cls) v = from_slot(cg, v, formal->get_type());
+    CodeGenVar var = new_var(cg, formal->get_type(), formal->get_name());
+    cg.builder.CreateStore(v, var.ptr);
+    cg.scopes.back()[intern(formal->get_name())] = var;
+  }
+
+  emit_stmts(cg, m->get_stmt_list());
+  if (!terminated(cg)) emit_return(cg, NULL);
+  cg.scopes.pop_back();
+}
+
+/* CLS.init(this): sets every attribute, inherited ones included, to its
+   initializer or default value */
+static void emit_class_init(CodeGenContext &cg, CodeGenClass &cls) {
+  SavedFunction saved(cg);
+  cg.func = cls.init;
+  cg.curr_method = NULL;
+  cg.this_class = &cls;
+  cg.this_ptr = &*cls.init->arg_begin();
+  cg.builder.SetInsertPoint(BasicBlock::Create(cg.llvm, "entry", cls.init));
+
+  /* an initializer sees the attributes before it */
+  cg.scopes.emplace_back();
+  for (const AttrTable::Entry &e : cls.attrs->get_entries()) {
+    AttrStmt *a = e.feature;
+    Value *v = a->get_init() ? emit(cg, a->get_init(), a->get_type())
+                             : default_value(cg, a->get_type());
+    CodeGenVar var = {CodeGenVar::FIELD, NULL, a->get_type()};
+    cg.builder.CreateStore(v, var_ptr(cg, var, e.name));
+    cg.scopes.back()[e.name] = var;
+  }
+  cg.scopes.pop_back();
+  cg.builder.CreateRetVoid();
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Module
+//
+//////////////////////////////////////////////////////////////
+
+/* true if A's fields are the first fields of B, at the same offsets */
+static bool is_prefix(const CodeGenClass &a, const CodeGenClass &b) {
+  if (a.fields.size() > b.fields.size()) return false;
+  return equal(a.fields.begin(), a.fields.end(), b.fields.begin());
+}
+
+/* the bytes a field of type T takes, which is also its alignment */
+static uint64_t field_size(Type *t) {
+  if (t->isPointerTy()) return 8;
+  return (t->getPrimitiveSizeInBits() + 7) / 8;
+}
+
+/* sets CLS's fields: its first parent's, laid out first, then the others
+   by decreasing size */
+static void lay_out(CodeGenContext &cg, CodeGenClass &cls) {
+  if (cls.type->isSized()) return;
+  vector<Symbol> fields;
+  const vector<string> &parents = cls.stmt->get_parents();
+  if (!parents.empty() && cg.classes.count(parents[0])) {
+    CodeGenClass &parent = cg.classes.at(parents[0]);
+    lay_out(cg, parent);
+    fields = parent.fields;
+  }
+  size_t inherited = fields.size();
+  for (const AttrTable::Entry &e : cls.attrs->get_entries()) {
+    if (find(fields.begin(), fields.begin() + inherited, e.name) ==
+        fields.begin() + inherited) {
+      fields.push_back(e.name);
+    }
+  }
+  auto size_of = [&](Symbol name) {
+    return field_size(llvm_type(cg, cls.attrs->lookup(name)->feature
+                                         ->get_type()));
+  };
+  stable_sort(fields.begin() + inherited, fields.end(),
+              [&](Symbol a, Symbol b) { return size_of(a) > size_of(b); });
+
+  vector<Type *> types = {cg.builder.getInt8PtrTy()}; /* the vtable */
+  for (Symbol name : fields) {
+    cls.field_index[name] = types.size();
+    types.push_back(llvm_type(cg, cls.attrs->lookup(name)->feature
+                                      ->get_type()));
+  }
+  cls.fields = move(fields);
+  cls.type->setBody(types);
+}
+
+void CodeGen::declare_classes(CodeGenContext &cg) {
+  int id = 0;
+  for (Stmt *s : program) {
+    ClassStmt *cs = dynamic_cast<ClassStmt *>(s);
+    if (!cs) continue;
+    const string &name = cs->get_name();
+    CodeGenClass &cls = cg.classes[name];
+    cls.id = id++;
+    cls.stmt = cs;
+    cls.methods = typechecker.get_method_table(name);
+    cls.attrs = typechecker.get_attr_table(name);
+    cls.type = StructType::create(*llvm, name);
+  }
+
+  vector<string> order(cg.classes.size());
+  for (auto &entry : cg.classes) {
+    lay_out(cg, entry.second);
+    order[entry.second.id] = entry.first;
+  }
+  cg.vtable_slots = vtable_slots(typechecker, order);
+}
+
+void CodeGen::declare_methods(CodeGenContext &cg) {
+  for (Stmt *s : program) {
+    MethodStmt *m = dynamic_cast<MethodStmt *>(s);
+    if (!m) continue;
+    cg.global_methods[m] =
+        Function::Create(global_method_type(cg, m), Function::InternalLinkage,
+                         "krut." + m->get_name(), *module);
+  }
+
+  /* each class's own methods */
+  unordered_map<MethodStmt *, CodeGenClass *> owner;
+  for (auto &entry : cg.classes) {
+    CodeGenClass &cls = entry.second;
+    for (Feature *f : cls.stmt->get_feature_list()) {
+      if (!f->is_method()) continue;
+      MethodStmt *m = static_cast<MethodStmt *>(f);
+      Function *fn = Function::Create(
+          class_method_type(cg, m->get_formal_list().size()),
+          Function::InternalLinkage, entry.first + "." + m->get_name(),
+          *module);
+      cg.method_bodies[m].push_back({&cls, fn});
+      owner[m] = &cls;
+    }
+  }
+
+  /* fill each vtable: an inherited method is shared, unless its class's
+     fields are not where they are in the subclass, as for any parent but
+     the first; then the subclass gets a copy compiled with its own
+     layout */
+  for (auto &entry : cg.classes) {
+    CodeGenClass &cls = entry.second;
+    for (const MethodTable::Entry &e : cls.methods->get_entries()) {
+      MethodStmt *m = e.feature;
+      CodeGenClass *o = owner[m];
+      if (!is_prefix(*o, cls)) o = &cls;
+      Function *fn = NULL;
+      for (auto &body : cg.method_bodies[m]) {
+        if (body.first == o) fn = body.second;
+      }
+      if (!fn) {
+        fn = Function::Create(
+            class_method_type(cg, m->get_formal_list().size()),
+            Function::InternalLinkage, entry.first + "." + m->get_name(),
+            *module);
+        cg.method_bodies[m].push_back({&cls, fn});
+      }
+      int slot = cg.vtable_slots.at(e.name);
+      if (cls.slots.size() <= (size_t)slot) cls.slots.resize(slot + 1);
+      cls.slots[slot] = fn;
+    }
+
+    FunctionType *init_type = FunctionType::get(
+        cg.builder.getVoidTy(), {cg.builder.getInt8PtrTy()}, false);
+    cls.init = Function::Create(init_type, Function::InternalLinkage,
+                                entry.first + ".init", *module);
+    cls.make = Function::Create(
+        FunctionType::get(cg.builder.getInt8PtrTy(), false),
+        Function::InternalLinkage, entry.first + ".new", *module);
+  }
+}
+
+void CodeGen::build_vtables(CodeGenContext &cg) {
+  IRBuilder<> &b = cg.builder;
+  Type *i8p = b.getInt8PtrTy();
+
+  for (auto &entry : cg.classes) {
+    CodeGenClass &cls = entry.second;
+    ArrayType *type = ArrayType::get(i8p, 1 + cls.slots.size());
+    cls.vtable = new GlobalVariable(*module, type, true,
+                                    GlobalValue::InternalLinkage, NULL,
+                                    entry.first + ".vtable");
+  }
+
+  for (auto &entry : cg.classes) {
+    CodeGenClass &cls = entry.second;
+    ArrayType *vtable_type = cast<ArrayType>(cls.vtable->getValueType());
+    vector<Constant *> vtable = {c_string(cg, entry.first)};
+    for (Function *f : cls.slots) {
+      vtable.push_back(f ? ConstantExpr::getBitCast(f, i8p)
+                         : Constant::getNullValue(i8p));
+    }
+    cls.vtable->setInitializer(ConstantArray::get(vtable_type, vtable));
 
-int CodeGen::codegen() {}
+    /* CLS.new(): allocate, point at the vtable, initialize */
+    cg.func = cls.make;
+    b.SetInsertPoint(BasicBlock::Create(*llvm, "entry", cls.make));
+    Value *obj =
+        call_rt(cg, "krut_alloc", {ConstantExpr::getSizeOf(cls.type)});
+    Value *vptr = b.CreateBitCast(obj, i8p->getPointerTo()->getPointerTo());
+    b.CreateStore(ConstantExpr::getBitCast(cls.vtable, i8p->getPointerTo()),
+                  vptr);
+    b.CreateCall(cls.init, {obj});
+    b.CreateRet(obj);
+  }
+  cg.func = NULL;
+}
 
-Value *ExprStmt::codegen() {}
-Value *ClassStmt::codegen() {}
-Value *AttrStmt::codegen() {}
-Value *MethodStmt::codegen() {}
-Value *FormalStmt::codegen() {}
-Value *ForStmt::codegen() {}
-Value *IfStmt::codegen() {}
-Value *WhileStmt::codegen() {}
-Value *BreakStmt::codegen() {}
-Value *ContStmt::codegen() {}
+/* C main(argc, argv): the top-level statements, then the KrutC main */
+void CodeGen::emit_main(CodeGenContext &cg) {
+  IRBuilder<> &b = cg.builder;
+  FunctionType *main_type = FunctionType::get(
+      b.getInt32Ty(), {b.getInt32Ty(), b.getInt8PtrTy()->getPointerTo()},
+      false);
+  Function *main_fn =
+      Function::Create(main_type, Function::ExternalLinkage, "main", *module);
+  cg.func = main_fn;
+  b.SetInsertPoint(BasicBlock::Create(*llvm, "entry", main_fn));
+
+  Function::arg_iterator arg = main_fn->arg_begin();
+  Value *argc = &*arg++;
+  Value *argv = &*arg;
+  call_rt(cg, "krut_init", {c_string(cg, filename), argc, argv});
+
+  cg.scopes.emplace_back(); /* the globals */
+  emit_stmts(cg, program.get_stmt_list());
+
+  for (auto &entry : cg.global_methods) {
+    if (entry.first->get_name() != Main) continue;
+    Value *args = call_rt(cg, "krut_args", {});
+    b.CreateCall(entry.second, {args});
+  }
+  b.CreateRet(b.getInt32(0));
+  cg.scopes.pop_back();
+}
+
+int CodeGen::codegen() {
+  llvm = make_unique<LLVMContext>();
+  module = make_unique<Module>(filename, *llvm);
+  module->setTargetTriple(sys::getDefaultTargetTriple());
+
+  CodeGenContext cg(*llvm, *module, filename);
+  declare_classes(cg);
+  declare_methods(cg);
+  build_vtables(cg);
+  emit_main(cg);
+
+  if (verifyModule(*module, &errs())) {
+    errs() << filename << ": Codegen Error: module does not verify\n";
+    return 1;
+  }
+  return 0;
+}
+
+/* emits the bodies of the methods in cg.global_methods where they are
+   defined in STMTS, which are top-level statements; a variable declared
+   outside any method is bound to its slot in GLOBALS */
+static void emit_methods_in(CodeGenContext &cg, const StmtList &stmts,
+                            const unordered_map<AttrStmt *, void *> &globals) {
+  IRBuilder<> &b = cg.builder;
+  for (Stmt *s : stmts) {
+    switch (s->get_stmttype()) {
+      case ATTR_STMT: {
+        AttrStmt *a = static_cast<AttrStmt *>(s);
+        auto it = globals.find(a);
+        if (it == globals.end()) break;
+        Type *lt = llvm_type(cg, a->get_type())->getPointerTo();
+        Value *ptr = ConstantExpr::getIntToPtr(
+            b.getInt64((uint64_t)it->second), lt);
+        cg.scopes.back()[intern(a->get_name())] = {CodeGenVar::GLOBAL, ptr,
+                                                   a->get_type()};
+        break;
+      }
+      case METHOD_STMT:
+        s->codegen(cg);
+        break;
+      case IF_STMT:
+        emit_methods_in(cg, static_cast<IfStmt *>(s)->get_then(), globals);
+        emit_methods_in(cg, static_cast<IfStmt *>(s)->get_else(), globals);
+        break;
+      case WHILE_STMT:
+        emit_methods_in(cg, static_cast<WhileStmt *>(s)->get_stmt_list(),
+                        globals);
+        break;
+      case FOR_STMT: {
+        ForStmt *f = static_cast<ForStmt *>(s);
+        if (f->get_formal()) emit_methods_in(cg, {f->get_formal()}, globals);
+        emit_methods_in(cg, f->get_stmt_list(), globals);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+int CodeGen::codegen_methods(const vector<MethodStmt *> &methods,
+                             const unordered_map<AttrStmt *, void *> &globals,
+                             const string &prefix) {
+  llvm = make_unique<LLVMContext>();
+  module = make_unique<Module>(filename, *llvm);
+  module->setTargetTriple(sys::getDefaultTargetTriple());
+
+  CodeGenContext cg(*llvm, *module, filename);
+  IRBuilder<> &b = cg.builder;
+  for (MethodStmt *m : methods) {
+    cg.global_methods[m] =
+        Function::Create(global_method_type(cg, m), Function::InternalLinkage,
+                         "krut." + m->get_name(), *module);
+  }
+  cg.scopes.emplace_back(); /* the globals */
+  emit_methods_in(cg, program.get_stmt_list(), globals);
+  cg.scopes.pop_back();
+
+  Type *i64 = b.getInt64Ty();
+  FunctionType *entry_type =
+      FunctionType::get(i64, {i64->getPointerTo()}, false);
+  for (MethodStmt *m : methods) {
+    Function *f = Function::Create(entry_type, Function::ExternalLinkage,
+                                   prefix + m->get_name(), *module);
+    cg.func = f;
+    b.SetInsertPoint(BasicBlock::Create(*llvm, "entry", f));
+    vector<Value *> args;
+    const FormalList &formals = m->get_formal_list();
+    for (size_t i = 0; i < formals.size(); i++) {
+      Value *slot =
+          b.CreateLoad(i64, b.CreateConstGEP1_32(i64, &*f->arg_begin(), i));
+      args.push_back(from_slot(cg, slot, formals[i]->get_type()));
+    }
+    Value *r = b.CreateCall(cg.global_methods[m], args);
+    b.CreateRet(r->getType()->isVoidTy() ? b.getInt64(0) : to_slot(cg, r));
+  }
+  cg.func = NULL;
+
+  if (verifyModule(*module, &errs())) {
+    errs() << filename << ": Codegen Error: module does not verify\n";
+    return 1;
+  }
+  return 0;
+}
+
+bool CodeGen::write(const string &path) {
+  error_code ec;
+  raw_fd_ostream os(path, ec, sys::fs::OF_None);
+  if (ec) {
+    errs() << "Error: cannot write " << path << ": " << ec.message() << "\n";
+    return false;
+  }
+  if (path.size() >= 3 && path.compare(path.size() - 3, 3, ".bc") == 0) {
+    WriteBitcodeToFile(*module, os);
+  } else {
+    module->print(os, NULL);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////
+//
+//
+// STATEMENT CODE GENERATION
+//
+//
+//////////////////////////////////////////////////////////////
+
+/* statements return NULL */
+
+Value *ExprStmt::codegen(CodeGenContext &) { return NULL; }
+Value *FormalStmt::codegen(CodeGenContext &) { return NULL; }
+
+Value *ClassStmt::codegen(CodeGenContext &cg) {
+  auto it = cg.classes.find(name);
+  if (it == cg.classes.end() || it->second.stmt != this) {
+    /* only classes in the outer scope are classes */
+    return NULL;
+  }
+
+  /* the class's methods see its attributes declared before them */
+  cg.scopes.emplace_back();
+  for (Feature *f : feature_list) {
+    if (f->is_method()) {
+      MethodStmt *m = static_cast<MethodStmt *>(f);
+      for (auto &body : cg.method_bodies[m]) {
+        emit_method_body(cg, m, body.first, body.second);
+      }
+    } else {
+      AttrStmt *a = static_cast<AttrStmt *>(f);
+      cg.scopes.back()[intern(a->get_name())] = {CodeGenVar::FIELD, NULL,
+                                                 a->get_type()};
+    }
+  }
+  cg.scopes.pop_back();
+
+  emit_class_init(cg, it->second);
+  return NULL;
+}
+
+Value *AttrStmt::codegen(CodeGenContext &cg) {
+  /* the initializer still sees the variable this one shadows */
+  Value *v = init ? emit(cg, init, type) : default_value(cg, type);
+  CodeGenVar var = new_var(cg, type, name);
+  cg.builder.CreateStore(v, var.ptr);
+  cg.scopes.back()[intern(name)] = var;
+  return NULL;
+}
+
+Value *MethodStmt::codegen(CodeGenContext &cg) {
+  /* class methods are emitted by their ClassStmt */
+  auto it = cg.global_methods.find(this);
+  if (it != cg.global_methods.end()) {
+    emit_method_body(cg, this, NULL, it->second);
+  }
+  return NULL;
+}
+
+Value *IfStmt::codegen(CodeGenContext &cg) {
+  IRBuilder<> &b = cg.builder;
+  Value *c = to_bool(cg, emit(cg, pred, NULL));
+  BasicBlock *then_bb = new_block(cg, "if.then");
+  BasicBlock *else_bb = else_branch.empty() ? NULL : new_block(cg, "if.else");
+  BasicBlock *end_bb = new_block(cg, "if.end");
+  b.CreateCondBr(c, then_bb, else_bb ? else_bb : end_bb);
+
+  b.SetInsertPoint(then_bb);
+  emit_stmts(cg, then_branch);
+  if (!terminated(cg)) b.CreateBr(end_bb);
+
+  if (else_bb) {
+    b.SetInsertPoint(else_bb);
+    emit_stmts(cg, else_branch);
+    if (!terminated(cg)) b.CreateBr(end_bb);
+  }
+
+  b.SetInsertPoint(end_bb);
+  return NULL;
+}
+
+Value *WhileStmt::codegen(CodeGenContext &cg) {
+  IRBuilder<> &b = cg.builder;
+  BasicBlock *cond_bb = new_block(cg, "while.cond");
+  BasicBlock *body_bb = new_block(cg, "while.body");
+  BasicBlock *end_bb = new_block(cg, "while.end");
+  b.CreateBr(cond_bb);
+
+  b.SetInsertPoint(cond_bb);
+  b.CreateCondBr(to_bool(cg, emit(cg, pred, NULL)), body_bb, end_bb);
+
+  b.SetInsertPoint(body_bb);
+  cg.loops.push_back({end_bb, cond_bb});
+  emit_stmts(cg, stmt_list);
+  cg.loops.pop_back();
+  if (!terminated(cg)) b.CreateBr(cond_bb);
+
+  b.SetInsertPoint(end_bb);
+  return NULL;
+}
+
+Value *ForStmt::codegen(CodeGenContext &cg) {
+  IRBuilder<> &b = cg.builder;
+  if (stmt) {
+    cg.expected_type = NULL;
+    stmt->codegen(cg);
+  }
+  BasicBlock *cond_bb = new_block(cg, "for.cond");
+  BasicBlock *body_bb = new_block(cg, "for.body");
+  BasicBlock *step_bb = new_block(cg, "for.step");
+  BasicBlock *end_bb = new_block(cg, "for.end");
+  b.CreateBr(cond_bb);
+
+  b.SetInsertPoint(cond_bb);
+  if (cond) {
+    b.CreateCondBr(to_bool(cg, emit(cg, cond, NULL)), body_bb, end_bb);
+  } else {
+    b.CreateBr(body_bb);
+  }
+
+  b.SetInsertPoint(body_bb);
+  cg.loops.push_back({end_bb, step_bb});
+  emit_stmts(cg, stmt_list);
+  cg.loops.pop_back();
+  if (!terminated(cg)) b.CreateBr(step_bb);
+
+  b.SetInsertPoint(step_bb);
+  if (repeat) emit(cg, repeat, NULL);
+  b.CreateBr(cond_bb);
+
+  b.SetInsertPoint(end_bb);
+  return NULL;
+}
+
+Value *BreakStmt::codegen(CodeGenContext &cg) {
+  if (cg.loops.empty()) return NULL;
+  cg.builder.CreateBr(cg.loops.back().brk);
+  dead_block(cg);
+  return NULL;
+}
+
+Value *ContStmt::codegen(CodeGenContext &cg) {
+  if (cg.loops.empty()) return NULL;
+  cg.builder.CreateBr(cg.loops.back().cont);
+  dead_block(cg);
+  return NULL;
+}
 
 /////////////////////////////////////////////////////////////////
 //
@@ -29,17 +1053,555 @@ Value *ContStmt::codegen() {}
 //
 /////////////////////////////////////////////////////////////////
 
-Value *ReturnExpr::codegen() {}
-Value *IntConstExpr::codegen() {}
-Value *DeciConstExpr::codegen() {}
-Value *StrConstExpr::codegen() {}
-Value *CharConstExpr::codegen() {}
-Value *BoolConstExpr::codegen() {}
-Value *SetConstExpr::codegen() {}
-Value *ListConstExpr::codegen() {}
-Value *ListElemRef::codegen() {}
-Value *SublistExpr::codegen() {}
-Value *ObjectIdExpr::codegen() {}
-Value *DispatchExpr::codegen() {}
-Value *BinopExpr::codegen() {}
-Value *NewExpr::codegen() {}
+/* expressions return their value, of their type's LLVM type; NULL if they
+   have none (void) */
+
+Value *ReturnExpr::codegen(CodeGenContext &cg) {
+  if (!cg.curr_method) {
+    /* a return outside of a method only evaluates its expression */
+    if (expr) emit(cg, expr, NULL);
+    return NULL;
+  }
+  Type_ *ret_type = cg.curr_method->get_ret_type();
+  Value *v = NULL;
+  if (expr) {
+    v = emit(cg, expr, type_class(ret_type) == T_VOID ? NULL : ret_type);
+    if (type_class(ret_type) == T_VOID) v = NULL;
+  }
+  emit_return(cg, v);
+  dead_block(cg);
+  return NULL;
+}
+
+Value *IntConstExpr::codegen(CodeGenContext &cg) {
+  return cg.builder.getInt64(val);
+}
+
+Value *DeciConstExpr::codegen(CodeGenContext &cg) {
+  return ConstantFP::get(cg.builder.getDoubleTy(), val);
+}
+
+Value *StrConstExpr::codegen(CodeGenContext &cg) {
+  /* strings are mutable, so each evaluation makes a new one */
+  return new_string(cg, get_value());
+}
+
+Value *CharConstExpr::codegen(CodeGenContext &cg) {
+  return cg.builder.getInt8(get_char());
+}
+
+Value *BoolConstExpr::codegen(CodeGenContext &cg) {
+  return cg.builder.getInt1(val);
+}
+
+Value *SetConstExpr::codegen(CodeGenContext &cg) {
+  /* an empty literal holds what the variable it is assigned to holds */
+  Type_ *t = get_type() ? get_type() : cg.expected_type;
+  if (type_class(t) == T_DICT) return default_value(cg, t); /* `{}` */
+  Type_ *elem = t ? t->get_nested_type() : NULL;
+  Value *s =
+      call_rt(cg, "krut_set_new", {cg.builder.getInt64(elem_kind(elem))});
+  for (ExprStmt *e : exprset) {
+    call_rt(cg, "krut_set_insert", {s, to_slot(cg, emit(cg, e, elem))});
+  }
+  return s;
+}
+
+Value *ListConstExpr::codegen(CodeGenContext &cg) {
+  /* an empty literal holds what the variable it is assigned to holds */
+  Type_ *t = get_type() ? get_type() : cg.expected_type;
+  Type_ *elem = t ? t->get_nested_type() : NULL;
+  Value *l = call_rt(cg, "krut_list_new",
+                     {cg.builder.getInt64(elem_kind(elem)),
+                      cg.builder.getInt64(exprlist.size())});
+  if (!flat_list(t)) {
+    for (ExprStmt *e : exprlist) {
+      call_rt(cg, "krut_list_push_back", {l, to_slot(cg, emit(cg, e, elem))});
+    }
+    return l;
+  }
+  /* the list has room for every element */
+  for (size_t i = 0; i < exprlist.size(); i++) {
+    Value *v = emit(cg, exprlist[i], elem);
+    store_elem(cg, list_data(cg, l, cg.builder.getInt64(i), elem), v, elem);
+  }
+  cg.builder.CreateStore(cg.builder.getInt64(exprlist.size()),
+                         list_field(cg, l, 0));
+  return l;
+}
+
+Value *ListElemRef::codegen(CodeGenContext &cg) {
+  Value *container = emit(cg, list_name, NULL);
+  Type_ *t = list_name->get_type();
+  Value *i = emit(cg, index, NULL);
+  if (type_class(t) == T_STRING) {
+    Value *c = call_rt(cg, "krut_str_get", {container, i, line_of(cg, lineno)});
+    return cg.builder.CreateTrunc(c, cg.builder.getInt8Ty());
+  }
+  if (type_class(t) != T_LIST) {
+    unsupported(cg, lineno, "`" + t->to_str() + "` cannot be indexed");
+    return zero_value(cg, get_type());
+  }
+  if (flat_list(t)) {
+    Type_ *elem = t->get_nested_type();
+    return load_elem(cg, list_elem(cg, container, i, elem, lineno), elem);
+  }
+  Value *v = call_rt(cg, "krut_list_get", {container, i, line_of(cg, lineno)});
+  return from_slot(cg, v, t->get_nested_type());
+}
+
+Value *SublistExpr::codegen(CodeGenContext &cg) {
+  Value *container = emit(cg, get_list_name(), NULL);
+  Type_ *t = get_list_name()->get_type();
+  bool is_string = type_class(t) == T_STRING;
+  if (!is_string && type_class(t) != T_LIST) {
+    unsupported(cg, lineno, "`" + t->to_str() + "` cannot be sliced");
+    return zero_value(cg, t);
+  }
+
+  /* l[:m] starts at 0, l[n:] ends at the length */
+  Value *start = get_st_idx() ? emit(cg, get_st_idx(), NULL)
+                              : cg.builder.getInt64(0);
+  Value *end;
+  if (get_end_idx()) {
+    end = emit(cg, end_idx, NULL);
+  } else {
+    end = is_string ? call_rt(cg, "krut_str_length", {container})
+                    : list_length(cg, container);
+  }
+  return call_rt(cg, is_string ? "krut_str_slice" : "krut_list_slice",
+                 {container, start, end, line_of(cg, lineno)});
+}
+
+Value *ObjectIdExpr::codegen(CodeGenContext &cg) {
+  CodeGenVar *var = lookup_var(cg, sym);
+  Value *ptr = var ? var_ptr(cg, *var, sym) : NULL;
+  if (!ptr) return zero_value(cg, get_type());
+  return cg.builder.CreateLoad(llvm_type(cg, var->type), ptr, name);
+}
+
+/* a call to a builtin global method */
+static Value *emit_builtin(CodeGenContext &cg, DispatchExpr *d) {
+  IRBuilder<> &b = cg.builder;
+  const string &name = d->get_name();
+  ExprStmt *arg_expr = d->get_args()[0];
+  Type_ *formal = d->get_method()->get_formal_list()[0]->get_type();
+  Value *line = line_of(cg, d->lineno);
+
+  if (name == Type_Of) {
+    Value *v = emit(cg, arg_expr, NULL);
+    Type_ *t = arg_expr->get_type();
+    Value *s = type_class(t) == T_CLASS ? call_rt(cg, "krut_class_name", {v})
+                                        : new_string(cg, t ? t->to_str()
+                                                           : Object);
+    return to_slot(cg, s);
+  }
+
+  Value *arg = emit(cg, arg_expr, formal);
+  if (name == Print) {
+    call_rt(cg, "krut_print", {arg});
+    return NULL;
+  }
+  if (name == Input) return call_rt(cg, "krut_input", {arg});
+  if (name == To_String) return call_rt(cg, "krut_to_string", {arg});
+  if (name == Abs) {
+    return b.CreateSelect(b.CreateICmpSLT(arg, b.getInt64(0)),
+                          b.CreateNeg(arg), arg);
+  }
+  if (name == Sum) return call_rt(cg, "krut_sum", {arg});
+  if (name == Min) return call_rt(cg, "krut_min", {arg, line});
+  if (name == Max) return call_rt(cg, "krut_max", {arg, line});
+  if (name == Kill) {
+    call_noreturn(cg, "krut_kill", {arg});
+    return NULL;
+  }
+  unsupported(cg, d->lineno, "builtin `" + name + "` is not implemented");
+  return zero_value(cg, d->get_method()->get_ret_type());
+}
+
+/* a call to a method of a string, list, set or dict, which the runtime
+   does */
+static Value *emit_container_call(CodeGenContext &cg, DispatchExpr *d,
+                                  Value *obj, Type_ *t) {
+  IRBuilder<> &b = cg.builder;
+  const string &name = d->get_name();
+  MethodStmt *m = d->get_method();
+  if (type_class(t) == T_LIST && (name == Length || name == Is_Empty)) {
+    Value *len = list_length(cg, obj);
+    return name == Length ? len : b.CreateICmpEQ(len, b.getInt64(0));
+  }
+  bool at_end = name == Front || name == Back || name == Pop_Front ||
+                name == Pop_Back;
+  if (flat_list(t) && (at_end || name == Push_Back)) {
+    Type_ *elem = t->get_nested_type();
+    if (name == Push_Back) {
+      list_push_back(cg, obj, emit(cg, d->get_args()[0], elem), elem);
+      return NULL;
+    }
+    /* the runtime reports an empty list */
+    Value *len = list_length(cg, obj);
+    BasicBlock *empty_bb = new_block(cg, "list.empty");
+    BasicBlock *end_bb = new_block(cg, "list.end");
+    b.CreateCondBr(b.CreateICmpEQ(len, b.getInt64(0)), empty_bb, end_bb);
+    b.SetInsertPoint(empty_bb);
+    call_rt(cg, "krut_list_" + name, {obj, line_of(cg, d->lineno)});
+    b.CreateUnreachable();
+    b.SetInsertPoint(end_bb);
+
+    Value *last = b.CreateSub(len, b.getInt64(1));
+    if (name == Front || name == Back) {
+      Value *i = name == Front ? b.getInt64(0) : last;
+      return load_elem(cg, list_data(cg, obj, i, elem), elem);
+    }
+    b.CreateStore(last, list_field(cg, obj, 0));
+    if (name == Pop_Front) {
+      /* see list_reserve() in the runtime */
+      Value *second = list_data(cg, obj, b.getInt64(1), elem);
+      b.CreateStore(b.CreateBitCast(second, b.getInt8PtrTy()),
+                    list_field(cg, obj, 2));
+      Value *cap = list_field(cg, obj, 1);
+      b.CreateStore(b.CreateSub(b.CreateLoad(b.getInt64Ty(), cap),
+                                b.getInt64(1)),
+                    cap);
+      Value *front = list_field(cg, obj, 4);
+      b.CreateStore(b.CreateAdd(b.CreateLoad(b.getInt64Ty(), front),
+                                b.getInt64(1)),
+                    front);
+    }
+    return NULL;
+  }
+
+  string prefix = type_class(t) == T_STRING ? "krut_str_"
+                  : type_class(t) == T_LIST ? "krut_list_"
+                  : type_class(t) == T_DICT ? "krut_dict_"
+                                            : "krut_set_";
+
+  vector<Value *> args = {obj};
+  const FormalList &formals = m->get_formal_list();
+  for (size_t i = 0; i < formals.size(); i++) {
+    args.push_back(to_slot(cg, emit(cg, d->get_args()[i],
+                                    formals[i]->get_type())));
+  }
+  /* fail when empty, or on a missing key */
+  if (at_end || name == Get) args.push_back(line_of(cg, d->lineno));
+  Value *r = call_rt(cg, prefix + name, args);
+  return from_slot(cg, r, m->get_ret_type());
+}
+
+/* a call through the vtable of OBJ, an object */
+static Value *emit_virtual_call(CodeGenContext &cg, DispatchExpr *d,
+                                Value *obj) {
+  IRBuilder<> &b = cg.builder;
+  Type *i8p = b.getInt8PtrTy();
+  MethodStmt *m = d->get_method();
+
+  vector<Value *> args = {obj};
+  const FormalList &formals = m->get_formal_list();
+  for (size_t i = 0; i < formals.size(); i++) {
+    args.push_back(to_slot(cg, emit(cg, d->get_args()[i],
+                                    formals[i]->get_type())));
+  }
+
+  BasicBlock *null_bb = new_block(cg, "dispatch.null");
+  BasicBlock *call_bb = new_block(cg, "dispatch");
+  b.CreateCondBr(b.CreateIsNull(obj), null_bb, call_bb);
+  b.SetInsertPoint(null_bb);
+  call_rt(cg, "krut_null_dispatch", {line_of(cg, d->lineno)});
+  b.CreateUnreachable();
+  b.SetInsertPoint(call_bb);
+
+  Value *vtable = b.CreateLoad(
+      i8p->getPointerTo(),
+      b.CreateBitCast(obj, i8p->getPointerTo()->getPointerTo()), "vtable");
+  int slot = 1 + cg.vtable_slots.at(intern(m->get_name()));
+  Value *fn = b.CreateLoad(i8p, b.CreateConstGEP1_32(i8p, vtable, slot));
+
+  FunctionType *ft = class_method_type(cg, formals.size());
+  Value *r = b.CreateCall(ft, b.CreateBitCast(fn, ft->getPointerTo()), args);
+  return from_slot(cg, r, m->get_ret_type());
+}
+
+Value *DispatchExpr::codegen(CodeGenContext &cg) {
+  if (!method) return NULL;
+
+  if (!calling_expr) {
+    if (method->is_builtin()) return emit_builtin(cg, this);
+    Function *f = cg.global_methods[method];
+    vector<Value *> vals;
+    const FormalList &formals = method->get_formal_list();
+    for (size_t i = 0; i < formals.size(); i++) {
+      vals.push_back(emit(cg, args[i], formals[i]->get_type()));
+    }
+    Value *r = cg.builder.CreateCall(f, vals);
+    return r->getType()->isVoidTy() ? NULL : r;
+  }
+
+  Value *obj = emit(cg, calling_expr, NULL);
+  Type_ *t = calling_expr->get_type();
+  switch (type_class(t)) {
+    case T_STRING:
+    case T_LIST:
+    case T_SET:
+    case T_DICT:
+      return emit_container_call(cg, this, obj, t);
+    case T_CLASS:
+      return emit_virtual_call(cg, this, obj);
+    default:
+      unsupported(cg, lineno, "`" + t->to_str() + "` has no methods");
+      return zero_value(cg, method->get_ret_type());
+  }
+}
+
+static Value *emit_arith(CodeGenContext &cg, char op, Value *l, Value *r,
+                         Type_ *t, int lineno) {
+  IRBuilder<> &b = cg.builder;
+  switch (type_class(t)) {
+    case T_INT:
+    case T_CHAR:
+    case T_BOOL:
+      if (op == '+') return b.CreateAdd(l, r);
+      if (op == '-') return b.CreateSub(l, r);
+      if (op == '*') return b.CreateMul(l, r);
+      if (op == '/') {
+        BasicBlock *zero_bb = new_block(cg, "div.zero");
+        BasicBlock *div_bb = new_block(cg, "div");
+        b.CreateCondBr(b.CreateICmpEQ(r, ConstantInt::get(r->getType(), 0)),
+                       zero_bb, div_bb);
+        b.SetInsertPoint(zero_bb);
+        call_rt(cg, "krut_div_by_zero", {line_of(cg, lineno)});
+        b.CreateUnreachable();
+        b.SetInsertPoint(div_bb);
+        return b.CreateSDiv(l, r);
+      }
+      break;
+    case T_DECI:
+      if (op == '+') return b.CreateFAdd(l, r);
+      if (op == '-') return b.CreateFSub(l, r);
+      if (op == '*') return b.CreateFMul(l, r);
+      if (op == '/') return b.CreateFDiv(l, r);
+      break;
+    case T_STRING:
+      if (op == '+') return call_rt(cg, "krut_str_concat", {l, r});
+      break;
+    case T_LIST:
+      if (op == '+') return call_rt(cg, "krut_list_concat", {l, r});
+      break;
+    case T_SET:
+      if (op == '+') return call_rt(cg, "krut_set_union", {l, r});
+      if (op == '-') return call_rt(cg, "krut_set_difference", {l, r});
+      break;
+    default:
+      break;
+  }
+  unsupported(cg, lineno, string("operator `") + op +
+                              "` is not defined on `" + t->to_str() + "`");
+  return zero_value(cg, t);
+}
+
+static Value *emit_compare(CodeGenContext &cg, const string &op, Value *l,
+                           Value *r, Type_ *t, int lineno) {
+  IRBuilder<> &b = cg.builder;
+  bool eq = op == Equal, ne = op == NotEqual;
+  CmpInst::Predicate pred;
+  switch (type_class(t)) {
+    case T_DECI:
+      pred = eq   ? CmpInst::FCMP_OEQ
+             : ne ? CmpInst::FCMP_UNE
+             : op == LessThan    ? CmpInst::FCMP_OLT
+             : op == GreaterThan ? CmpInst::FCMP_OGT
+             : op == LEQ         ? CmpInst::FCMP_OLE
+                                 : CmpInst::FCMP_OGE;
+      return b.CreateFCmp(pred, l, r);
+    case T_STRING: {
+      if (eq || ne) {
+        Value *v = to_bool(cg, call_rt(cg, "krut_str_eq", {l, r}));
+        return eq ? v : b.CreateNot(v);
+      }
+      /* compare the sign of strcmp() with 0 */
+      l = call_rt(cg, "krut_str_cmp", {l, r});
+      r = b.getInt64(0);
+      t = NULL;
+      break;
+    }
+    case T_LIST:
+    case T_SET:
+    case T_DICT:
+      if (eq || ne) {
+        const char *fn = type_class(t) == T_LIST  ? "krut_list_eq"
+                         : type_class(t) == T_SET ? "krut_set_eq"
+                                                  : "krut_dict_eq";
+        Value *v = to_bool(cg, call_rt(cg, fn, {l, r}));
+        return eq ? v : b.CreateNot(v);
+      }
+      unsupported(cg, lineno, "operator `" + op + "` is not defined on `" +
+                                  t->to_str() + "`");
+      return b.getFalse();
+    case T_CLASS:
+      if (eq || ne) return eq ? b.CreateICmpEQ(l, r) : b.CreateICmpNE(l, r);
+      unsupported(cg, lineno, "operator `" + op + "` is not defined on `" +
+                                  t->to_str() + "`");
+      return b.getFalse();
+    default:
+      break;
+  }
+
+  /* chars and bools compare unsigned */
+  bool is_signed = type_class(t) != T_CHAR && type_class(t) != T_BOOL;
+  pred = eq                  ? CmpInst::ICMP_EQ
+         : ne                ? CmpInst::ICMP_NE
+         : op == LessThan    ? (is_signed ? CmpInst::ICMP_SLT
+                                          : CmpInst::ICMP_ULT)
+         : op == GreaterThan ? (is_signed ? CmpInst::ICMP_SGT
+                                          : CmpInst::ICMP_UGT)
+         : op == LEQ         ? (is_signed ? CmpInst::ICMP_SLE
+                                          : CmpInst::ICMP_ULE)
+                             : (is_signed ? CmpInst::ICMP_SGE
+                                          : CmpInst::ICMP_UGE);
+  return b.CreateICmp(pred, l, r);
+}
+
+/* what the left side of an assignment refers to: a variable, or an element
+   of a list or string */
+struct LValue {
+  Type_ *type = NULL;
+  Value *ptr = NULL; /* a variable's address */
+  Value *container = NULL; /* an element's list or string */
+  Value *index = NULL;
+  bool is_string = false;
+  bool is_flat = false; /* see flat_list() */
+};
+
+static bool emit_lvalue(CodeGenContext &cg, ExprStmt *e, LValue &lv) {
+  if (e->get_stmttype() == OBJECTID_EXPR) {
+    ObjectIdExpr *id = static_cast<ObjectIdExpr *>(e);
+    CodeGenVar *var = lookup_var(cg, id->get_sym());
+    if (!var) return false;
+    lv.type = var->type;
+    lv.ptr = var_ptr(cg, *var, id->get_sym());
+    return lv.ptr != NULL;
+  }
+  if (e->get_stmttype() == LIST_ELEM_REF) {
+    ListElemRef *ref = static_cast<ListElemRef *>(e);
+    Type_ *t = ref->get_list_name()->get_type();
+    if (type_class(t) != T_STRING && type_class(t) != T_LIST) return false;
+    lv.container = emit(cg, ref->get_list_name(), NULL);
+    lv.index = emit(cg, ref->get_index(), NULL);
+    lv.is_string = type_class(t) == T_STRING;
+    lv.is_flat = flat_list(t);
+    lv.type = lv.is_string ? e->get_type() : t->get_nested_type();
+    return true;
+  }
+  return false;
+}
+
+static Value *load_lvalue(CodeGenContext &cg, LValue &lv, int lineno) {
+  IRBuilder<> &b = cg.builder;
+  if (lv.ptr) return b.CreateLoad(llvm_type(cg, lv.type), lv.ptr);
+  if (lv.is_string) {
+    Value *c = call_rt(cg, "krut_str_get",
+                       {lv.container, lv.index, line_of(cg, lineno)});
+    return b.CreateTrunc(c, b.getInt8Ty());
+  }
+  /* the address is taken again on each access, since the right side of
+     an assignment may have grown the list */
+  if (lv.is_flat) {
+    return load_elem(cg, list_elem(cg, lv.container, lv.index, lv.type,
+                                   lineno),
+                     lv.type);
+  }
+  Value *v = call_rt(cg, "krut_list_get",
+                     {lv.container, lv.index, line_of(cg, lineno)});
+  return from_slot(cg, v, lv.type);
+}
+
+static void store_lvalue(CodeGenContext &cg, LValue &lv, Value *v,
+                         int lineno) {
+  if (lv.ptr) {
+    cg.builder.CreateStore(v, lv.ptr);
+    return;
+  }
+  if (lv.is_flat) {
+    Value *ptr = list_elem(cg, lv.container, lv.index, lv.type, lineno);
+    store_elem(cg, ptr, v, lv.type);
+    return;
+  }
+  call_rt(cg, lv.is_string ? "krut_str_set" : "krut_list_set",
+          {lv.container, lv.index, to_slot(cg, v), line_of(cg, lineno)});
+}
+
+/* =, +=, -=, *= and /=; the value is the one assigned */
+static Value *emit_assign(CodeGenContext &cg, BinopExpr *e) {
+  ExprStmt *lhs = e->get_lhs(), *rhs = e->get_rhs();
+  const string &op = e->get_op();
+  LValue lv;
+  if (!emit_lvalue(cg, lhs, lv)) {
+    /* the typechecker allows assigning to a value; it has no effect */
+    return emit(cg, rhs, NULL);
+  }
+
+  Value *v;
+  Type_ *rt = rhs->get_type();
+  if (op == Define) {
+    v = emit(cg, rhs, lv.type);
+  } else {
+    Type_ *t = operand_type(lv.type, rt);
+    Value *cur = convert(cg, load_lvalue(cg, lv, e->lineno), lv.type, t);
+    Value *r = emit(cg, rhs, t);
+    v = convert(cg, emit_arith(cg, op[0], cur, r, t, e->lineno), t, lv.type);
+  }
+  store_lvalue(cg, lv, v, e->lineno);
+  return convert(cg, v, lv.type, result_type(lv.type, rt));
+}
+
+/* && and ||, which skip their right side when the left decides */
+static Value *emit_logical(CodeGenContext &cg, BinopExpr *e) {
+  IRBuilder<> &b = cg.builder;
+  bool is_and = e->get_op() == And;
+  Value *l = to_bool(cg, emit(cg, e->get_lhs(), NULL));
+  BasicBlock *lhs_bb = b.GetInsertBlock();
+  BasicBlock *rhs_bb = new_block(cg, is_and ? "and.rhs" : "or.rhs");
+  BasicBlock *end_bb = new_block(cg, is_and ? "and.end" : "or.end");
+  if (is_and) {
+    b.CreateCondBr(l, rhs_bb, end_bb);
+  } else {
+    b.CreateCondBr(l, end_bb, rhs_bb);
+  }
+
+  b.SetInsertPoint(rhs_bb);
+  Value *r = to_bool(cg, emit(cg, e->get_rhs(), NULL));
+  rhs_bb = b.GetInsertBlock();
+  b.CreateBr(end_bb);
+
+  b.SetInsertPoint(end_bb);
+  PHINode *phi = b.CreatePHI(b.getInt1Ty(), 2);
+  phi->addIncoming(b.getInt1(!is_and), lhs_bb);
+  phi->addIncoming(r, rhs_bb);
+  return phi;
+}
+
+Value *BinopExpr::codegen(CodeGenContext &cg) {
+  if (op == And || op == Or) return emit_logical(cg, this);
+  if (op == Define || op == PlusEquals || op == MinusEquals ||
+      op == TimesEquals || op == DivideEquals) {
+    return emit_assign(cg, this);
+  }
+
+  Type_ *lt = lhs->get_type(), *rt = rhs->get_type();
+  Type_ *t = operand_type(lt, rt);
+  Value *l = emit(cg, lhs, t);
+  Value *r = emit(cg, rhs, t);
+  if (op == Plus || op == Minus || op == Times || op == Divide) {
+    Value *v = emit_arith(cg, op[0], l, r, t, lineno);
+    return convert(cg, v, t, result_type(lt, rt));
+  }
+  return emit_compare(cg, op, l, r, t, lineno);
+}
+
+Value *NewExpr::codegen(CodeGenContext &cg) {
+  auto it = cg.classes.find(newclass);
+  if (it != cg.classes.end()) {
+    return cg.builder.CreateCall(it->second.make, {});
+  }
+  /* new on a builtin type: its default value */
+  return get_type() ? default_value(cg, get_type()) : NULL;
+}
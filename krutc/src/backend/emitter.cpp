@@ -0,0 +1,169 @@
+#include "emitter.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace std;
+using namespace llvm;
+
+static CodeGenOpt::Level codegen_opt_level(int opt_level) {
+  switch (opt_level) {
+    case 0:
+      return CodeGenOpt::None;
+    case 1:
+      return CodeGenOpt::Less;
+    case 2:
+      return CodeGenOpt::Default;
+    default:
+      return CodeGenOpt::Aggressive;
+  }
+}
+
+unique_ptr<TargetMachine> create_target_machine(const string &cpu,
+                                                int opt_level) {
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+
+  string triple = sys::getDefaultTargetTriple();
+  string err;
+  const Target *target = TargetRegistry::lookupTarget(triple, err);
+  if (!target) {
+    cerr << "Error: " << err << endl;
+    return NULL;
+  }
+
+  string cpu_name = cpu.empty() ? "generic" : cpu;
+  string features;
+  if (cpu == "native") {
+    cpu_name = sys::getHostCPUName().str();
+    StringMap<bool> host_features;
+    if (sys::getHostCPUFeatures(host_features)) {
+      SubtargetFeatures f;
+      for (const auto &feature : host_features) {
+        f.AddFeature(feature.first(), feature.second);
+      }
+      features = f.getString();
+    }
+  }
+
+  unique_ptr<MCSubtargetInfo> sti(
+      target->createMCSubtargetInfo(triple, "", ""));
+  if (!sti->isCPUStringValid(cpu_name)) {
+    cerr << "Error: unknown -march CPU `" << cpu_name << "`" << endl;
+    return NULL;
+  }
+
+  /* PIC, since the system linker makes position independent executables */
+  unique_ptr<TargetMachine> tm(target->createTargetMachine(
+      triple, cpu_name, features, TargetOptions(), Reloc::PIC_, None,
+      codegen_opt_level(opt_level)));
+  if (!tm) {
+    cerr << "Error: cannot create a target machine for " << triple << endl;
+    return NULL;
+  }
+  return tm;
+}
+
+void set_target(Module &m, TargetMachine &tm) {
+  m.setTargetTriple(tm.getTargetTriple().str());
+  m.setDataLayout(tm.createDataLayout());
+}
+
+bool emit_object(Module &m, TargetMachine &tm, const string &path) {
+  error_code ec;
+  raw_fd_ostream os(path, ec, sys::fs::OF_None);
+  if (ec) {
+    cerr << "Error: cannot write " << path << ": " << ec.message() << endl;
+    return false;
+  }
+
+  /* the backend still runs under the legacy pass manager */
+  legacy::PassManager pm;
+  if (tm.addPassesToEmitFile(pm, os, NULL, CGFT_ObjectFile)) {
+    cerr << "Error: the target cannot emit object files" << endl;
+    return false;
+  }
+  pm.run(m);
+
+  /* a full disk shows up only here, and would leave a truncated object */
+  os.close();
+  if (os.has_error()) {
+    cerr << "Error: cannot write " << path << ": " << os.error().message()
+         << endl;
+    os.clear_error();
+    if (sys::fs::is_regular_file(path)) sys::fs::remove(path);
+    return false;
+  }
+  return true;
+}
+
+/* $KRUTRT, or libkrutrt.a next to the running executable, as in the build
+   tree, or in the lib directory beside its bin, as installed. Empty if
+   there is none */
+static string find_runtime() {
+  const char *env = getenv("KRUTRT");
+  if (env) return env;
+
+  void *addr = (void *)(intptr_t)find_runtime;
+  string exe = sys::fs::getMainExecutable("krutc", addr);
+  SmallString<256> dir(sys::path::parent_path(exe));
+  SmallString<256> beside(dir), installed(dir);
+  sys::path::append(beside, "libkrutrt.a");
+  sys::path::append(installed, "..", "lib", "libkrutrt.a");
+  if (sys::fs::exists(beside)) return beside.str().str();
+  if (sys::fs::exists(installed)) return installed.str().str();
+  return "";
+}
+
+static bool link_with_runtime(const string &object, const string &path) {
+  /* the runtime is C++, so link with the C++ driver */
+  auto cxx = sys::findProgramByName("c++");
+  if (!cxx) {
+    cerr << "Error: cannot find c++ to link with" << endl;
+    return false;
+  }
+  string runtime = find_runtime();
+  if (runtime.empty()) {
+    cerr << "Error: cannot find libkrutrt.a beside krutc or in its ../lib;"
+         << " set KRUTRT to its path" << endl;
+    return false;
+  }
+
+  vector<StringRef> args = {*cxx, object, runtime, "-o", path};
+  string err;
+  int status = sys::ExecuteAndWait(*cxx, args, None, {}, 0, 0, &err);
+  if (status != 0) {
+    cerr << "Error: linking " << path << " failed";
+    if (!err.empty()) cerr << ": " << err;
+    cerr << endl;
+    return false;
+  }
+  return true;
+}
+
+bool emit_executable(Module &m, TargetMachine &tm, const string &path) {
+  SmallString<128> object;
+  if (error_code ec = sys::fs::createTemporaryFile("krutc", "o", object)) {
+    cerr << "Error: cannot create a temporary file: " << ec.message()
+         << endl;
+    return false;
+  }
+  bool ok = emit_object(m, tm, object.str().str()) &&
+            link_with_runtime(object.str().str(), path);
+  sys::fs::remove(object);
+  return ok;
+}
@@ -0,0 +1,581 @@
+#include "interpreter.h"
+
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "bccompiler.h"
+#include "codegen.h"
+#include "runtime.h"
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////
+//
+// Runtime functions
+//
+//////////////////////////////////////////////////////////////
+
+/* the argument of type T that slot V holds, and back */
+template <class T>
+static T from_slot(int64_t v) {
+  if constexpr (is_pointer_v<T>) {
+    return reinterpret_cast<T>(v);
+  } else {
+    return static_cast<T>(v);
+  }
+}
+
+template <class T>
+static int64_t to_slot(T v) {
+  if constexpr (is_pointer_v<T>) {
+    return reinterpret_cast<int64_t>(v);
+  } else {
+    return static_cast<int64_t>(v);
+  }
+}
+
+/* calls runtime function F with its arguments taken from slots */
+template <auto F>
+struct Native;
+
+template <class R, class... A, R (*F)(A...)>
+struct Native<F> {
+  static constexpr int nargs = sizeof...(A);
+
+  template <size_t... I>
+  static int64_t call(int64_t *args, index_sequence<I...>) {
+    (void)args;
+    if constexpr (is_void_v<R>) {
+      F(from_slot<A>(args[I])...);
+      return 0;
+    } else {
+      return to_slot(F(from_slot<A>(args[I])...));
+    }
+  }
+
+  static int64_t fn(int64_t *args) {
+    return call(args, index_sequence_for<A...>());
+  }
+};
+
+#define BC_NATIVE(f) {#f, &Native<&f>::fn, Native<&f>::nargs},
+static const vector<BcNative> NATIVES = {KRUT_RUNTIME_FUNCTIONS(BC_NATIVE)};
+#undef BC_NATIVE
+
+const vector<BcNative> &bc_natives() { return NATIVES; }
+
+int bc_native(const string &name) {
+  static const unordered_map<string, int> index = [] {
+    unordered_map<string, int> index;
+    for (size_t i = 0; i < NATIVES.size(); i++) index[NATIVES[i].name] = i;
+    return index;
+  }();
+  auto it = index.find(name);
+  return it == index.end() ? -1 : it->second;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Running bytecode
+//
+//////////////////////////////////////////////////////////////
+
+/* every frame's registers, in slots, and the calls under way */
+static const size_t STACK_SLOTS = 1 << 20;
+static const size_t MAX_FRAMES = 1 << 16;
+
+static double to_deci(int64_t v) {
+  double d;
+  memcpy(&d, &v, sizeof(d));
+  return d;
+}
+
+static int64_t from_deci(double d) {
+  int64_t v;
+  memcpy(&v, &d, sizeof(v));
+  return v;
+}
+
+/* ints wrap around, as they do in compiled code */
+static int64_t wrap(uint64_t v) { return (int64_t)v; }
+
+static KrutString *str(int64_t v) { return (KrutString *)v; }
+
+/*
+  With GCC and Clang each handler jumps straight to the next one (direct
+  threading): before the first run, every opcode is replaced by the offset
+  of its handler from the first one. Other compilers get a switch.
+*/
+#ifdef __GNUC__
+#define BC_THREADED
+#define OP(name) L_##name:
+#define DISPATCH() goto *((char *)&&L_OP_MOVE + *ip)
+#else
+#define OP(name) case name:
+#define DISPATCH() continue
+#endif
+
+/* on to the instruction after this one, which is N words long */
+#define NEXT(n) \
+  ip += n;      \
+  DISPATCH()
+/* register operand I of this instruction */
+#define R(i) fp[ip[i]]
+/* a compare and jump, to operand 3 if COND holds */
+#define JUMP_IF(cond)                \
+  ip = (cond) ? code + ip[3] : ip + 4; \
+  DISPATCH()
+
+/* runs method M, whose arguments are at FP, and returns its value. Calls
+   to bytecode push a frame rather than recursing */
+int64_t Interpreter::execute(BcMethod *m, int64_t *fp) {
+#ifdef BC_THREADED
+#define BC_LABEL(name, words) &&L_##name,
+  static void *const labels[] = {BC_OPCODES(BC_LABEL)};
+#undef BC_LABEL
+  if (!module->threaded) {
+    for (auto &method : module->methods) {
+      vector<int32_t> &code = method->code;
+      for (size_t i = 0; i < code.size();) {
+        int32_t o = code[i];
+        code[i] = (char *)labels[o] - (char *)&&L_OP_MOVE;
+        i += BC_WORDS[o];
+      }
+    }
+    module->threaded = true;
+  }
+#endif
+
+  BcFrame *frame = frames.get(), *entry = frame;
+  const int32_t *code = m->code.data();
+  const int32_t *ip = code;
+  const int64_t *consts = module->consts.data();
+  int64_t *globals = module->globals.get();
+  BcMethod *callee;
+  int32_t dst;
+  int64_t *callee_fp;
+
+#ifdef BC_THREADED
+  DISPATCH();
+#else
+  for (;;) switch (*ip)
+#endif
+  {
+    OP(OP_MOVE) {
+      R(1) = R(2);
+      NEXT(3);
+    }
+    OP(OP_LOADK) {
+      R(1) = consts[ip[2]];
+      NEXT(3);
+    }
+    OP(OP_LOAD_GLOBAL) {
+      R(1) = globals[ip[2]];
+      NEXT(3);
+    }
+    OP(OP_STORE_GLOBAL) {
+      globals[ip[1]] = R(2);
+      NEXT(3);
+    }
+    OP(OP_LOAD_FIELD) {
+      R(1) = ((int64_t *)fp[0])[1 + ip[2]];
+      NEXT(3);
+    }
+    OP(OP_STORE_FIELD) {
+      ((int64_t *)fp[0])[1 + ip[1]] = R(2);
+      NEXT(3);
+    }
+
+    OP(OP_ADD_I) {
+      R(1) = wrap((uint64_t)R(2) + (uint64_t)R(3));
+      NEXT(4);
+    }
+    OP(OP_ADD_IK) {
+      R(1) = wrap((uint64_t)R(2) + (uint64_t)(int64_t)ip[3]);
+      NEXT(4);
+    }
+    OP(OP_SUB_I) {
+      R(1) = wrap((uint64_t)R(2) - (uint64_t)R(3));
+      NEXT(4);
+    }
+    OP(OP_MUL_I) {
+      R(1) = wrap((uint64_t)R(2) * (uint64_t)R(3));
+      NEXT(4);
+    }
+    OP(OP_DIV_I) {
+      if (R(3) == 0) krut_div_by_zero(ip[4]);
+      R(1) = R(2) / R(3);
+      NEXT(5);
+    }
+    OP(OP_ABS_I) {
+      R(1) = R(2) < 0 ? wrap(-(uint64_t)R(2)) : R(2);
+      NEXT(3);
+    }
+    OP(OP_EQ_I) {
+      R(1) = R(2) == R(3);
+      NEXT(4);
+    }
+    OP(OP_NE_I) {
+      R(1) = R(2) != R(3);
+      NEXT(4);
+    }
+    OP(OP_LT_I) {
+      R(1) = R(2) < R(3);
+      NEXT(4);
+    }
+    OP(OP_LE_I) {
+      R(1) = R(2) <= R(3);
+      NEXT(4);
+    }
+    OP(OP_GT_I) {
+      R(1) = R(2) > R(3);
+      NEXT(4);
+    }
+    OP(OP_GE_I) {
+      R(1) = R(2) >= R(3);
+      NEXT(4);
+    }
+    OP(OP_NOT) {
+      R(1) = !R(2);
+      NEXT(3);
+    }
+
+    OP(OP_ADD_D) {
+      R(1) = from_deci(to_deci(R(2)) + to_deci(R(3)));
+      NEXT(4);
+    }
+    OP(OP_SUB_D) {
+      R(1) = from_deci(to_deci(R(2)) - to_deci(R(3)));
+      NEXT(4);
+    }
+    OP(OP_MUL_D) {
+      R(1) = from_deci(to_deci(R(2)) * to_deci(R(3)));
+      NEXT(4);
+    }
+    OP(OP_DIV_D) {
+      R(1) = from_deci(to_deci(R(2)) / to_deci(R(3)));
+      NEXT(4);
+    }
+    OP(OP_EQ_D) {
+      R(1) = to_deci(R(2)) == to_deci(R(3));
+      NEXT(4);
+    }
+    OP(OP_NE_D) {
+      R(1) = to_deci(R(2)) != to_deci(R(3));
+      NEXT(4);
+    }
+    OP(OP_LT_D) {
+      R(1) = to_deci(R(2)) < to_deci(R(3));
+      NEXT(4);
+    }
+    OP(OP_LE_D) {
+      R(1) = to_deci(R(2)) <= to_deci(R(3));
+      NEXT(4);
+    }
+    OP(OP_GT_D) {
+      R(1) = to_deci(R(2)) > to_deci(R(3));
+      NEXT(4);
+    }
+    OP(OP_GE_D) {
+      R(1) = to_deci(R(2)) >= to_deci(R(3));
+      NEXT(4);
+    }
+
+    OP(OP_CONCAT_S) {
+      R(1) = (int64_t)krut_str_concat(str(R(2)), str(R(3)));
+      NEXT(4);
+    }
+    OP(OP_EQ_S) {
+      R(1) = krut_str_eq(str(R(2)), str(R(3)));
+      NEXT(4);
+    }
+    OP(OP_NE_S) {
+      R(1) = !krut_str_eq(str(R(2)), str(R(3)));
+      NEXT(4);
+    }
+    OP(OP_LT_S) {
+      R(1) = krut_str_cmp(str(R(2)), str(R(3))) < 0;
+      NEXT(4);
+    }
+    OP(OP_LE_S) {
+      R(1) = krut_str_cmp(str(R(2)), str(R(3))) <= 0;
+      NEXT(4);
+    }
+    OP(OP_GT_S) {
+      R(1) = krut_str_cmp(str(R(2)), str(R(3))) > 0;
+      NEXT(4);
+    }
+    OP(OP_GE_S) {
+      R(1) = krut_str_cmp(str(R(2)), str(R(3))) >= 0;
+      NEXT(4);
+    }
+    OP(OP_LEN_S) {
+      R(1) = krut_str_length(str(R(2)));
+      NEXT(3);
+    }
+    OP(OP_GET_S) {
+      R(1) = krut_str_get(str(R(2)), R(3), ip[4]);
+      NEXT(5);
+    }
+
+    OP(OP_I2D) {
+      R(1) = from_deci((double)R(2));
+      NEXT(3);
+    }
+    OP(OP_D2I) {
+      R(1) = (int64_t)to_deci(R(2));
+      NEXT(3);
+    }
+    OP(OP_I2B) {
+      R(1) = R(2) != 0;
+      NEXT(3);
+    }
+    OP(OP_D2B) {
+      R(1) = to_deci(R(2)) != 0.0;
+      NEXT(3);
+    }
+    OP(OP_NARROW_C) {
+      R(1) = R(2) & 0xff;
+      NEXT(3);
+    }
+    OP(OP_NARROW_B) {
+      R(1) = R(2) & 1;
+      NEXT(3);
+    }
+
+    OP(OP_JUMP) {
+      ip = code + ip[1];
+      DISPATCH();
+    }
+    OP(OP_JUMP_IF_FALSE) {
+      ip = R(1) ? ip + 3 : code + ip[2];
+      DISPATCH();
+    }
+    OP(OP_JUMP_IF_TRUE) {
+      ip = R(1) ? code + ip[2] : ip + 3;
+      DISPATCH();
+    }
+    OP(OP_LOOP) {
+      if (tiered && ++m->hotness == threshold) promote(m);
+      ip = code + ip[1];
+      DISPATCH();
+    }
+    OP(OP_JEQ_I) { JUMP_IF(R(1) == R(2)); }
+    OP(OP_JNE_I) { JUMP_IF(R(1) != R(2)); }
+    OP(OP_JLT_I) { JUMP_IF(R(1) < R(2)); }
+    OP(OP_JLE_I) { JUMP_IF(R(1) <= R(2)); }
+    OP(OP_JGT_I) { JUMP_IF(R(1) > R(2)); }
+    OP(OP_JGE_I) { JUMP_IF(R(1) >= R(2)); }
+    OP(OP_JEQ_IK) { JUMP_IF(R(1) == ip[2]); }
+    OP(OP_JNE_IK) { JUMP_IF(R(1) != ip[2]); }
+    OP(OP_JLT_IK) { JUMP_IF(R(1) < ip[2]); }
+    OP(OP_JLE_IK) { JUMP_IF(R(1) <= ip[2]); }
+    OP(OP_JGT_IK) { JUMP_IF(R(1) > ip[2]); }
+    OP(OP_JGE_IK) { JUMP_IF(R(1) >= ip[2]); }
+
+    OP(OP_CALL) {
+      callee = module->methods[ip[2]].get();
+      callee_fp = fp + ip[3];
+      auto native = callee->native.load(memory_order_acquire);
+      if (native) {
+        R(1) = native(callee_fp);
+        NEXT(4);
+      }
+      if (tiered && ++callee->hotness == threshold) promote(callee);
+      dst = ip[1];
+      ip += 4;
+      goto call;
+    }
+    OP(OP_CALL_VIRTUAL) {
+      callee_fp = fp + ip[3];
+      if (!callee_fp[0]) krut_null_dispatch(ip[4]);
+      const void *const *header = *(const void *const **)callee_fp[0];
+      const BcClass *cls = (const BcClass *)header[1];
+      callee = cls->vtable[ip[2]];
+      dst = ip[1];
+      ip += 5;
+      goto call;
+    }
+    OP(OP_CALL_NATIVE) {
+      R(1) = NATIVES[ip[2]].fn(fp + ip[3]);
+      NEXT(4);
+    }
+    OP(OP_NEW) {
+      BcClass *cls = module->classes[ip[2]].get();
+      int64_t *obj = (int64_t *)krut_alloc(8 * (1 + cls->nattrs));
+      obj[0] = (int64_t)cls->header;
+      callee_fp = fp + ip[3];
+      callee_fp[0] = (int64_t)obj;
+      callee = cls->init;
+      dst = ip[1];
+      ip += 4;
+      goto call;
+    }
+    OP(OP_RETURN) {
+      int64_t v = R(1);
+      if (frame == entry) return v;
+      frame--;
+      m = frame->m;
+      fp = frame->fp;
+      ip = frame->ip;
+      code = m->code.data();
+      fp[frame->dst] = v;
+      DISPATCH();
+    }
+
+    call: {
+      /* the caller's registers stay where they are; the callee's start at
+         its arguments */
+      if (frame == frames_end || callee_fp + callee->nregs > stack_end) {
+        krut_unsupported(callee->stmt ? callee->stmt->lineno : 0,
+                         "stack overflow");
+      }
+      *frame++ = {m, ip, fp, dst};
+      m = callee;
+      fp = callee_fp;
+      code = ip = m->code.data();
+      DISPATCH();
+    }
+  }
+
+  return 0; /* not reached */
+}
+
+#undef OP
+#undef DISPATCH
+#undef NEXT
+#undef R
+#undef JUMP_IF
+#undef BC_THREADED
+
+//////////////////////////////////////////////////////////////
+//
+// Tiering
+//
+//////////////////////////////////////////////////////////////
+
+/* queues hot method M, and the global methods it calls, for the JIT */
+void Interpreter::promote(BcMethod *m) {
+  if (m->queued || !m->tierable) return;
+  vector<BcMethod *> methods = {m};
+  unordered_set<BcMethod *> seen = {m};
+  for (size_t i = 0; i < methods.size(); i++) {
+    for (BcMethod *callee : methods[i]->callees) {
+      if (!callee->tierable) {
+        /* it would always stay interpreted; do not ask again */
+        m->queued = true;
+        return;
+      }
+      if (seen.insert(callee).second) methods.push_back(callee);
+    }
+  }
+  for (BcMethod *method : methods) method->queued = true;
+
+  lock_guard<mutex> guard(tier_lock);
+  tier_queue.push_back(move(methods));
+  tier_ready.notify_one();
+}
+
+void Interpreter::tier_loop() {
+  for (int n = 0;; n++) {
+    vector<BcMethod *> methods;
+    {
+      unique_lock<mutex> guard(tier_lock);
+      tier_ready.wait(guard,
+                      [this] { return tier_stop || !tier_queue.empty(); });
+      if (tier_stop) return;
+      methods = move(tier_queue.front());
+      tier_queue.pop_front();
+    }
+    tier_compile(methods, n);
+  }
+}
+
+/* compiles METHODS into the JIT's Nth module, then points them at it */
+void Interpreter::tier_compile(const vector<BcMethod *> &methods, int n) {
+  auto start = chrono::steady_clock::now();
+
+  vector<MethodStmt *> stmts;
+  for (BcMethod *m : methods) stmts.push_back(m->stmt);
+  unordered_map<AttrStmt *, void *> globals;
+  for (auto &g : module->global_index) {
+    globals[g.first] = &module->globals[g.second];
+  }
+  /* a method may be compiled again with a later one that calls it, so
+     each module's entry points have their own names */
+  string prefix = "tier" + to_string(n) + ".";
+
+  CodeGen cgen(program, typechecker, filename);
+  if (cgen.codegen_methods(stmts, globals, prefix)) return;
+  if (!jit->add(cgen.take_context(), cgen.take_module())) return;
+  for (BcMethod *m : methods) {
+    void *f = jit->lookup(prefix + m->stmt->get_name());
+    if (f) m->native.store((int64_t(*)(int64_t *))f, memory_order_release);
+  }
+
+  chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+  lock_guard<mutex> guard(tier_lock);
+  num_tiered += methods.size();
+  tier_ms += ms.count();
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Interpreter
+//
+//////////////////////////////////////////////////////////////
+
+Interpreter::~Interpreter() {
+  if (!tier_thread.joinable()) return;
+  {
+    lock_guard<mutex> guard(tier_lock);
+    tier_stop = true;
+  }
+  tier_ready.notify_one();
+  tier_thread.join();
+}
+
+void Interpreter::compile() { module = compile_bytecode(program, typechecker); }
+
+int Interpreter::run(vector<string> args) {
+  vector<char *> argv;
+  for (string &arg : args) argv.push_back(&arg[0]);
+  argv.push_back(NULL);
+  krut_init(filename.c_str(), args.size(), argv.data());
+
+  if (tiered) {
+    jit = Jit::create(opt_level);
+    if (jit) {
+      tier_thread = thread(&Interpreter::tier_loop, this);
+    } else {
+      tiered = false;
+    }
+  }
+
+  stack = make_unique<int64_t[]>(STACK_SLOTS);
+  stack_end = stack.get() + STACK_SLOTS;
+  frames = make_unique<BcFrame[]>(MAX_FRAMES);
+  frames_end = frames.get() + MAX_FRAMES;
+  execute(module->top, stack.get());
+  if (module->main) {
+    stack[0] = (int64_t)krut_args();
+    execute(module->main, stack.get());
+  }
+  return 0;
+}
+
+void Interpreter::print_stats(ostream &os) {
+  size_t words = 0;
+  for (auto &m : module->methods) words += m->code.size();
+  lock_guard<mutex> guard(tier_lock);
+  os << "bytecode: " << module->methods.size() << " methods, " << words
+     << " words" << endl;
+  if (tiered) {
+    os << "tiering: " << num_tiered << " methods compiled in " << tier_ms
+       << " ms" << endl;
+  }
+}
@@ -0,0 +1,115 @@
+#include "jit.h"
+
+#include <iostream>
+
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Support/TargetSelect.h"
+#include "optimizer.h"
+#include "runtime.h"
+
+using namespace std;
+using namespace llvm;
+
+/* the runtime functions generated code may call, by name */
+#define RUNTIME_SYMBOL(f) {#f, (void *)&f},
+static const pair<const char *, void *> RUNTIME_SYMBOLS[] = {
+    KRUT_RUNTIME_FUNCTIONS(RUNTIME_SYMBOL)};
+#undef RUNTIME_SYMBOL
+
+static void jit_error(Error err) {
+  cerr << "Error: JIT: " << toString(move(err)) << endl;
+}
+
+Jit::~Jit() = default;
+
+unique_ptr<Jit> Jit::create(int opt_level) {
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+
+  auto jtmb = orc::JITTargetMachineBuilder::detectHost();
+  if (!jtmb) {
+    jit_error(jtmb.takeError());
+    return NULL;
+  }
+  jtmb->setCodeGenOptLevel(opt_level == 0 ? CodeGenOpt::None
+                                          : CodeGenOpt::Default);
+  auto tm = jtmb->createTargetMachine();
+  if (!tm) {
+    jit_error(tm.takeError());
+    return NULL;
+  }
+  auto lljit = orc::LLJITBuilder().setJITTargetMachineBuilder(*jtmb).create();
+  if (!lljit) {
+    jit_error(lljit.takeError());
+    return NULL;
+  }
+
+  /* the runtime is linked into krutc, so its functions are already here;
+     anything else (libc, libm) is looked up in the process */
+  orc::JITDylib &jd = (*lljit)->getMainJITDylib();
+  orc::SymbolMap symbols;
+  for (const auto &sym : RUNTIME_SYMBOLS) {
+    symbols[(*lljit)->mangleAndIntern(sym.first)] = JITEvaluatedSymbol(
+        pointerToJITTargetAddress(sym.second), JITSymbolFlags::Exported);
+  }
+  if (Error err = jd.define(orc::absoluteSymbols(move(symbols)))) {
+    jit_error(move(err));
+    return NULL;
+  }
+  auto process = orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+      (*lljit)->getDataLayout().getGlobalPrefix());
+  if (!process) {
+    jit_error(process.takeError());
+    return NULL;
+  }
+  jd.addGenerator(move(*process));
+
+  unique_ptr<Jit> result(new Jit());
+  result->jit = move(*lljit);
+  result->tm = move(*tm);
+  result->opt_level = opt_level;
+  return result;
+}
+
+bool Jit::add(unique_ptr<LLVMContext> llvm, unique_ptr<Module> module) {
+  module->setDataLayout(tm->createDataLayout());
+  module->setTargetTriple(tm->getTargetTriple().str());
+  optimize_module(*module, opt_level, tm.get());
+
+  Error err = jit->addIRModule(orc::ThreadSafeModule(move(module), move(llvm)));
+  if (err) {
+    jit_error(move(err));
+    return false;
+  }
+  return true;
+}
+
+void *Jit::lookup(const string &name) {
+  auto sym = jit->lookup(name);
+  if (!sym) {
+    jit_error(sym.takeError());
+    return NULL;
+  }
+  return jitTargetAddressToPointer<void *>(sym->getAddress());
+}
+
+int jit_run(unique_ptr<LLVMContext> llvm, unique_ptr<Module> module,
+            int opt_level, vector<string> args, PhaseTimer &timer) {
+  unique_ptr<Jit> jit = Jit::create(opt_level);
+  if (!jit || !jit->add(move(llvm), move(module))) return -1;
+  timer.end("optimize");
+
+  /* the module is compiled when main is first looked up */
+  auto main_fn = (int (*)(int, char **))jit->lookup("main");
+  if (!main_fn) return -1;
+  timer.end("jit");
+
+  vector<char *> argv;
+  for (string &arg : args) argv.push_back(&arg[0]);
+  argv.push_back(NULL);
+  int status = main_fn(args.size(), argv.data());
+  timer.end("run");
+  return status;
+}
@@ -0,0 +1,36 @@
+#include "optimizer.h"
+
+#include "llvm/Passes/PassBuilder.h"
+
+using namespace llvm;
+
+void optimize_module(Module &m, int level, TargetMachine *tm) {
+  LoopAnalysisManager lam;
+  FunctionAnalysisManager fam;
+  CGSCCAnalysisManager cgam;
+  ModuleAnalysisManager mam;
+
+  PassBuilder pb(tm);
+  pb.registerModuleAnalyses(mam);
+  pb.registerCGSCCAnalyses(cgam);
+  pb.registerFunctionAnalyses(fam);
+  pb.registerLoopAnalyses(lam);
+  pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+  ModulePassManager mpm;
+  switch (level) {
+    case 0:
+      mpm = pb.buildO0DefaultPipeline(OptimizationLevel::O0);
+      break;
+    case 1:
+      mpm = pb.buildPerModuleDefaultPipeline(OptimizationLevel::O1);
+      break;
+    case 2:
+      mpm = pb.buildPerModuleDefaultPipeline(OptimizationLevel::O2);
+      break;
+    default:
+      mpm = pb.buildPerModuleDefaultPipeline(OptimizationLevel::O3);
+      break;
+  }
+  mpm.run(m, mam);
+}
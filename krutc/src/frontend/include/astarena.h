@@ -0,0 +1,102 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/*
+  Bump allocator that owns every AST node (Stmts, ExprStmts, Type_s) of one
+  compilation, whether made by the parser or by the typechecker. Nodes are
+  created with make<T>(...) and are never freed one at a time: the whole
+  arena is released at once, running the nodes' destructors (which free
+  their strings and vectors) in reverse order of creation.
+
+  Nodes made one after the other sit next to each other in memory, so a
+  parent and its children usually share cache lines.
+*/
+class AstArena {
+  struct Dtor {
+    void *obj;
+    void (*destroy)(void *);
+  };
+
+  std::vector<char *> blocks;
+  std::vector<Dtor> dtors;
+  char *curr = NULL; /* next free byte in the newest block */
+  char *end = NULL;  /* one past the newest block */
+
+  size_t num_nodes = 0;
+  size_t bytes_used = 0;
+  size_t bytes_reserved = 0;
+
+  void *allocate(size_t size, size_t align) {
+    uintptr_t p = ((uintptr_t)curr + align - 1) & ~(uintptr_t)(align - 1);
+    if (!curr || p + size > (uintptr_t)end) {
+      new_block(size + align);
+      p = ((uintptr_t)curr + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    curr = (char *)(p + size);
+    bytes_used += size;
+    return (void *)p;
+  }
+
+  void new_block(size_t min_size) {
+    size_t size = min_size > ARENA_BLOCK_SIZE ? min_size : ARENA_BLOCK_SIZE;
+    char *block = static_cast<char *>(malloc(size));
+    if (!block) throw std::bad_alloc();
+    blocks.push_back(block);
+    bytes_reserved += size;
+    curr = block;
+    end = block + size;
+  }
+
+ public:
+  AstArena() {}
+  AstArena(const AstArena &) = delete;
+  AstArena &operator=(const AstArena &) = delete;
+  ~AstArena() { release(); }
+
+  template <class T, class... Args>
+  T *make(Args &&...args) {
+    T *node = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    if (!std::is_trivially_destructible<T>::value) {
+      dtors.push_back({node, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+    num_nodes++;
+    return node;
+  }
+
+  /* destroys every node. Pointers into the arena are dangling afterwards */
+  void release() {
+    for (size_t i = dtors.size(); i > 0; i--) {
+      dtors[i - 1].destroy(dtors[i - 1].obj);
+    }
+    dtors.clear();
+    for (char *block : blocks) {
+      free(block);
+    }
+    blocks.clear();
+    curr = end = NULL;
+  }
+
+  size_t get_num_nodes() const { return num_nodes; }
+  size_t get_bytes_used() const { return bytes_used; }
+  size_t get_bytes_reserved() const { return bytes_reserved; }
+  size_t get_num_blocks() const { return blocks.size(); }
+
+  void print_stats(std::ostream &os) const {
+    os << "ast nodes:      " << num_nodes << std::endl;
+    os << "ast bytes:      " << bytes_used << " used, " << bytes_reserved
+       << " reserved in " << blocks.size() << " blocks" << std::endl;
+  }
+};
+
+#endif  // AST_ARENA_H
@@ -0,0 +1,76 @@
+#ifndef BC_COMPILER_H
+#define BC_COMPILER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bytecode.h"
+#include "symboltable.h"
+#include "tree.h"
+#include "typechecker.h"
+
+/* where a variable lives; see CodeGenVar */
+struct BcVar {
+  enum Kind { LOCAL, GLOBAL, FIELD };
+  Kind kind;
+  int index; /* a register or a global; unused for fields, which are found
+                by name */
+  Type_ *type;
+};
+
+/* jumps to patch once the end of a loop, or where `continue` goes, is
+   known */
+struct BcLoop {
+  std::vector<int> breaks;
+  std::vector<int> conts;
+};
+
+/*
+  Everything the bytecode compiler knows about one program while it
+  compiles it, passed down through Stmt::compile() like CodeGenContext. It
+  follows codegen.cpp closely: the same scoping, layouts and conversions,
+  so that a program means the same thing interpreted or compiled.
+*/
+struct BcCompiler {
+  BcModule &module;
+  TypeChecker &typechecker;
+
+  /* innermost last; the first scope holds the globals */
+  std::vector<std::unordered_map<Symbol, BcVar>> scopes;
+  std::vector<BcLoop> loops;
+
+  BcMethod *method = NULL;        /* the method being compiled */
+  MethodStmt *curr_method = NULL; /* NULL at top level and in inits */
+  BcClass *this_class = NULL;     /* whose layout fields are read with */
+  /* registers below locals_end hold variables; temporaries are taken from
+     top up, and all are free again after each statement */
+  int locals_end = 0;
+  int top = 0;
+  /* where the last instruction starts, and the last offset a jump goes
+     to; a move can fold into the instruction before it if no jump lands
+     between them */
+  int last_op = -1;
+  int last_label = -1;
+  Type_ *expected_type = NULL;    /* see CodeGenContext */
+
+  std::unordered_map<std::string, BcClass *> classes;
+  std::unordered_map<BcClass *, const AttrTable *> attrs;
+  std::unordered_map<Symbol, int> vtable_slots; /* see vtable_slots() */
+  /* see CodeGenContext::method_bodies */
+  std::unordered_map<MethodStmt *,
+                     std::vector<std::pair<BcClass *, BcMethod *>>>
+      method_bodies;
+  std::unordered_map<int64_t, int> const_index;
+
+  BcCompiler(BcModule &module, TypeChecker &typechecker)
+      : module(module), typechecker(typechecker) {}
+};
+
+/* compiles a typechecked PROGRAM to bytecode */
+std::unique_ptr<BcModule> compile_bytecode(Program &program,
+                                           TypeChecker &typechecker);
+
+#endif  // BC_COMPILER_H
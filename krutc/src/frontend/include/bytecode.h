@@ -0,0 +1,186 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tree.h"
+
+/*
+  The bytecode the interpreter runs (see interpreter.h). Every value is a
+  64-bit slot holding the same bits compiled code would: an int, a deci's
+  bits, a bool (0 or 1), a char (0..255), or a pointer to a runtime string,
+  list or set, or to an object. An object is a header word, which points at
+  its class's BcClass::header, followed by one slot per attribute in attr
+  table order.
+
+  Code is a sequence of 32-bit words: an opcode, then its operands. Methods
+  work on registers, the slots of their frame: the arguments (`this`
+  first), then the variables, then temporaries. Operands named d, a, b and
+  c are registers, d the one written; k indexes BcModule::consts and i is
+  an immediate. A call's arguments are consecutive registers from BASE up,
+  which become the first registers of the callee's frame; frames sit one
+  above the other on one stack.
+
+  Opcodes are typed: the compiler picks the int, deci or string form from
+  the operands' types, so the interpreter never looks at a value's type.
+  X(name, words) lists each opcode with its length, operands included.
+*/
+#define BC_OPCODES(X)                                                       \
+  X(OP_MOVE, 3)         /* d a */                                           \
+  X(OP_LOADK, 3)        /* d k */                                           \
+  X(OP_LOAD_GLOBAL, 3)  /* d global */                                      \
+  X(OP_STORE_GLOBAL, 3) /* global a */                                      \
+  X(OP_LOAD_FIELD, 3)   /* d attr: attr of `this` (register 0) */           \
+  X(OP_STORE_FIELD, 3)  /* attr a */                                        \
+                                                                            \
+  /* ints (and chars and bools) */                                          \
+  X(OP_ADD_I, 4) /* d a b */                                                \
+  X(OP_ADD_IK, 4) /* d a i */                                               \
+  X(OP_SUB_I, 4)                                                            \
+  X(OP_MUL_I, 4)                                                            \
+  X(OP_DIV_I, 5) /* d a b line: fails on division by zero */                \
+  X(OP_ABS_I, 3)                                                            \
+  X(OP_EQ_I, 4)                                                             \
+  X(OP_NE_I, 4)                                                             \
+  X(OP_LT_I, 4)                                                             \
+  X(OP_LE_I, 4)                                                             \
+  X(OP_GT_I, 4)                                                             \
+  X(OP_GE_I, 4)                                                             \
+  X(OP_NOT, 3)                                                              \
+                                                                            \
+  /* decis */                                                               \
+  X(OP_ADD_D, 4)                                                            \
+  X(OP_SUB_D, 4)                                                            \
+  X(OP_MUL_D, 4)                                                            \
+  X(OP_DIV_D, 4)                                                            \
+  X(OP_EQ_D, 4)                                                             \
+  X(OP_NE_D, 4)                                                             \
+  X(OP_LT_D, 4)                                                             \
+  X(OP_LE_D, 4)                                                             \
+  X(OP_GT_D, 4)                                                             \
+  X(OP_GE_D, 4)                                                             \
+                                                                            \
+  /* strings */                                                             \
+  X(OP_CONCAT_S, 4)                                                         \
+  X(OP_EQ_S, 4)                                                             \
+  X(OP_NE_S, 4)                                                             \
+  X(OP_LT_S, 4)                                                             \
+  X(OP_LE_S, 4)                                                             \
+  X(OP_GT_S, 4)                                                             \
+  X(OP_GE_S, 4)                                                             \
+  X(OP_LEN_S, 3)                                                            \
+  X(OP_GET_S, 5) /* d s index line */                                       \
+                                                                            \
+  /* conversions, d a */                                                    \
+  X(OP_I2D, 3)                                                              \
+  X(OP_D2I, 3)                                                              \
+  X(OP_I2B, 3)      /* nonzero -> 1 */                                      \
+  X(OP_D2B, 3)      /* nonzero -> 1 */                                      \
+  X(OP_NARROW_C, 3) /* keep the low 8 bits, as a char */                    \
+  X(OP_NARROW_B, 3) /* keep the low bit, as a bool */                       \
+                                                                            \
+  /* control flow; targets are code offsets */                              \
+  X(OP_JUMP, 2)          /* target */                                       \
+  X(OP_JUMP_IF_FALSE, 3) /* a target */                                     \
+  X(OP_JUMP_IF_TRUE, 3)  /* a target */                                     \
+  X(OP_LOOP, 2)          /* target: a jump back to the top of a loop */     \
+  /* an int compare and a jump, taken if it holds: a b target */            \
+  X(OP_JEQ_I, 4)                                                            \
+  X(OP_JNE_I, 4)                                                            \
+  X(OP_JLT_I, 4)                                                            \
+  X(OP_JLE_I, 4)                                                            \
+  X(OP_JGT_I, 4)                                                            \
+  X(OP_JGE_I, 4)                                                            \
+  /* the same against an immediate: a i target */                           \
+  X(OP_JEQ_IK, 4)                                                           \
+  X(OP_JNE_IK, 4)                                                           \
+  X(OP_JLT_IK, 4)                                                           \
+  X(OP_JLE_IK, 4)                                                           \
+  X(OP_JGT_IK, 4)                                                           \
+  X(OP_JGE_IK, 4)                                                           \
+                                                                            \
+  X(OP_CALL, 4)         /* d m base: calls global method m */               \
+  X(OP_CALL_VIRTUAL, 5) /* d slot base line: calls the method in vtable    \
+                           slot SLOT of the object in BASE */               \
+  X(OP_CALL_NATIVE, 4)  /* d n base: runtime function n of bc_natives() */  \
+  X(OP_NEW, 4)          /* d class base: a new object, which BASE holds     \
+                           while its class's init runs */                   \
+  X(OP_RETURN, 2)       /* a */
+
+#define BC_OPCODE_ENUM(name, words) name,
+enum Opcode : int32_t { BC_OPCODES(BC_OPCODE_ENUM) };
+#undef BC_OPCODE_ENUM
+
+/* the number of words each instruction takes, by opcode */
+#define BC_OPCODE_WORDS(name, words) words,
+constexpr int BC_WORDS[] = {BC_OPCODES(BC_OPCODE_WORDS)};
+#undef BC_OPCODE_WORDS
+
+struct BcMethod {
+  std::string name;
+  MethodStmt *stmt = NULL; /* NULL for top-level code and class inits */
+  int nargs = 0;           /* `this` included */
+  int nlocals = 0;         /* the arguments, then declared variables */
+  int nregs = 0;           /* the frame: locals, then temporaries */
+  std::vector<int32_t> code;
+
+  /* tiering (global methods only) */
+  int64_t hotness = 0; /* calls plus loop back edges */
+  bool tierable = false; /* uses nothing the JIT cannot share */
+  std::vector<BcMethod *> callees; /* global methods it calls */
+  bool queued = false;
+  /* the compiled method, once there is one: takes the arguments, and
+     returns the value, as slots */
+  std::atomic<int64_t (*)(int64_t *)> native{NULL};
+};
+
+struct BcClass {
+  /* what an object's header points at: the class name, where the runtime's
+     krut_class_name() expects it, then the class */
+  const void *header[2];
+  std::string name;
+  ClassStmt *stmt;
+  int id;
+  int nattrs;
+  BcMethod *init = NULL; /* sets each attribute to its initial value */
+  /* the method in each slot of vtable_slots(), NULL where the class has
+     none */
+  std::vector<BcMethod *> vtable;
+};
+
+/* a runtime function, called with its arguments as slots */
+struct BcNative {
+  const char *name;
+  int64_t (*fn)(int64_t *args);
+  int nargs;
+};
+const std::vector<BcNative> &bc_natives();
+/* the index of runtime function NAME in bc_natives(), or -1 */
+int bc_native(const std::string &name);
+
+/* a compiled program */
+struct BcModule {
+  std::vector<std::unique_ptr<BcMethod>> methods;
+  std::vector<std::unique_ptr<BcClass>> classes;
+  std::vector<int64_t> consts;
+  std::deque<std::string> strings; /* string constants point into these */
+
+  BcMethod *top = NULL;  /* the top-level statements */
+  BcMethod *main = NULL; /* the KrutC main, if any */
+  std::unordered_map<MethodStmt *, BcMethod *> global_methods;
+
+  /* top-level variables, by the statement that declares them */
+  std::unordered_map<AttrStmt *, int> global_index;
+  std::unique_ptr<int64_t[]> globals;
+
+  /* opcodes have been replaced by where the interpreter handles them */
+  bool threaded = false;
+};
+
+#endif  // BYTECODE_H
@@ -1,16 +1,58 @@
 #ifndef CODEGEN_H
 #define CODEGEN_H
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
 #include "tree.h"
+#include "typechecker.h"
+
+struct CodeGenContext;
 
+/*
+  Lowers a typechecked program to one LLVM module. The module defines a C
+  `main` that runs the program's top-level statements in order, then calls
+  the KrutC `main` method if there is one. Builtin classes and methods are
+  calls into the runtime library (src/runtime), which the module must be
+  linked against.
+*/
 class CodeGen {
-  Program program;
+  Program &program;         /* owned by the caller */
+  TypeChecker &typechecker; /* for the classes' feature tables */
   std::string filename;
+  std::unique_ptr<llvm::LLVMContext> llvm;
+  std::unique_ptr<llvm::Module> module;
+
+  void declare_classes(CodeGenContext &cg);
+  void declare_methods(CodeGenContext &cg);
+  void build_vtables(CodeGenContext &cg);
+  void emit_main(CodeGenContext &cg);
 
  public:
-  CodeGen(Program program, std::string filename) : program(program), filename(filename) {}
+  CodeGen(Program &program, TypeChecker &typechecker, std::string filename)
+      : program(program), typechecker(typechecker), filename(filename) {}
 
+  /* builds the module; returns the number of errors (a module that does
+     not verify) */
   int codegen();
+  /* builds a module of only the global METHODS (and their callees, which
+     must be among them), for a program that is otherwise running
+     elsewhere: the top-level variables are the 64-bit slots at GLOBALS.
+     Each method M also gets an entry point, PREFIX + M's name, of type
+     int64_t(int64_t *args) that takes and returns slots */
+  int codegen_methods(const std::vector<MethodStmt *> &methods,
+                      const std::unordered_map<AttrStmt *, void *> &globals,
+                      const std::string &prefix);
+  llvm::Module *get_module() { return module.get(); }
+  /* hand the module, and the context it lives in, to whoever runs it */
+  std::unique_ptr<llvm::Module> take_module() { return std::move(module); }
+  std::unique_ptr<llvm::LLVMContext> take_context() { return std::move(llvm); }
+  /* writes the module to PATH: bitcode if it ends in .bc, else text */
+  bool write(const std::string &path);
 };
 
-#endif  // CODEGEN_H
\ No newline at end of file
+#endif  // CODEGEN_H
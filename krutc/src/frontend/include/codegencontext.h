@@ -0,0 +1,101 @@
+#ifndef CODEGEN_CONTEXT_H
+#define CODEGEN_CONTEXT_H
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "featuretable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "symboltable.h"
+#include "tree.h"
+
+/*
+  Where a variable lives: a local is an alloca in its method's entry block,
+  a variable declared outside any method is an LLVM global, and an attribute
+  is a field of `this`, found by name in the layout of the class whose code
+  is being emitted.
+*/
+struct CodeGenVar {
+  enum Kind { LOCAL, GLOBAL, FIELD };
+  Kind kind;
+  llvm::Value *ptr; /* NULL for fields */
+  Type_ *type;      /* the declared type */
+};
+
+/*
+  A class of the program, as laid out in memory. An object is a pointer to
+  { vtable, fields... }: the first parent's fields where they are in the
+  parent, so its methods run on the object unchanged, then the others,
+  largest first, so that none needs padding. The vtable is
+    [0] the class name (a C string)
+    [1 + s] the method in vtable slot s (see vtable_slots()), or NULL
+  A method call loads the vtable and then the slot; an attribute is at a
+  constant offset in the class whose code reads it.
+*/
+struct CodeGenClass {
+  int id; /* dense, in order of definition */
+  ClassStmt *stmt;
+  const MethodTable *methods;
+  const AttrTable *attrs;
+  llvm::StructType *type;
+  std::vector<Symbol> fields; /* the attributes in layout order */
+  std::unordered_map<Symbol, int> field_index; /* their struct elements */
+  llvm::GlobalVariable *vtable = NULL;
+  llvm::Function *init = NULL; /* runs the attribute initializers */
+  llvm::Function *make = NULL; /* `new`: allocates, then calls init */
+  std::vector<llvm::Function *> slots; /* the method in each vtable slot */
+};
+
+struct CodeGenLoop {
+  llvm::BasicBlock *brk;  /* the block after the loop */
+  llvm::BasicBlock *cont; /* the next iteration's first block */
+};
+
+/*
+  Everything codegen knows about one program while it lowers it. Like
+  SemaContext, it is passed down through Stmt::codegen(), and the helpers
+  that use it live in codegen.cpp.
+*/
+struct CodeGenContext {
+  llvm::LLVMContext &llvm;
+  llvm::Module &module;
+  llvm::IRBuilder<> builder;
+  std::string filename;
+
+  /* innermost last; the first scope holds the globals */
+  std::vector<std::unordered_map<Symbol, CodeGenVar>> scopes;
+  std::vector<CodeGenLoop> loops;
+
+  llvm::Function *func = NULL;    /* the function being emitted */
+  MethodStmt *curr_method = NULL; /* NULL at top level */
+  CodeGenClass *this_class = NULL; /* whose layout fields are read with */
+  llvm::Value *this_ptr = NULL;
+  /* the type the value being emitted is converted to, so an empty list
+     literal knows what it holds */
+  Type_ *expected_type = NULL;
+
+  std::map<std::string, CodeGenClass> classes;
+  std::unordered_map<Symbol, int> vtable_slots; /* by method name */
+  std::unordered_map<MethodStmt *, llvm::Function *> global_methods;
+  /* the functions to emit for each class method body: the defining class's
+     own, and a copy for each subclass whose attr layout differs */
+  std::unordered_map<MethodStmt *,
+                     std::vector<std::pair<CodeGenClass *, llvm::Function *>>>
+      method_bodies;
+  std::unordered_map<std::string, llvm::GlobalVariable *> str_consts;
+  llvm::StructType *list_type = NULL; /* KrutList; see list_field() */
+
+  CodeGenContext(llvm::LLVMContext &llvm, llvm::Module &module,
+                 std::string filename)
+      : llvm(llvm),
+        module(module),
+        builder(llvm),
+        filename(std::move(filename)) {}
+};
+
+#endif  // CODEGEN_CONTEXT_H
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace basic_classes {
@@ -13,13 +14,11 @@ const std::string Bool = "bool";
 const std::string Char = "char";
 const std::string String = "string";
 const std::string List = "list";
-
-// TODO:
 const std::string Set = "set";
 const std::string Deci = "deci";
 const std::string Dict = "dict";
 
-inline bool is_basic_class(std::string &cname) {
+inline bool is_basic_class(const std::string &cname) {
   return cname == Void || cname == Object || cname == Int || cname == Bool ||
          cname == String || cname == Char || cname == List || cname == Set ||
          cname == Deci || cname == Dict;
@@ -89,6 +88,18 @@ inline bool is_binop(std::string &b) {
          b == PlusEquals || b == MinusEquals || b == TimesEquals ||
          b == DivideEquals || b == Define;
 }
+
+/* =, +=, -=, *= and /= */
+inline bool is_assign_op(const std::string &b) {
+  return b == Define || b == PlusEquals || b == MinusEquals ||
+         b == TimesEquals || b == DivideEquals;
+}
+
+/* the operators whose value is a bool */
+inline bool is_bool_op(const std::string &b) {
+  return b == LessThan || b == GreaterThan || b == LEQ || b == GEQ ||
+         b == Equal || b == NotEqual || b == And || b == Or;
+}
 }  // namespace lexing
 
 namespace typechecking {
@@ -106,6 +117,13 @@ const std::string Pop_Back = "pop_back";
 const std::string Push_Front = "push_front";
 const std::string Pop_Front = "pop_front";
 const std::string Contains = "contains";
+const std::string Get = "get";
+const std::string Keys = "keys";
+const std::string Values = "values";
+/* the formals of dict methods, which specialize to the key and value
+   types */
+const std::string Dict_Key = "key";
+const std::string Dict_Value = "value";
 
 /* global builtin methods */
 const std::string Main = "main";
@@ -179,16 +197,21 @@ static std::unordered_map<std::string, TokenType> KEYWORDS_STR_TO_TTYPE{
     {"BREAK", BREAK},   {"NONE", NONE},
     {"NEW", NEW}};
 
+/* a lower number binds tighter */
 static std::unordered_map<std::string, int> BINOP_PRECEDENCE = {
-    {"+", 0},  {"-", 0},  {"*", 1},  {"/", 1},
+    {"*", 0},  {"/", 0},
+
+    {"+", 1},  {"-", 1},
+
+    {"<", 2},  {">", 2},  {"<=", 2}, {">=", 2},
 
-    {"<", 2},  {">", 2},
+    {"==", 3}, {"!=", 3},
 
-    {"<=", 3}, {">=", 3}, {"==", 3}, {"!=", 3}, {"&&", 3}, {"||", 3},
+    {"&&", 4},
 
-    {"+=", 4}, {"-=", 4}, {"/=", 5}, {"*=", 5},
+    {"||", 5},
 
-    {"=", 6},
+    {"=", 6},  {"+=", 6}, {"-=", 6}, {"*=", 6}, {"/=", 6},
 };
 
 #endif  // CONSTANTS_H
\ No newline at end of file
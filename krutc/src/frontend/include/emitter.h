@@ -0,0 +1,35 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <memory>
+#include <string>
+
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+/*
+  Ahead-of-time output: object files for the host's target triple, and
+  executables linked against the runtime library (libkrutrt.a).
+*/
+
+/* the machine to compile for at -O OPT_LEVEL. CPU is an LLVM processor
+   name, "native" for the host's own CPU and features, or empty for a
+   generic one. Returns NULL, having printed why, on failure */
+std::unique_ptr<llvm::TargetMachine> create_target_machine(
+    const std::string &cpu, int opt_level);
+
+/* gives M the target machine's triple and data layout; do this before
+   optimizing M */
+void set_target(llvm::Module &m, llvm::TargetMachine &tm);
+
+/* writes M as an object file to PATH */
+bool emit_object(llvm::Module &m, llvm::TargetMachine &tm,
+                 const std::string &path);
+
+/* writes M as an executable to PATH: an object file, linked with $KRUTRT
+   if it is set, or else with the runtime library beside krutc or in the
+   lib directory it was installed next to */
+bool emit_executable(llvm::Module &m, llvm::TargetMachine &tm,
+                     const std::string &path);
+
+#endif  // EMITTER_H
@@ -29,10 +29,12 @@ class Error {
         lineno(lineno),
         err_msg(err_msg) {}
 
-  virtual void print() {
-    llvm::errs().changeColor(llvm::raw_ostream::RED, true) << "ERROR ";
-    llvm::errs().resetColor() << ErrorTypeStrings[err_type] << ":" << filename
-                              << ":" << lineno << ": " << err_msg << "\n";
+  void print() { print(llvm::errs()); }
+
+  virtual void print(llvm::raw_ostream& os) {
+    os.changeColor(llvm::raw_ostream::RED, true) << "ERROR ";
+    os.resetColor() << ErrorTypeStrings[err_type] << ":" << filename << ":"
+                    << lineno << ": " << err_msg << "\n";
   }
 
   virtual ~Error() = default;
@@ -44,10 +46,12 @@ class Warning : public Error {
           std::string warn_msg)
       : Error(err_type, filename, lineno, warn_msg) {}
 
-  void print() override {
-    llvm::errs().changeColor(llvm::raw_ostream::MAGENTA, true) << "WARNING ";
-    llvm::errs().resetColor() << ErrorTypeStrings[err_type] << ":" << filename
-                              << ":" << lineno << ": " << err_msg << "\n";
+  using Error::print;
+
+  void print(llvm::raw_ostream& os) override {
+    os.changeColor(llvm::raw_ostream::MAGENTA, true) << "WARNING ";
+    os.resetColor() << ErrorTypeStrings[err_type] << ":" << filename << ":"
+                    << lineno << ": " << err_msg << "\n";
   }
 };
 
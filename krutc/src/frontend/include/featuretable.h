@@ -0,0 +1,108 @@
+#ifndef FEATURE_TABLE_H
+#define FEATURE_TABLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "symboltable.h"
+#include "tree.h"
+
+#define FEATURE_TABLE_MIN_BUCKETS 8 /* must be a power of two */
+
+/*
+  The finalized methods (or attributes) of one class, inherited ones
+  included, keyed by interned name. Every entry has a slot: entries are kept
+  in slot order, so the table is also the class's vtable (or field) layout.
+
+  A class's table starts as a copy of its first parent's, so the first
+  parent's layout is a prefix of the child's. Entries of later parents that
+  are not already present are appended, left to right, then the class's own
+  features either override an inherited entry in place or are appended.
+*/
+template <class T>
+class FeatureTable {
+ public:
+  struct Entry {
+    Symbol name;
+    int slot;
+    int owner;  /* id of the class that defines it, -1 for globals */
+    T *feature; /* MethodStmt: its ret type and formals are the signature */
+  };
+
+ private:
+  std::vector<Entry> entries; /* indexed by slot */
+
+  /* open-addressed index into entries: slot + 1, 0 if empty */
+  std::vector<int> buckets;
+
+  size_t bucket_of(Symbol name) const {
+    uint32_t h = name * 0x9E3779B1u;
+    return (h ^ (h >> 16)) & (buckets.size() - 1);
+  }
+
+  /* the bucket holding NAME, or the empty bucket where it would go */
+  size_t probe(Symbol name) const {
+    size_t mask = buckets.size() - 1;
+    size_t i = bucket_of(name);
+    while (buckets[i] && entries[buckets[i] - 1].name != name) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+  void append(Symbol name, T *feature, int owner) {
+    /* keep the load factor under 1/2 */
+    if ((entries.size() + 1) * 2 > buckets.size()) {
+      rehash(buckets.empty() ? FEATURE_TABLE_MIN_BUCKETS
+                             : buckets.size() * 2);
+    }
+    int slot = (int)entries.size();
+    entries.push_back({name, slot, owner, feature});
+    buckets[probe(name)] = slot + 1;
+  }
+
+  void rehash(size_t size) {
+    buckets.assign(size, 0);
+    for (const Entry &e : entries) {
+      buckets[probe(e.name)] = e.slot + 1;
+    }
+  }
+
+ public:
+  /* one hash probe; NULL if the class has no feature called NAME */
+  const Entry *lookup(Symbol name) const {
+    if (buckets.empty()) return NULL;
+    int b = buckets[probe(name)];
+    return b ? &entries[b - 1] : NULL;
+  }
+
+  /* adds an inherited entry unless a feature called E.name is present */
+  void inherit(const Entry &e) {
+    if (!lookup(e.name)) append(e.name, e.feature, e.owner);
+  }
+
+  /* adds a feature defined by class OWNER. It takes over the slot of an
+     inherited feature of the same name; a second definition by the same
+     class is ignored (it has already been reported) */
+  void define(Symbol name, T *feature, int owner) {
+    if (buckets.empty()) rehash(FEATURE_TABLE_MIN_BUCKETS);
+    int b = buckets[probe(name)];
+    if (!b) {
+      append(name, feature, owner);
+      return;
+    }
+    Entry &e = entries[b - 1];
+    if (e.owner != owner) {
+      e.feature = feature;
+      e.owner = owner;
+    }
+  }
+
+  const std::vector<Entry> &get_entries() const { return entries; }
+  size_t size() const { return entries.size(); }
+};
+
+typedef FeatureTable<MethodStmt> MethodTable;
+typedef FeatureTable<AttrStmt> AttrTable;
+
+#endif  // FEATURE_TABLE_H
@@ -1,9 +1,18 @@
+#ifndef FILE_STREAM_BUFFER_H
+#define FILE_STREAM_BUFFER_H
+
 #include <deque>
 #include <fstream>
 #include <iostream>
 
 #define BUFFER_SIZE 256
 
+/*
+  Char-at-a-time reader over an ifstream. The Lexer now reads from
+  SourceBuffer (sourcebuffer.h), which exposes the same get_next()/lookahead()/
+  has_next() interface; this class is kept for callers that want a bounded
+  streaming window instead of the whole file.
+*/
 class FileStreamBuffer {
  public:
   FileStreamBuffer(const std::string filepath) : file(filepath) {
@@ -44,3 +53,5 @@ class FileStreamBuffer {
     }
   }
 };
+
+#endif  // FILE_STREAM_BUFFER_H
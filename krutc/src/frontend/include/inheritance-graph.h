@@ -8,7 +8,7 @@
 #include <vector>
 
 class InheritanceGraph {
-  std::map<std::string, std::vector<std::string>> parents;
+  const std::map<std::string, std::vector<std::string>>& parents;
 
   void dfs(const std::string& node, std::map<std::string, bool>& visited, std::map<std::string, bool>& recStack,
            std::vector<std::string>& path, std::vector<std::vector<std::string>>& cycles) {
@@ -16,18 +16,21 @@ class InheritanceGraph {
     recStack[node] = true;
     path.push_back(node);
 
-    for (const auto& parent : parents[node]) {
-      if (!visited[parent]) {
-        dfs(parent, visited, recStack, path, cycles);
-      } else if (recStack[parent]) {
-        std::vector<std::string> cycle;
-        auto it = std::find(path.begin(), path.end(), parent);
-        while (it != path.end()) {
-          cycle.push_back(*it);
-          it++;
+    auto entry = parents.find(node);
+    if (entry != parents.end()) {
+      for (const auto& parent : entry->second) {
+        if (!visited[parent]) {
+          dfs(parent, visited, recStack, path, cycles);
+        } else if (recStack[parent]) {
+          std::vector<std::string> cycle;
+          auto it = std::find(path.begin(), path.end(), parent);
+          while (it != path.end()) {
+            cycle.push_back(*it);
+            it++;
+          }
+          cycle.push_back(parent);
+          cycles.push_back(cycle);
         }
-        cycle.push_back(parent);
-        cycles.push_back(cycle);
       }
     }
 
@@ -36,7 +39,7 @@ class InheritanceGraph {
   }
 
  public:
-  InheritanceGraph(std::map<std::string, std::vector<std::string>> parents) : parents(parents) {}
+  InheritanceGraph(const std::map<std::string, std::vector<std::string>>& parents) : parents(parents) {}
 
   void check_for_cycles(std::vector<std::vector<std::string>>& cycles) {
     std::map<std::string, bool> visited;
@@ -0,0 +1,93 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bytecode.h"
+#include "jit.h"
+#include "tree.h"
+#include "typechecker.h"
+
+/* a call to bytecode under way: the caller, and where its call returns */
+struct BcFrame {
+  BcMethod *m;
+  const int32_t *ip; /* the instruction after the call */
+  int64_t *fp;
+  int32_t dst; /* the caller's register that gets the value */
+};
+
+/*
+  Runs a typechecked program as bytecode (see bytecode.h), which starts
+  running as soon as it is compiled, where the JIT would first have to
+  compile and optimize the whole module. Without tiering it never creates
+  a JIT, so it also runs where code cannot be generated at run time.
+
+  When tiered, every call and loop back edge counts against its method,
+  and a global method that gets hot is compiled by the JIT on a background
+  thread, together with the global methods it calls. Calls made after the
+  compiled code is ready go to it instead; a call already running stays
+  interpreted. Methods that create or call into objects are never
+  compiled, since compiled code lays objects out differently.
+*/
+class Interpreter {
+  Program &program;         /* owned by the caller */
+  TypeChecker &typechecker; /* owned by the caller */
+  std::string filename;
+  std::unique_ptr<BcModule> module;
+
+  /* every method's registers, each frame starting at the arguments its
+     caller passed */
+  std::unique_ptr<int64_t[]> stack;
+  int64_t *stack_end = NULL;
+  std::unique_ptr<BcFrame[]> frames;
+  BcFrame *frames_end = NULL;
+
+  /* tiering */
+  bool tiered;
+  int opt_level;
+  int64_t threshold;
+  std::unique_ptr<Jit> jit; /* used only by the tier thread */
+  std::thread tier_thread;
+  std::mutex tier_lock; /* guards the fields below */
+  std::condition_variable tier_ready;
+  std::deque<std::vector<BcMethod *>> tier_queue;
+  bool tier_stop = false;
+  int num_tiered = 0; /* methods compiled */
+  double tier_ms = 0;  /* spent compiling them */
+
+  int64_t execute(BcMethod *m, int64_t *fp);
+  void promote(BcMethod *m);
+  void tier_loop();
+  void tier_compile(const std::vector<BcMethod *> &methods, int n);
+
+ public:
+  /* THRESHOLD is the number of calls and back edges after which a method
+     is compiled; TIERED false interprets everything */
+  Interpreter(Program &program, TypeChecker &typechecker,
+              std::string filename, bool tiered, int opt_level,
+              int64_t threshold = 1000)
+      : program(program),
+        typechecker(typechecker),
+        filename(filename),
+        tiered(tiered),
+        opt_level(opt_level),
+        threshold(threshold) {}
+  ~Interpreter();
+
+  /* compiles the program to bytecode */
+  void compile();
+  /* runs the program like the `main` CodeGen emits; ARGS are the script's
+     arguments, its path first. Returns the exit status */
+  int run(std::vector<std::string> args);
+  void print_stats(std::ostream &os);
+};
+
+#endif  // INTERPRETER_H
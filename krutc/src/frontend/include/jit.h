@@ -0,0 +1,57 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+#include "phasetimer.h"
+
+namespace llvm {
+namespace orc {
+class LLJIT;
+}
+}  // namespace llvm
+
+/*
+  An in-memory compiler for the host, built on LLJIT. Modules it compiles
+  call the runtime library linked into krutc itself, which stands in for
+  libkrutrt.
+*/
+class Jit {
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+  std::unique_ptr<llvm::TargetMachine> tm; /* what the optimizer tunes for */
+  int opt_level;
+
+  Jit() = default;
+
+ public:
+  ~Jit();
+
+  /* a JIT that optimizes at -O OPT_LEVEL; NULL, having printed why, if the
+     host cannot have one */
+  static std::unique_ptr<Jit> create(int opt_level);
+
+  /* optimizes MODULE and adds it to the JIT; false if it cannot be */
+  bool add(std::unique_ptr<llvm::LLVMContext> llvm,
+           std::unique_ptr<llvm::Module> module);
+
+  /* the address of NAME, in any module added so far, compiling the module
+     first if it has not been; NULL if there is no such symbol */
+  void *lookup(const std::string &name);
+};
+
+/*
+  `krutc run`: compiles a module built by CodeGen::codegen() with a Jit and
+  calls its `main`. ARGS are the script's arguments, the script's path
+  first. Returns the script's exit status, or -1 if it could not be
+  compiled.
+*/
+int jit_run(std::unique_ptr<llvm::LLVMContext> llvm,
+            std::unique_ptr<llvm::Module> module, int opt_level,
+            std::vector<std::string> args, PhaseTimer &timer);
+
+#endif  // JIT_H
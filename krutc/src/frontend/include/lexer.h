@@ -3,25 +3,34 @@
 
 #include <iostream>
 
-#include "filestreambuffer.h"
+#include "sourcebuffer.h"
 #include "token.h"
 
 #define MAX_STRING_LEN 1024
 
 class Lexer {
  public:
-  Lexer(const std::string filepath) : buff(filepath), filepath(filepath) {}
+  Lexer(const std::string filepath)
+      : buff(filepath), filepath(filepath), line_start(buff.data()) {}
   Token get_next_token();
   bool has_more();
 
  private:
-  FileStreamBuffer buff;
+  SourceBuffer buff;
   std::string filepath;
   std::string string_err_buff;
 
-  char char_buff[MAX_STRING_LEN];
-
   int curr_lineno = 1;
+  const char *line_start; /* first char of curr_lineno, for columns */
+
+  void newline() {
+    curr_lineno++;
+    line_start = buff.cursor();
+  }
+  Token make_token(TokenType type, const char *start, int column);
+  Token make_token(TokenType type, const char *start, int column, Symbol sym);
+  Token error_token(int lineno, const std::string &err_msg);
+  Token word_token(const char *start, int column);
 
   Token ml_comment();
   int get_string();
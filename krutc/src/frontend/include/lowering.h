@@ -0,0 +1,133 @@
+#ifndef LOWERING_H
+#define LOWERING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "constants.h"
+#include "runtime.h"
+#include "symboltable.h"
+#include "tree.h"
+#include "typechecker.h"
+
+/*
+  What the backends (LLVM codegen and the bytecode compiler) agree on about
+  the typed AST: how a type is represented, and which types the operands
+  and value of a binary operator have. Both run on the same runtime
+  library, so a value means the same thing in either.
+*/
+
+enum TypeClass {
+  T_VOID,
+  T_INT,
+  T_DECI,
+  T_BOOL,
+  T_CHAR,
+  T_OBJECT,
+  T_STRING,
+  T_LIST,
+  T_SET,
+  T_DICT,
+  T_CLASS
+};
+
+inline TypeClass type_class(Type_ *t) {
+  using namespace basic_classes;
+  if (!t) return T_OBJECT;
+  const std::string &name = t->get_name();
+  if (name == Int) return T_INT;
+  if (name == Deci) return T_DECI;
+  if (name == Bool) return T_BOOL;
+  if (name == Char) return T_CHAR;
+  if (name == Object) return T_OBJECT;
+  if (name == String) return T_STRING;
+  if (name == List) return T_LIST;
+  if (name == Set) return T_SET;
+  if (name == Dict) return T_DICT;
+  if (name == Void) return T_VOID;
+  return T_CLASS;
+}
+
+/* how a list or set with elements of type ELEM stores and compares them,
+   and so a dict its keys or values */
+inline int64_t elem_kind(Type_ *elem) {
+  switch (type_class(elem)) {
+    case T_BOOL:
+    case T_CHAR:
+      return KRUT_KIND_BYTE;
+    case T_DECI:
+      return KRUT_KIND_DECI;
+    case T_STRING:
+      return KRUT_KIND_STR;
+    case T_LIST:
+      return KRUT_KIND_LIST;
+    case T_SET:
+      return KRUT_KIND_SET;
+    case T_DICT:
+      return KRUT_KIND_DICT;
+    default:
+      return KRUT_KIND_BITS;
+  }
+}
+
+/* the type both sides of a binary operator are converted to */
+inline Type_ *operand_type(Type_ *lhs, Type_ *rhs) {
+  if (!lhs) return rhs;
+  if (!rhs) return lhs;
+  TypeClass l = type_class(lhs), r = type_class(rhs);
+  if (l == T_INT && r == T_DECI) return rhs;
+  if (l == T_OBJECT || r != T_OBJECT) return lhs;
+  return rhs;
+}
+
+/* the type of a binary operator's value, other than a comparison's */
+inline Type_ *result_type(Type_ *lhs, Type_ *rhs) {
+  if (type_class(lhs) == T_INT && type_class(rhs) == T_DECI) return rhs;
+  return lhs;
+}
+
+/*
+  The vtable slot of each method name, the same in every class, so that a
+  call through any static type loads vtable[slot] whatever the object's
+  class is. Two names share a slot only if no class has both. Classes are
+  taken in order of definition and each one's methods in method table
+  order, so under single inheritance a class's slots are its parent's
+  followed by its own. A later parent's methods, which are at other
+  offsets in the parent's own table, go to slots that are free in every
+  class that has them; nothing adjusts `this` at the call.
+*/
+inline std::unordered_map<Symbol, int> vtable_slots(
+    TypeChecker &tc, const std::vector<std::string> &classes) {
+  /* the classes that have each name, and the slots each class uses */
+  std::unordered_map<Symbol, std::vector<int>> has;
+  for (size_t c = 0; c < classes.size(); c++) {
+    for (auto &e : tc.get_method_table(classes[c])->get_entries()) {
+      has[e.name].push_back(c);
+    }
+  }
+  std::vector<std::vector<bool>> used(classes.size());
+
+  std::unordered_map<Symbol, int> slots;
+  for (size_t c = 0; c < classes.size(); c++) {
+    for (auto &e : tc.get_method_table(classes[c])->get_entries()) {
+      if (slots.count(e.name)) continue;
+      const std::vector<int> &with = has[e.name];
+      size_t slot = 0;
+      auto taken = [&](int k) {
+        return slot < used[k].size() && used[k][slot];
+      };
+      while (std::any_of(with.begin(), with.end(), taken)) slot++;
+      slots[e.name] = slot;
+      for (int k : with) {
+        if (used[k].size() <= slot) used[k].resize(slot + 1);
+        used[k][slot] = true;
+      }
+    }
+  }
+  return slots;
+}
+
+#endif  // LOWERING_H
@@ -0,0 +1,14 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+/*
+  Runs LLVM's standard pipeline for -O LEVEL (0 to 3) over M. TM, if not
+  NULL, is the machine the code is for, so that passes such as the
+  vectorizers know its costs; M should already have its data layout.
+*/
+void optimize_module(llvm::Module &m, int level, llvm::TargetMachine *tm);
+
+#endif  // OPTIMIZER_H
@@ -6,56 +6,41 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "astarena.h"
 #include "constants.h"
 #include "error.h"
+#include "symboltable.h"
 #include "tokenbuffer.h"
 #include "tree.h"
-
-static int get_op_precedence(std::string op) { return BINOP_PRECEDENCE[op]; }
-
-/*
-  Class used for parsing. When parsing an expression, will push all expr tokens
-  into seperate deque in order to properly parse expressions
-*/
-class ExprTQ {
- public:
-  int lineno = 0;
-  int binop_index = -1;
-  int binop_prec = -1;
-  // int paren_stack = 0;
-  std::deque<Token> tq;
-
-  void dump() {
-    for (Token t : tq) {
-      if (t.get_str() == "") {
-        std::cout << t.get_type_str() + " ";
-      } else {
-        std::cout << t.get_str() + " ";
-      }
-    }
-    std::cout << std::endl;
-  }
-};
+#include "typecontext.h"
 
 class Parser {
  public:
   int parser_errors = 0;
   bool debug = false;
 
-  Parser(std::string filename, bool debug, bool token_dump)
-      : tbuff(filename, token_dump), debug(debug), filename(filename) {}
+  Parser(std::string filename, AstArena &arena, TypeContext &types,
+         bool debug, bool token_dump)
+      : debug(debug),
+        tbuff(filename, token_dump),
+        arena(arena),
+        types(types),
+        filename(filename) {}
   Program parse_program();
   void token_dump();
   bool check_lexer_errors();
 
  private:
   TokenBuffer tbuff;
+  AstArena &arena; /* owns every node the parser makes */
+  TypeContext &types;
   std::string filename;
 
-  void panic_recover(std::set<std::string> ss);
-  void panic_recover_nest(std::string s, std::string comp, bool show);
-  void debug_msg(std::string);
+  void panic_recover(std::set<Symbol> ss);
+  void panic_recover_nest(Symbol s, Symbol comp, bool show);
+  void debug_msg(const char *s);
 
   Stmt *parse_stmt();
 
@@ -69,25 +54,32 @@ class Parser {
   WhileStmt *parse_while_stmt();
   ForStmt *parse_for_stmt();
 
-  int parse_check_and_pop(std::string s);
+  int parse_check_and_pop(Symbol s);
 
   ClassStmt *parse_class_stmt();
   std::vector<std::string> get_parents();
 
-  ExprTQ expr_tq;
-  bool build_expr_tq(std::string s);
-  void calibrate_expr_tq();
-  ExprStmt *parse_exprstmt();
-  BinopExpr *parse_binopexpr();
+  /* set by expr_fail(); the rest of the expression is then skipped */
+  bool expr_error = false;
+  bool expr_dump = false;
+  int expr_err_lineno = 0;
+  std::string expr_err_msg;
+  int expr_lineno = 0; /* line of the expression being parsed */
+  void expr_fail(int lineno, std::string err_msg, bool dump);
+  void expr_recover(Symbol end);
+  bool at_expr_end(Symbol end);
+  void expect_close(Symbol close, int lineno);
+
+  ExprStmt *parse_exprstmt(Symbol end);
+  ExprStmt *parse_binopexpr(int max_prec);
+  ExprStmt *parse_postfixexpr();
+  ExprStmt *parse_primaryexpr();
 
   SetConstExpr *parse_set_const_expr();
   ListConstExpr *parse_list_const_expr();
-  ExprList parse_comma_separated_exprlist();
-  DispatchExpr *parse_dispexpr();
-  ListElemRef *parse_list_elem_ref_expr();
-  SublistExpr *parse_sublist_expr(int, ExprStmt *);
-  // SetConstExpr *parse_set_const_expr();
-  int get_str_idx_expr_tq(std::string);
+  ExprList parse_comma_separated_exprlist(Symbol close);
+  DispatchExpr *parse_dispexpr(ExprStmt *calling_class, int lineno);
+  ListElemRef *parse_list_elem_ref_expr(ExprStmt *list_name, int lineno);
 
   IntConstExpr *parse_int_const_expr();
   DeciConstExpr *parse_deci_const_expr();
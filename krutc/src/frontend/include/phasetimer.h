@@ -0,0 +1,49 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+  Wall time spent in each phase of a krutc run, for -time. A phase ends at
+  each call to end(), and starts where the previous one ended.
+*/
+class PhaseTimer {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start;
+  Clock::time_point last;
+  std::vector<std::pair<std::string, double>> phases; /* name, ms */
+
+  static double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  }
+
+ public:
+  PhaseTimer() : start(Clock::now()), last(start) {}
+
+  void end(const std::string &phase) {
+    Clock::time_point now = Clock::now();
+    phases.emplace_back(phase, ms(now - last));
+    last = now;
+  }
+
+  void print(std::ostream &os) const {
+    os << "-- time --" << std::endl;
+    std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(2);
+    for (const auto &p : phases) {
+      os << std::left << std::setw(16) << (p.first + ":") << std::right
+         << std::setw(9) << p.second << " ms" << std::endl;
+    }
+    os << std::left << std::setw(16) << "total:" << std::right
+       << std::setw(9) << ms(last - start) << " ms" << std::endl;
+    os.flags(flags);
+  }
+};
+
+#endif  // PHASE_TIMER_H
@@ -1,23 +1,57 @@
 #ifndef SCOPETABLE_H
 #define SCOPETABLE_H
 
-#include <map>
+#include <string>
 #include <vector>
 
 #include "parser.h"
+#include "symboltable.h"
 #include "tree.h"
 
-/* table that maps an object id to its type */
+/*
+  Table that maps an object id to its type. One open-addressed hash from
+  interned id to the innermost binding of that id; each binding links to the
+  one it shadows. Bindings are stacked in order of creation, so the stack is
+  also the undo log: pop_scope() unlinks the current scope's bindings from
+  the top. push_scope() allocates nothing.
+*/
 class ScopeTable {
-  std::vector<std::map<std::string, Type_ *>> table;
+  struct Bucket {
+    Symbol sym;
+    int head; /* innermost binding of sym, -1 if none is in scope */
+  };
+
+  struct Binding {
+    Type_ *type;
+    int depth;  /* scope the binding belongs to */
+    int prev;   /* the binding it shadows, -1 if none */
+    int bucket; /* the bucket that points at it */
+  };
+
+  std::vector<Bucket> buckets; /* (Symbol)-1 marks an empty bucket */
+  size_t num_syms = 0;
+  std::vector<Binding> bindings;
+  std::vector<size_t> scope_marks; /* bindings.size() at each push_scope() */
+  size_t num_changes = 0;          /* bumped by every push, pop and add */
+
+  size_t find_bucket(Symbol s);
+  void rehash();
 
  public:
-  Type_ *lookup(std::string s);
+  ScopeTable();
 
-  Type_ *check_current_scope(std::string);
-  void add_elem(std::string, Type_ *);
+  Type_ *lookup(Symbol s);
+  Type_ *lookup(const std::string &s);
+
+  Type_ *check_current_scope(Symbol s);
+  Type_ *check_current_scope(const std::string &s);
+  void add_elem(Symbol s, Type_ *type);
+  void add_elem(const std::string &s, Type_ *type);
   void push_scope();
   void pop_scope();
+
+  /* equal at two points iff no scope or binding changed in between */
+  size_t get_num_changes() const { return num_changes; }
 };
 
-#endif  // SCOPETABLE_H
\ No newline at end of file
+#endif  // SCOPETABLE_H
@@ -0,0 +1,96 @@
+#ifndef SEMA_CONTEXT_H
+#define SEMA_CONTEXT_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "astarena.h"
+#include "featuretable.h"
+#include "scopetable.h"
+#include "tree.h"
+#include "typecontext.h"
+
+/*
+  What the typechecker knows about the classes of one program. Filled in
+  before any statement is checked and only read afterwards, so the worker
+  threads of -j N share one copy.
+*/
+struct ClassTables {
+  std::vector<std::string> class_names;                 /* class names */
+  std::map<std::string, Type_ *> class_type;            /* class to Type_* */
+  std::map<std::string, ClassStmt *> classes;           /* to ClassStmt* */
+  std::map<std::string, std::vector<std::string>> class_parents;
+  /* dense class ids (0, 1, ...), keyed by the class name's Symbol */
+  std::unordered_map<Symbol, int> class_id;
+  /* row i (ancestor_words words) has bit j set iff class i conforms to j */
+  std::vector<uint64_t> ancestor_bits;
+  size_t ancestor_words = 0;
+  /* finalized feature tables, indexed by class id */
+  std::vector<MethodTable> method_tables;
+  std::vector<AttrTable> attr_tables;
+  std::map<std::string, std::set<MethodStmt *>> class_methods;
+  std::map<std::string, std::set<AttrStmt *>> class_attrs;
+  /* intermediate maps from class name to its parents' meths/attrs */
+  std::map<std::string, std::set<MethodStmt *>> parent_methods;
+  std::map<std::string, std::set<AttrStmt *>> parent_attrs;
+  MethodTable global_method_table; /* global methods */
+};
+
+/*
+  A method body whose check was put off until the first pass over the
+  program is done (-j N). Its diagnostics are spliced back into the first
+  pass's at DIAG_POS, so the output is the same as a serial run's.
+*/
+struct DeferredMethod {
+  MethodStmt *method;
+  std::shared_ptr<const ScopeTable> scope; /* the scope its body sees */
+  size_t diag_pos;
+  std::string diags;
+  int errors = 0;
+  int warnings = 0;
+};
+
+/*
+  Everything the typechecker knows about one program while it checks it. A
+  TypeChecker owns one and passes it down through Stmt::typecheck(), so any
+  number of compilations can be typechecked side by side, in one thread or
+  many, and typechecking the same program again starts from scratch.
+*/
+struct SemaContext {
+  AstArena *arena;    /* owns the nodes the typechecker makes */
+  TypeContext *types; /* interns every Type_ */
+  std::string filename;
+  int semant_errors = 0;
+  int warnings = 0;
+  ScopeTable scopetable;
+  std::shared_ptr<ClassTables> tables; /* shared with -j N workers */
+
+  /* update_cmp_meth() results, keyed by (calling type id << 32 | slot) */
+  std::unordered_map<uint64_t, MethodStmt *> specializations;
+  size_t specializations_made = 0;
+  size_t specialization_lookups = 0;
+
+  bool in_method = false; /* to ensure ReturnExpr* only occur in methods */
+  MethodStmt *curr_method = NULL; /* the method being typechecked */
+  int curr_method_num_nested_rex = 0;
+
+  /* if set, method bodies are queued here instead of being checked */
+  std::vector<DeferredMethod> *deferred = NULL;
+  std::shared_ptr<const ScopeTable> deferred_scope; /* the newest snapshot */
+  size_t deferred_scope_changes = 0;
+  /* if set, diagnostics are written here instead of to stderr */
+  std::string *diag_buf = NULL;
+
+  SemaContext(AstArena &arena, TypeContext &types, std::string filename)
+      : arena(&arena),
+        types(&types),
+        filename(std::move(filename)),
+        tables(std::make_shared<ClassTables>()) {}
+};
+
+#endif  // SEMA_CONTEXT_H
@@ -0,0 +1,58 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+  Read-only view of an entire source file. Regular files are mmap'd so the
+  lexer reads straight out of the page cache; pipes, ttys and stdin ("-") are
+  read once, in bulk, into an owned buffer. Either way the lexer gets one
+  contiguous range and a cursor into it.
+
+  The get_next()/lookahead()/has_next() interface matches FileStreamBuffer, so
+  the two are interchangeable as the Lexer's input.
+*/
+class SourceBuffer {
+ public:
+  SourceBuffer(const std::string filepath);
+  ~SourceBuffer();
+
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+  /* returns the char under the cursor and advances, '\0' at EOF */
+  char get_next() { return curr < end ? *curr++ : '\0'; }
+
+  /* returns the char INDEX places past the cursor, '\0' past EOF */
+  char lookahead(int index) {
+    return index < end - curr ? curr[index] : '\0';
+  }
+
+  bool has_next() { return curr < end; }
+
+  /* raw access for run scanning: [cursor(), limit()) is what is left */
+  const char *cursor() { return curr; }
+  const char *limit() { return end; }
+  void advance(size_t n) { curr = n < (size_t)(end - curr) ? curr + n : end; }
+  void seek(const char *p) { curr = p < end ? p : end; }
+
+  const char *data() { return begin; }
+  size_t size() { return end - begin; }
+  size_t offset() { return curr - begin; }
+
+ private:
+  const char *begin = nullptr;
+  const char *curr = nullptr;
+  const char *end = nullptr;
+
+  void *mapping = nullptr; /* non-null when the file is mmap'd */
+  size_t mapping_len = 0;
+  std::vector<char> owned; /* backing store for the bulk-read fallback */
+
+  bool map_file(int fd, size_t len);
+  bool read_all(int fd);
+};
+
+#endif  // SOURCE_BUFFER_H
@@ -0,0 +1,100 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* an interned string. Two Symbols are equal iff their strings are equal */
+typedef uint32_t Symbol;
+
+/*
+  Symbols that are interned up front, in this order, so the parser can compare
+  punctuation and operators against constants. Keep in sync with the string
+  list in SymbolTable::SymbolTable().
+*/
+namespace sym {
+enum : Symbol {
+  Empty = 0, /* "" -- keywords and EMPTY tokens carry no text */
+
+  /* special chars */
+  OpenP,
+  CloseP,
+  SemiColon,
+  OpenBrack,
+  CloseBrack,
+  OpenBrace,
+  CloseBrace,
+  Period,
+  Comma,
+  Colon,
+
+  /* binops */
+  Plus,
+  Minus,
+  Times,
+  Divide,
+  LessThan,
+  GreaterThan,
+  LEQ,
+  GEQ,
+  Equal,
+  NotEqual,
+  And,
+  Or,
+  PlusEquals,
+  MinusEquals,
+  TimesEquals,
+  DivideEquals,
+  Define,
+
+  NUM_PREDEFINED
+};
+
+inline bool is_binop(Symbol s) { return s >= Plus && s <= Define; }
+}  // namespace sym
+
+/*
+  Process-wide string interner. Identifiers, type names, operators and
+  literals are stored once; tokens and the parser pass around the 32-bit id.
+  Interned strings are never freed or moved, so references returned by str()
+  stay valid for the life of the process.
+
+  Any number of threads may intern() at once. Strings live in fixed-size
+  chunks that are never reallocated, so str() takes no lock: a thread can
+  only hold a Symbol that was published to it by intern().
+*/
+#define SYMBOL_CHUNK_BITS 12
+#define SYMBOL_CHUNK_SIZE (1u << SYMBOL_CHUNK_BITS)
+#define SYMBOL_MAX_CHUNKS 4096 /* up to 16M distinct strings */
+
+class SymbolTable {
+  std::unique_ptr<std::string[]> chunks[SYMBOL_MAX_CHUNKS];
+  size_t num_strs = 0;
+  std::mutex lock; /* guards everything but reads of existing strings */
+
+  /* open-addressed index of the strings: slot holds Symbol + 1, 0 if empty. The
+     full hash is kept alongside so probes rarely touch the strings */
+  std::vector<Symbol> slots;
+  std::vector<uint32_t> hashes;
+
+  SymbolTable();
+  void rehash();
+
+ public:
+  static SymbolTable &global();
+
+  Symbol intern(std::string_view s);
+  const std::string &str(Symbol s) {
+    return chunks[s >> SYMBOL_CHUNK_BITS][s & (SYMBOL_CHUNK_SIZE - 1)];
+  }
+  size_t size() {
+    std::lock_guard<std::mutex> guard(lock);
+    return num_strs;
+  }
+};
+
+#endif  // SYMBOL_TABLE_H
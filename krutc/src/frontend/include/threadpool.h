@@ -0,0 +1,96 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+  Runs a fixed batch of independent tasks on a few threads. Each worker
+  starts with a contiguous run of task indices, so neighbouring tasks (which
+  touch neighbouring nodes) share a thread. A worker takes its own tasks from
+  the front; once they run out it steals from the back of another worker's
+  queue, so one long task does not hold up the rest of the batch.
+
+  Tasks cannot spawn more tasks, so a worker that finds every queue empty is
+  done.
+*/
+class WorkStealingPool {
+  struct Queue {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  size_t num_steals = 0;
+  std::mutex steals_lock;
+
+  bool pop(size_t w, size_t &task) {
+    Queue &q = *queues[w];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tasks.empty()) return false;
+    task = q.tasks.front();
+    q.tasks.pop_front();
+    return true;
+  }
+
+  bool steal(size_t w, size_t &task) {
+    for (size_t i = 1; i < queues.size(); i++) {
+      Queue &q = *queues[(w + i) % queues.size()];
+      std::lock_guard<std::mutex> guard(q.lock);
+      if (q.tasks.empty()) continue;
+      task = q.tasks.back();
+      q.tasks.pop_back();
+      return true;
+    }
+    return false;
+  }
+
+  template <class F>
+  void work(size_t w, F &fn) {
+    size_t task, stolen = 0;
+    while (pop(w, task)) fn(w, task);
+    while (steal(w, task)) {
+      fn(w, task);
+      stolen++;
+    }
+    std::lock_guard<std::mutex> guard(steals_lock);
+    num_steals += stolen;
+  }
+
+ public:
+  WorkStealingPool(size_t num_workers) {
+    if (num_workers == 0) num_workers = 1;
+    for (size_t w = 0; w < num_workers; w++) {
+      queues.emplace_back(new Queue);
+    }
+  }
+
+  size_t get_num_workers() const { return queues.size(); }
+  size_t get_num_steals() const { return num_steals; }
+
+  /* calls FN(worker, task) once for every task in [0, NUM_TASKS) and
+     returns when all have finished. The calling thread is worker 0 */
+  template <class F>
+  void run(size_t num_tasks, F fn) {
+    size_t n = queues.size();
+    for (size_t w = 0; w < n; w++) {
+      for (size_t t = w * num_tasks / n; t < (w + 1) * num_tasks / n; t++) {
+        queues[w]->tasks.push_back(t);
+      }
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t w = 1; w < n; w++) {
+      threads.emplace_back([this, w, &fn] { work(w, fn); });
+    }
+    work(0, fn);
+    for (std::thread &t : threads) {
+      t.join();
+    }
+  }
+};
+
+#endif  // THREAD_POOL_H
@@ -1,31 +1,54 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
 #include <iostream>
 #include <set>
 #include <unordered_map>
 
 #include "constants.h"
-
+#include "symboltable.h"
+
+/*
+  A token is a small POD record: where it is in the source (line, column and
+  the [offset, offset + length) byte span) and what it says, as an interned
+  Symbol. Keywords and EMPTY tokens carry sym::Empty. Copying a Token never
+  allocates.
+*/
 class Token {
-  int lineno;
   TokenType type;
-  std::string str;
+  int lineno = 0;
+  int column = 0;
+  uint32_t offset = 0;
+  uint32_t length = 0;
+  Symbol sym = sym::Empty;
 
  public:
-  Token(TokenType type) : type(type) {}
-  Token(int lineno, TokenType type, std::string str) : lineno(lineno), type(type), str(str) {}
-
-  int get_lineno() { return lineno; }
-  TokenType get_type() { return type; }
-  std::string get_type_str() { return TOKEN_TYPE_TO_STR[type]; }
-  std::string get_str() { return str; }
-
-  void set_lineno(int n) { lineno = n; }
-  void set_type(TokenType t) { type = t; }
-  void set_str(std::string s) { str = s; }
-
-  void dump() { std::cout << "#" << lineno << " " << TOKEN_TYPE_TO_STR[type] << " " << str << std::endl; }
+  Token(TokenType type = EMPTY) : type(type) {}
+  Token(TokenType type, int lineno, int column, uint32_t offset,
+        uint32_t length, Symbol sym)
+      : type(type),
+        lineno(lineno),
+        column(column),
+        offset(offset),
+        length(length),
+        sym(sym) {}
+
+  int get_lineno() const { return lineno; }
+  int get_column() const { return column; }
+  uint32_t get_offset() const { return offset; }
+  uint32_t get_length() const { return length; }
+  TokenType get_type() const { return type; }
+  Symbol get_sym() const { return sym; }
+  bool is(Symbol s) const { return sym == s; }
+
+  std::string get_type_str() const { return TOKEN_TYPE_TO_STR[type]; }
+  const std::string &get_str() const { return SymbolTable::global().str(sym); }
+
+  void dump() const {
+    std::cout << "#" << lineno << " " << TOKEN_TYPE_TO_STR[type] << " "
+              << get_str() << std::endl;
+  }
 };
 
-#endif  // TOKEN_H
\ No newline at end of file
+#endif  // TOKEN_H
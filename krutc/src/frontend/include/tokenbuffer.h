@@ -1,64 +1,89 @@
 #ifndef TOKEN_BUFFER_H
 #define TOKEN_BUFFER_H
 
-#include <deque>
 #include <iostream>
+#include <vector>
 
 #include "lexer.h"
 
+#define TOKEN_RING_SIZE 64 /* must be a power of two */
+
+/*
+  Token stream between the Lexer and the Parser. Tokens are lexed on demand
+  into a small ring buffer as the parser consumes them, so memory use is
+  bounded by the deepest lookahead rather than by the size of the file. The
+  ring only grows if someone asks for lookahead(n) with n >= its capacity.
+
+  Lexer errors are collected, in source order, as they are encountered; they
+  are complete once the stream has been drained (has_next() == false).
+*/
 class TokenBuffer {
   Lexer lexer;
-  std::deque<Token> buffer;
+  std::vector<Token> ring;
+  size_t head = 0;  /* index of lookahead(0) */
+  size_t count = 0; /* number of buffered tokens */
   bool token_dump;
-  // int curr_lineno = 0;
+  std::vector<Token> lexer_errors;
+
+  size_t mask() { return ring.size() - 1; }
+
+  /* doubles the ring, unrolling it so head is at 0 */
+  void grow() {
+    std::vector<Token> bigger(ring.size() * 2);
+    for (size_t i = 0; i < count; i++) {
+      bigger[i] = ring[(head + i) & mask()];
+    }
+    ring.swap(bigger);
+    head = 0;
+  }
 
-  void fill_buffer() {
-    while (lexer.has_more()) {
+  /* lexes until at least N tokens are buffered. false if EOF came first */
+  bool fill(size_t n) {
+    while (count < n && lexer.has_more()) {
       Token t = lexer.get_next_token();
       if (t.get_type() == ERROR) {
-        std::cout << t.get_str() << std::endl;
+        lexer_errors.push_back(t);
         has_errors++;
         continue;
       }
       if (t.get_type() == EMPTY) {
         continue;
       }
-      // t.dump();
-      buffer.push_back(t);
+      if (count == ring.size()) grow();
+      ring[(head + count) & mask()] = t;
+      count++;
     }
+    return count >= n;
   }
 
  public:
   int has_errors = 0;
 
   TokenBuffer(const std::string filepath, bool token_dump)
-      : lexer(filepath), token_dump(token_dump) {
-    fill_buffer();
-  }
+      : lexer(filepath), ring(TOKEN_RING_SIZE), token_dump(token_dump) {}
 
-  bool has_next() { return buffer.size(); }
+  bool has_next() { return fill(1); }
 
   Token get_next() {
-    if (buffer.empty()) {
+    if (!fill(1)) {
       return Token(EMPTY);
     }
-    Token t = buffer.front();
+    Token t = ring[head];
     if (token_dump) t.dump();
-    buffer.pop_front();
-    // curr_lineno = t.get_lineno();
+    head = (head + 1) & mask();
+    count--;
     return t;
   }
 
-  Token lookahead(int n) {
-    if (n >= buffer.size()) {
-      return Token(EMPTY);
+  const Token &lookahead(int n) {
+    static const Token empty = Token(EMPTY);
+    if (n < 0 || !fill(n + 1)) {
+      return empty;
     }
-    return buffer[n];
+    return ring[(head + n) & mask()];
   }
 
-  // int get_lineno() {
-  //   return curr_lineno;
-  // }
+  const std::vector<Token> &get_lexer_errors() { return lexer_errors; }
 };
 
-#endif  // TOKEN_BUFFER_H
\ No newline at end of file
+#endif  // TOKEN_BUFFER_H
@@ -9,8 +9,12 @@
 
 #include <iostream>
 #include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "symboltable.h"
+
 // #include "llvm/IR/IRBuilder.h"
 // #include "llvm/IR/LLVMContext.h"
 // #include "llvm/IR/Module.h"
@@ -87,6 +91,9 @@ class BinopExpr;
 class NewExpr;
 
 class Type_;
+struct SemaContext;
+struct CodeGenContext;
+struct BcCompiler;
 
 class Program {
   StmtList stmt_list;
@@ -96,8 +103,10 @@ class Program {
   void add_stmt(Stmt *stmt) { stmt_list.push_back(stmt); }
   int len() { return (int)stmt_list.size(); }
   Stmt *ith(int i) { return stmt_list[i]; }
+  StmtList::const_iterator begin() const { return stmt_list.begin(); }
+  StmtList::const_iterator end() const { return stmt_list.end(); }
   void dump();
-  StmtList get_stmt_list() { return stmt_list; }
+  const StmtList &get_stmt_list() { return stmt_list; }
 };
 class Stmt {
  public:
@@ -106,17 +115,25 @@ class Stmt {
   virtual ~Stmt() = default;
   virtual void dump(int indent) = 0;
   virtual std::string classname() { return "Stmt"; };
-  virtual Type_ *typecheck() = 0;
-  virtual llvm::Value *codegen() = 0;
+  virtual Type_ *typecheck(SemaContext &ctx) = 0;
+  virtual llvm::Value *codegen(CodeGenContext &cg) = 0;
+  /* appends this statement's bytecode to the method being compiled; an
+     expression returns the register that holds its value, a statement -1 */
+  virtual int compile(BcCompiler &bc) = 0;
 };
 
 class ExprStmt : public Stmt {
+  Type_ *type = NULL; /* the static type, recorded by the typechecker */
+
  public:
   StmtType get_stmttype() { return EXPR_EXPR; }
   int lineno = 0;
+  Type_ *get_type() { return type; }
+  void set_type(Type_ *t) { type = t; }
   virtual std::string classname() { return "ExprStmt"; }
   virtual void dump(int indent);
-  virtual llvm::Value *codegen();
+  virtual llvm::Value *codegen(CodeGenContext &cg);
+  virtual int compile(BcCompiler &bc);
 };
 
 ////////////////////////////////////////////////////////////
@@ -134,17 +151,20 @@ class ClassStmt : public Stmt {
  public:
   ClassStmt(std::string name, std::vector<std::string> parents,
             FeatureList feature_list)
-      : name(name), parents(parents), feature_list(feature_list) {}
+      : name(std::move(name)),
+        parents(std::move(parents)),
+        feature_list(std::move(feature_list)) {}
 
   StmtType get_stmttype() { return CLASS_STMT; }
   std::string classname() { return "ClassStmt"; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 
-  std::string get_name() { return name; }
-  std::vector<std::string> get_parents() { return parents; }
-  FeatureList get_feature_list() { return feature_list; }
-  Type_ *typecheck();
+  const std::string &get_name() { return name; }
+  const std::vector<std::string> &get_parents() { return parents; }
+  const FeatureList &get_feature_list() { return feature_list; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class Feature : public Stmt {
@@ -160,17 +180,18 @@ class AttrStmt : public Feature {
 
  public:
   AttrStmt(Type_ *type, std::string name, ExprStmt *init)
-      : type(type), name(name), init(init) {}
+      : type(type), name(std::move(name)), init(init) {}
   StmtType get_stmttype() { return ATTR_STMT; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 
   bool is_method() { return false; }
   std::string classname() { return "AttrStmt"; }
   Type_ *get_type() { return type; }
-  std::string get_name() { return name; }
+  const std::string &get_name() { return name; }
   ExprStmt *get_init() { return init; }
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class FormalStmt : public Stmt {
@@ -178,15 +199,17 @@ class FormalStmt : public Stmt {
   std::string name;
 
  public:
-  FormalStmt(Type_ *type, std::string name) : type(type), name(name) {}
+  FormalStmt(Type_ *type, std::string name)
+      : type(type), name(std::move(name)) {}
   StmtType get_stmttype() { return FORMAL_STMT; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 
   std::string classname() { return "FORMAL_STMT"; }
-  std::string get_name() { return name; }
+  const std::string &get_name() { return name; }
   Type_ *get_type() { return type; }
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 /* in the form TYPEID OBJECTID(FORMAL_LIST) {STMT_LIST}*/
@@ -195,25 +218,29 @@ class MethodStmt : public Feature {
   std::string name;
   FormalList formal_list;
   StmtList stmt_list;
+  bool builtin = false; /* implemented by the runtime, no body */
 
  public:
   MethodStmt(Type_ *ret_type, std::string name, FormalList formal_list,
              StmtList stmt)
       : ret_type(ret_type),
-        name(name),
-        formal_list(formal_list),
-        stmt_list(stmt) {}
+        name(std::move(name)),
+        formal_list(std::move(formal_list)),
+        stmt_list(std::move(stmt)) {}
   StmtType get_stmttype() { return METHOD_STMT; }
   std::string classname() { return "MethodStmt"; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 
   bool is_method() { return true; }
-  std::string get_name() { return name; }
+  const std::string &get_name() { return name; }
   Type_ *get_ret_type() { return ret_type; }
-  FormalList get_formal_list() { return formal_list; }
-  StmtList get_stmt_list() { return stmt_list; }
-  Type_ *typecheck();
+  const FormalList &get_formal_list() { return formal_list; }
+  const StmtList &get_stmt_list() { return stmt_list; }
+  bool is_builtin() { return builtin; }
+  void set_builtin() { builtin = true; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class ForStmt : public Stmt {
@@ -224,17 +251,21 @@ class ForStmt : public Stmt {
 
  public:
   ForStmt(Stmt *stmt, ExprStmt *cond, ExprStmt *repeat, StmtList stmt_list)
-      : stmt(stmt), cond(cond), repeat(repeat), stmt_list(stmt_list) {}
+      : stmt(stmt),
+        cond(cond),
+        repeat(repeat),
+        stmt_list(std::move(stmt_list)) {}
   StmtType get_stmttype() { return FOR_STMT; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "ForStmt"; }
 
   Stmt *get_formal() { return stmt; }
   ExprStmt *get_cond() { return cond; }
   ExprStmt *get_repeat() { return repeat; }
-  StmtList get_stmt_list() { return stmt_list; }
-  Type_ *typecheck();
+  const StmtList &get_stmt_list() { return stmt_list; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class IfStmt : public Stmt {
@@ -244,17 +275,20 @@ class IfStmt : public Stmt {
 
  public:
   IfStmt(ExprStmt *pred, StmtList then_branch, StmtList else_branch)
-      : pred(pred), then_branch(then_branch), else_branch(else_branch) {}
+      : pred(pred),
+        then_branch(std::move(then_branch)),
+        else_branch(std::move(else_branch)) {}
   StmtType get_stmttype() { return IF_STMT; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "IfStmt"; }
   // std::string get_name() { return "IfStmt"; }
 
   ExprStmt *get_pred() { return pred; }
-  StmtList get_then() { return then_branch; }
-  StmtList get_else() { return else_branch; }
-  Type_ *typecheck();
+  const StmtList &get_then() { return then_branch; }
+  const StmtList &get_else() { return else_branch; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class WhileStmt : public Stmt {
@@ -263,16 +297,17 @@ class WhileStmt : public Stmt {
 
  public:
   WhileStmt(ExprStmt *pred, StmtList stmt_list)
-      : pred(pred), stmt_list(stmt_list) {}
+      : pred(pred), stmt_list(std::move(stmt_list)) {}
   StmtType get_stmttype() { return WHILE_STMT; }
   void dump(int indent);
   std::string classname() { return "WhileStmt"; }
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   // std::string get_name() { return "WhileStmt"; }
 
   ExprStmt *get_pred() { return pred; }
-  StmtList get_stmt_list() { return stmt_list; }
-  Type_ *typecheck();
+  const StmtList &get_stmt_list() { return stmt_list; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 class BreakStmt : public Stmt {
   std::string name = "BREAK";
@@ -282,8 +317,9 @@ class BreakStmt : public Stmt {
   StmtType get_stmttype() { return BREAK_EXPR; }
   std::string classname() { return "BreakExpr"; }
   void dump(int indent);
-  llvm::Value *codegen();
-  Type_ *typecheck();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class ContStmt : public Stmt {
@@ -294,8 +330,9 @@ class ContStmt : public Stmt {
   StmtType get_stmttype() { return CONT_EXPR; }
   std::string classname() { return "ContExpr"; }
   void dump(int indent);
-  Type_ *typecheck();
-  llvm::Value *codegen();
+  Type_ *typecheck(SemaContext &ctx);
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 };
 
 ////////////////////////////////////////////////////////////
@@ -310,40 +347,59 @@ class BinopExpr : public ExprStmt {
   ExprStmt *lhs;
   std::string op;
   ExprStmt *rhs;
+  bool negation; /* a prefix `-`, which the parser gave a 0 lhs */
 
  public:
-  BinopExpr(ExprStmt *lhs, std::string op, ExprStmt *rhs)
-      : lhs(lhs), op(op), rhs(rhs) {}
+  BinopExpr(ExprStmt *lhs, std::string op, ExprStmt *rhs,
+            bool negation = false)
+      : lhs(lhs), op(std::move(op)), rhs(rhs), negation(negation) {}
   StmtType get_stmttype() { return BINOP_EXPR; }
   std::string classname() { return "BinopExpr"; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 
   ExprStmt *get_lhs() { return lhs; }
-  std::string get_op() { return op; }
+  const std::string &get_op() { return op; }
   ExprStmt *get_rhs() { return rhs; }
-  Type_ *typecheck();
+  bool is_negation() { return negation; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class DispatchExpr : public ExprStmt {
   // ExprStmt *calling_class;
   ExprStmt *calling_expr;
   std::string name;
+  Symbol sym; /* name, interned for method table lookups */
   ExprList args;
+  /* set by the typechecker: the method called (specialized for containers)
+     and its slot in the calling type's method table, -1 for globals */
+  MethodStmt *method = NULL;
+  int slot = -1;
 
  public:
   DispatchExpr(ExprStmt *calling_expr, std::string name, ExprList args)
-      : calling_expr(calling_expr), name(name), args(args) {}
+      : calling_expr(calling_expr),
+        name(std::move(name)),
+        sym(SymbolTable::global().intern(this->name)),
+        args(std::move(args)) {}
   StmtType get_stmttype() { return DISPATCH_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "DispatchExpr"; }
 
   ExprStmt *get_calling_expr() { return calling_expr; }
-  std::string get_name() { return name; }
-  ExprList get_args() { return args; }
-
-  Type_ *typecheck();
+  const std::string &get_name() { return name; }
+  const ExprList &get_args() { return args; }
+  MethodStmt *get_method() { return method; }
+  int get_slot() { return slot; }
+  void resolve(MethodStmt *m, int s) {
+    method = m;
+    slot = s;
+  }
+
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class ReturnExpr : public ExprStmt {
@@ -354,11 +410,12 @@ class ReturnExpr : public ExprStmt {
   // ReturnExpr() {}
   StmtType get_stmttype() { return RETURN_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "ReturnExpr"; }
 
   ExprStmt *get_expr() { return expr; }
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class IntConstExpr : public ExprStmt {
@@ -368,11 +425,12 @@ class IntConstExpr : public ExprStmt {
   IntConstExpr(long val) : val(val) {}
   StmtType get_stmttype() { return INT_CONST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "IntConstExpr"; }
 
   long get_val() { return val; }
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class DeciConstExpr : public ExprStmt {
@@ -382,39 +440,46 @@ class DeciConstExpr : public ExprStmt {
   DeciConstExpr(double val) : val(val) {}
   StmtType get_stmttype() { return DECI_CONST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "DeciConstExpr"; }
 
   double get_val() { return val; }
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class StrConstExpr : public ExprStmt {
   const std::string str;
 
  public:
-  StrConstExpr(std::string str) : str(str) {}
+  StrConstExpr(std::string str) : str(std::move(str)) {}
   StmtType get_stmttype() { return STRING_CONST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "StrConstExpr"; }
 
-  std::string get_str() { return str; }
-  Type_ *typecheck();
+  const std::string &get_str() { return str; }
+  /* the string the literal stands for: no quotes, escapes replaced */
+  std::string get_value();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class CharConstExpr : public ExprStmt {
   const std::string c;
 
  public:
-  CharConstExpr(std::string c) : c(c) {}
+  CharConstExpr(std::string c) : c(std::move(c)) {}
   StmtType get_stmttype() { return CHAR_CONST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "CharConstExpr"; }
 
-  std::string get_str() { return c; }
-  Type_ *typecheck();
+  const std::string &get_str() { return c; }
+  /* the token is the character in single quotes */
+  char get_char() { return c.size() > 1 ? c[1] : 0; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class BoolConstExpr : public ExprStmt {
@@ -424,11 +489,12 @@ class BoolConstExpr : public ExprStmt {
   BoolConstExpr(std::string bool_val) { val = bool_val == "true" ? 1 : 0; }
   StmtType get_stmttype() { return BOOL_CONST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "BoolConstExpr"; }
 
   int get_val() { return val; }
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 // set<int> = {1, 2, 2, 3}; ==> {1, 2, 3}
@@ -436,28 +502,30 @@ class SetConstExpr : public ExprStmt {
   ExprSet exprset;
 
  public:
-  SetConstExpr(ExprSet exprset) : exprset(exprset) {}
+  SetConstExpr(ExprSet exprset) : exprset(std::move(exprset)) {}
   StmtType get_stmttype() { return SET_CONST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "SetConstExpr"; }
 
-  ExprSet get_exprset() { return exprset; }
-  Type_ *typecheck();
+  const ExprSet &get_exprset() { return exprset; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class ListConstExpr : public ExprStmt {
   ExprList exprlist;
 
  public:
-  ListConstExpr(ExprList exprlist) : exprlist(exprlist) {}
+  ListConstExpr(ExprList exprlist) : exprlist(std::move(exprlist)) {}
   StmtType get_stmttype() { return LIST_CONST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "ListConstExpr"; }
 
-  ExprList get_exprlist() { return exprlist; }
-  Type_ *typecheck();
+  const ExprList &get_exprlist() { return exprlist; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class ListElemRef : public ExprStmt {
@@ -469,13 +537,14 @@ class ListElemRef : public ExprStmt {
       : list_name(list_name), index(index) {}
   StmtType get_stmttype() { return LIST_ELEM_REF; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "ListElemRef"; }
 
   ExprStmt *get_list_name() { return list_name; }
   ExprStmt *get_index() { return index; }
 
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class SublistExpr : public ListElemRef {
@@ -486,27 +555,32 @@ class SublistExpr : public ListElemRef {
       : ListElemRef(list_name, start_idx), end_idx(end_idx) {}
   StmtType get_stmttype() { return SUBLIST_EXPR; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
   std::string classname() { return "SublistExpr"; }
 
   ExprStmt *get_st_idx() { return get_index(); }
   ExprStmt *get_end_idx() { return end_idx; }
 
-  Type_ *typecheck();
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class ObjectIdExpr : public ExprStmt {
   std::string name;
+  Symbol sym; /* name, interned for scope table lookups */
 
  public:
-  ObjectIdExpr(std::string name) : name(name) {}
+  ObjectIdExpr(std::string name)
+      : name(std::move(name)), sym(SymbolTable::global().intern(this->name)) {}
   StmtType get_stmttype() { return OBJECTID_EXPR; }
   std::string classname() { return "ObjectIdStmt"; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 
-  std::string get_name() { return name; }
-  Type_ *typecheck();
+  const std::string &get_name() { return name; }
+  Symbol get_sym() { return sym; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 class NewExpr : public ExprStmt {
@@ -514,14 +588,15 @@ class NewExpr : public ExprStmt {
   std::string newclass;
 
  public:
-  NewExpr(std::string newclass) : newclass(newclass) {}
+  NewExpr(std::string newclass) : newclass(std::move(newclass)) {}
   StmtType get_stmttype() { return NEW_EXPR; }
   std::string classname() { return "NewExpr"; }
   void dump(int indent);
-  llvm::Value *codegen();
+  llvm::Value *codegen(CodeGenContext &cg);
+  int compile(BcCompiler &bc);
 
-  std::string get_newclass() { return newclass; }
-  Type_ *typecheck();
+  const std::string &get_newclass() { return newclass; }
+  Type_ *typecheck(SemaContext &ctx);
 };
 
 /* this is not an actual expression, but a class used for
@@ -529,20 +604,27 @@ class NewExpr : public ExprStmt {
 
   Basic types include:
   object, int, str, bool, float(maybe?), list<object>, stack<object>
+
+  Type_s are interned by TypeContext (typecontext.h): there is one Type_ per
+  distinct type, so types are equal iff their pointers (or ids) are.
 */
 class Type_ {
-  std::string name;
+  Symbol name;
+  uint32_t id; /* dense, per TypeContext */
   Type_ *nested_type;
+  Type_ *value_type; /* a dict's second type argument, else NULL */
 
  public:
-  int lineno;
-  Type_(std::string name, Type_ *nested_type)
-      : name(name), nested_type(nested_type) {}
+  Type_(Symbol name, Type_ *nested_type, Type_ *value_type, uint32_t id)
+      : name(name), id(id), nested_type(nested_type), value_type(value_type) {}
   void dump(int indent);
   std::string to_str();
 
-  std::string get_name() { return name; }
+  const std::string &get_name() { return SymbolTable::global().str(name); }
+  Symbol get_sym() { return name; }
+  uint32_t get_id() { return id; }
   Type_ *get_nested_type() { return nested_type; }
+  Type_ *get_value_type() { return value_type; }
 };
 
 #endif  // TREE_H
\ No newline at end of file
@@ -1,19 +1,50 @@
 #ifndef TYPECHECKER_H
 #define TYPECHECKER_H
 
+#include <memory>
+#include <vector>
+
+#include "astarena.h"
+#include "featuretable.h"
 #include "parser.h"
+#include "semacontext.h"
 #include "tree.h"
+#include "typecontext.h"
 
 class TypeChecker {
-  Program program;
+  Program &program; /* owned by the caller */
+  AstArena &arena; /* the parser's arena; typechecker nodes go here too */
+  TypeContext &types;
   std::string filename;
+  SemaContext ctx; /* all state of the current typecheck() */
+
+  /* -j N: one arena per worker thread, and what the last run did */
+  std::vector<std::unique_ptr<AstArena>> worker_arenas;
+  size_t num_deferred = 0;
+  size_t num_steals = 0;
+
+  void check_deferred_methods(std::vector<DeferredMethod> &deferred,
+                              const std::string &diags);
 
  public:
   bool debug = false;
-  TypeChecker(Program program, bool debug, std::string filename)
-      : program(program), debug(debug), filename(filename) {}
+  int jobs = 1; /* threads that check method bodies */
+  TypeChecker(Program &program, AstArena &arena, TypeContext &types,
+              bool debug, std::string filename)
+      : program(program),
+        arena(arena),
+        types(types),
+        filename(filename),
+        ctx(arena, types, filename),
+        debug(debug) {}
 
   int typecheck();
+  MethodStmt *builtin_method(Type_ *ret_type, const std::string &name,
+                             Type_ *formal_type = NULL,
+                             const std::string &formal_name = "",
+                             Type_ *formal_type2 = NULL,
+                             const std::string &formal_name2 = "");
+  void add_global_method(MethodStmt *m);
   void initialize_basic_classes();
   void initialize_builtin_methods();
   void initialize_declared_classes();
@@ -22,7 +53,17 @@ class TypeChecker {
 
   bool check_inheritance_cycles();
   void populate_feature_tables();
+  void build_feature_tables();
   bool check_global_features();
+
+  /* a class's finalized feature tables (vtable and field layouts); NULL if
+     CNAME is not a class. Valid once typecheck() has run */
+  const MethodTable *get_method_table(const std::string &cname);
+  const AttrTable *get_attr_table(const std::string &cname);
+  /* true if class A is B or inherits from it, directly or not */
+  bool inherits_from(const std::string &a, const std::string &b);
+
+  void print_stats(std::ostream &os);
 };
 
 #endif  // TYPECHECKER_H
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef TYPE_CONTEXT_H
+#define TYPE_CONTEXT_H
+
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "astarena.h"
+#include "symboltable.h"
+#include "tree.h"
+
+/*
+  Interns every distinct type of one compilation (int, list<int>,
+  list<list<Car>>, ...) exactly once, so two Type_s are the same type iff
+  they are the same pointer. Each type gets a dense id in order of first
+  use. Types live in the compilation's arena and are never freed before it.
+
+  The parser and the typechecker must make Type_s only through get(). It may
+  be called from several threads at once (-j N).
+*/
+class TypeContext {
+  AstArena &arena;
+  std::vector<Type_ *> types; /* indexed by id */
+
+  /* (name << 32 | nested id + 1, or 0 if not nested) -> type; a dict's
+     value type is in a second index keyed the same way, by name and key */
+  std::unordered_map<uint64_t, Type_ *> index;
+  std::unordered_map<uint64_t, std::unordered_map<uint32_t, Type_ *>>
+      value_index;
+  mutable std::mutex lock; /* guards types, the indexes and the arena */
+
+ public:
+  TypeContext(AstArena &arena) : arena(arena) {}
+  TypeContext(const TypeContext &) = delete;
+  TypeContext &operator=(const TypeContext &) = delete;
+
+  Type_ *get(Symbol name, Type_ *nested = NULL, Type_ *value = NULL) {
+    uint64_t key = (uint64_t)name << 32 | (nested ? nested->get_id() + 1 : 0);
+    std::lock_guard<std::mutex> guard(lock);
+    Type_ *&t = value ? value_index[key][value->get_id()] : index[key];
+    if (t) return t;
+
+    t = arena.make<Type_>(name, nested, value, (uint32_t)types.size());
+    types.push_back(t);
+    return t;
+  }
+
+  Type_ *get(std::string_view name, Type_ *nested = NULL,
+             Type_ *value = NULL) {
+    return get(SymbolTable::global().intern(name), nested, value);
+  }
+
+  Type_ *by_id(uint32_t id) {
+    std::lock_guard<std::mutex> guard(lock);
+    return types[id];
+  }
+  size_t size() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return types.size();
+  }
+
+  void print_stats(std::ostream &os) const {
+    std::lock_guard<std::mutex> guard(lock);
+    os << "types:          " << types.size() << " interned" << std::endl;
+  }
+};
+
+#endif  // TYPE_CONTEXT_H
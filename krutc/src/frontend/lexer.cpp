@@ -1,220 +1,499 @@
 /* Definition of a lexer for the Krutcpp Programming Language (KPL) */
 #include "include/lexer.h"
 
+#include <cstring>
 #include <iostream>
-#include <unordered_set>
-#include <vector>
+#include <string_view>
 
 #include "constants.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 using namespace basic_classes;
 using namespace lexing;
 
-/* remove all characters that are part of comments */
-Token Lexer::ml_comment() {
-  Token t = Token(EMPTY);
+//////////////////////////////////////////////////////////////
+//
+// Character classes
+//
+//////////////////////////////////////////////////////////////
+
+/* what a byte can start. Everything not listed is an unrecognized token */
+enum CharClass : uint8_t {
+  CC_OTHER = 0,
+  CC_BLANK,   /* ' ' '\t' */
+  CC_NEWLINE, /* '\n' */
+  CC_ALPHA,   /* keyword, typeid, objectid or bool const */
+  CC_DIGIT,   /* int or deci const */
+  CC_SPECIAL, /* ( ) ; [ ] { } . , : */
+  CC_OP,      /* + - * / < > = and the first half of != && || */
+  CC_DQUOTE,
+  CC_SQUOTE
+};
+
+struct CharTable {
+  CharClass cls[256];
+  bool ident[256]; /* may continue an identifier: [A-Za-z0-9_] */
+  Symbol sym[256]; /* the symbol of a one-char special char or binop */
+};
+
+static constexpr CharTable make_char_table() {
+  CharTable t = {};
+  for (int c = 0; c < 256; c++) {
+    bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    bool digit = c >= '0' && c <= '9';
+    t.cls[c] = alpha ? CC_ALPHA : digit ? CC_DIGIT : CC_OTHER;
+    t.ident[c] = alpha || digit || c == '_';
+    t.sym[c] = sym::Empty;
+  }
+  t.cls[(int)' '] = t.cls[(int)'\t'] = CC_BLANK;
+  t.cls[(int)'\n'] = CC_NEWLINE;
+  t.cls[(int)'\"'] = CC_DQUOTE;
+  t.cls[(int)'\''] = CC_SQUOTE;
+
+  const char special[] = "();[]{}.,:";
+  const Symbol special_sym[] = {
+      sym::OpenP,      sym::CloseP,    sym::SemiColon,  sym::OpenBrack,
+      sym::CloseBrack, sym::OpenBrace, sym::CloseBrace, sym::Period,
+      sym::Comma,      sym::Colon};
+  for (int i = 0; special[i]; i++) {
+    t.cls[(int)special[i]] = CC_SPECIAL;
+    t.sym[(int)special[i]] = special_sym[i];
+  }
+
+  const char ops[] = "+-*/<>=!&|";
+  const Symbol op_sym[] = {sym::Plus,     sym::Minus,       sym::Times,
+                           sym::Divide,   sym::LessThan,    sym::GreaterThan,
+                           sym::Define,   sym::Empty,       sym::Empty,
+                           sym::Empty};
+  for (int i = 0; ops[i]; i++) {
+    t.cls[(int)ops[i]] = CC_OP;
+    t.sym[(int)ops[i]] = op_sym[i];
+  }
+  return t;
+}
+
+static constexpr CharTable CHARS = make_char_table();
+
+//////////////////////////////////////////////////////////////
+//
+// Run scanning. Each function returns the first byte in [p, end) that ends
+// the run. The vector paths handle whole blocks; the table-driven scalar loop
+// finishes the tail (and is the only path on targets without SSE2).
+//
+//////////////////////////////////////////////////////////////
+
+#if defined(__AVX2__)
+#define VEC_BYTES 32
+typedef __m256i vec_t;
+static inline vec_t vload(const char *p) {
+  return _mm256_loadu_si256((const __m256i *)p);
+}
+static inline vec_t vsplat(char c) { return _mm256_set1_epi8(c); }
+static inline vec_t veq(vec_t a, vec_t b) { return _mm256_cmpeq_epi8(a, b); }
+static inline vec_t vgt(vec_t a, vec_t b) { return _mm256_cmpgt_epi8(a, b); }
+static inline vec_t vor(vec_t a, vec_t b) { return _mm256_or_si256(a, b); }
+static inline vec_t vand(vec_t a, vec_t b) { return _mm256_and_si256(a, b); }
+static inline uint32_t vmask(vec_t a) {
+  return (uint32_t)_mm256_movemask_epi8(a);
+}
+#define VEC_ALL 0xFFFFFFFFu
+#elif defined(__SSE2__)
+#define VEC_BYTES 16
+typedef __m128i vec_t;
+static inline vec_t vload(const char *p) {
+  return _mm_loadu_si128((const __m128i *)p);
+}
+static inline vec_t vsplat(char c) { return _mm_set1_epi8(c); }
+static inline vec_t veq(vec_t a, vec_t b) { return _mm_cmpeq_epi8(a, b); }
+static inline vec_t vgt(vec_t a, vec_t b) { return _mm_cmpgt_epi8(a, b); }
+static inline vec_t vor(vec_t a, vec_t b) { return _mm_or_si128(a, b); }
+static inline vec_t vand(vec_t a, vec_t b) { return _mm_and_si128(a, b); }
+static inline uint32_t vmask(vec_t a) { return (uint32_t)_mm_movemask_epi8(a); }
+#define VEC_ALL 0xFFFFu
+#endif
+
+/* lanes of V inside [lo, hi]. Signed compares, so bytes >= 0x80 never match */
+#ifdef VEC_BYTES
+static inline vec_t vrange(vec_t v, char lo, char hi) {
+  return vand(vgt(v, vsplat(lo - 1)), vgt(vsplat(hi + 1), v));
+}
+#endif
+
+/* skips ' ', '\t' and '\n'. Counts the newlines crossed and remembers the
+   byte after the last one */
+static const char *skip_blanks(const char *p, const char *end, int &newlines,
+                               const char *&after_nl) {
+#ifdef VEC_BYTES
+  while (end - p >= VEC_BYTES) {
+    vec_t v = vload(p);
+    uint32_t nl = vmask(veq(v, vsplat('\n')));
+    uint32_t blank = vmask(vor(vor(veq(v, vsplat(' ')), veq(v, vsplat('\t'))),
+                               veq(v, vsplat('\n'))));
+    int stop = blank == VEC_ALL ? VEC_BYTES : __builtin_ctz(~blank);
+    if (stop < 32) nl &= (1u << stop) - 1;
+    if (nl) {
+      newlines += __builtin_popcount(nl);
+      after_nl = p + (31 - __builtin_clz(nl)) + 1;
+    }
+    if (stop < VEC_BYTES) return p + stop;
+    p += VEC_BYTES;
+  }
+#endif
+  for (; p < end; p++) {
+    CharClass c = CHARS.cls[(unsigned char)*p];
+    if (c == CC_NEWLINE) {
+      newlines++;
+      after_nl = p + 1;
+    } else if (c != CC_BLANK) {
+      break;
+    }
+  }
+  return p;
+}
+
+static const char *scan_ident(const char *p, const char *end) {
+#ifdef VEC_BYTES
+  while (end - p >= VEC_BYTES) {
+    vec_t v = vload(p);
+    vec_t alpha = vrange(vor(v, vsplat(0x20)), 'a', 'z');
+    vec_t digit = vrange(v, '0', '9');
+    vec_t under = veq(v, vsplat('_'));
+    uint32_t ident = vmask(vor(vor(alpha, digit), under));
+    if (ident != VEC_ALL) return p + __builtin_ctz(~ident);
+    p += VEC_BYTES;
+  }
+#endif
+  while (p < end && CHARS.ident[(unsigned char)*p]) p++;
+  return p;
+}
+
+static const char *scan_digits(const char *p, const char *end) {
+#ifdef VEC_BYTES
+  while (end - p >= VEC_BYTES) {
+    uint32_t digit = vmask(vrange(vload(p), '0', '9'));
+    if (digit != VEC_ALL) return p + __builtin_ctz(~digit);
+    p += VEC_BYTES;
+  }
+#endif
+  while (p < end && CHARS.cls[(unsigned char)*p] == CC_DIGIT) p++;
+  return p;
+}
+
+/* first occurrence of A, B or C in [p, end), or end */
+static const char *find_any(const char *p, const char *end, char a, char b,
+                            char c) {
+#ifdef VEC_BYTES
+  while (end - p >= VEC_BYTES) {
+    vec_t v = vload(p);
+    uint32_t hit = vmask(
+        vor(vor(veq(v, vsplat(a)), veq(v, vsplat(b))), veq(v, vsplat(c))));
+    if (hit) return p + __builtin_ctz(hit);
+    p += VEC_BYTES;
+  }
+#endif
+  while (p < end && *p != a && *p != b && *p != c) p++;
+  return p;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Keywords. Keywords are case insensitive (`CLASS`, `Class` and `class` are
+// all CLASS). KEYWORD_HASH is a perfect hash over the lowercased keywords:
+// every keyword lands in its own slot, so a word is a keyword iff it matches
+// the one entry its hash selects.
+//
+//////////////////////////////////////////////////////////////
+
+struct Keyword {
+  const char *lower;
+  uint8_t len;
+  TokenType type;
+};
+
+static constexpr unsigned keyword_hash(char first, char second, char last) {
+  return ((first | 0x20) * 5 + (second | 0x20) * 3 + (last | 0x20)) & 15;
+}
+
+static constexpr Keyword KEYWORD_TABLE[16] = {
+    /* 0 */ {"while", 5, WHILE},   /* 1 */ {"continue", 8, CONTINUE},
+    /* 2 */ {"else", 4, ELSE},     /* 3 */ {NULL, 0, EMPTY},
+    /* 4 */ {NULL, 0, EMPTY},      /* 5 */ {"if", 2, IF},
+    /* 6 */ {"class", 5, CLASS},   /* 7 */ {"return", 6, RETURN},
+    /* 8 */ {NULL, 0, EMPTY},      /* 9 */ {NULL, 0, EMPTY},
+    /* 10 */ {"inherits", 8, INHERITS}, /* 11 */ {"break", 5, BREAK},
+    /* 12 */ {"new", 3, NEW},      /* 13 */ {"for", 3, FOR},
+    /* 14 */ {NULL, 0, EMPTY},     /* 15 */ {NULL, 0, EMPTY}};
+
+static constexpr bool keyword_table_is_perfect() {
+  for (unsigned i = 0; i < 16; i++) {
+    const Keyword &k = KEYWORD_TABLE[i];
+    if (!k.lower) continue;
+    if (keyword_hash(k.lower[0], k.lower[1], k.lower[k.len - 1]) != i) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(keyword_table_is_perfect(), "keyword in the wrong hash slot");
+
+/* returns the keyword's TokenType, or EMPTY if S is not a keyword */
+static TokenType lookup_keyword(const char *s, size_t len) {
+  if (len < 2 || len > 8) return EMPTY;
+  const Keyword &k = KEYWORD_TABLE[keyword_hash(s[0], s[1], s[len - 1])];
+  if (k.len != len) return EMPTY;
+  for (size_t i = 0; i < len; i++) {
+    /* |0x20 only folds A-Z onto a-z, the keywords are all letters */
+    if ((s[i] | 0x20) != k.lower[i]) return EMPTY;
+  }
+  return k.type;
+}
+
+/* case-sensitive check for the builtin type names (see is_basic_class) */
+static bool is_basic_class_name(const char *s, size_t len) {
+  switch (len) {
+    case 3:
+      return !memcmp(s, "int", 3) || !memcmp(s, "set", 3);
+    case 4:
+      return !memcmp(s, "void", 4) || !memcmp(s, "bool", 4) ||
+             !memcmp(s, "char", 4) || !memcmp(s, "list", 4) ||
+             !memcmp(s, "deci", 4) || !memcmp(s, "dict", 4);
+    case 6:
+      return !memcmp(s, "object", 6) || !memcmp(s, "string", 6);
+    default:
+      return false;
+  }
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Lexer
+//
+//////////////////////////////////////////////////////////////
+
+/* builds a token spanning [START, cursor) with its text interned */
+Token Lexer::make_token(TokenType type, const char *start, int column) {
+  uint32_t len = buff.cursor() - start;
+  Symbol sym = SymbolTable::global().intern(string_view(start, len));
+  return Token(type, curr_lineno, column, start - buff.data(), len, sym);
+}
 
+/* same, for punctuation and operators whose symbol is already known */
+Token Lexer::make_token(TokenType type, const char *start, int column,
+                        Symbol sym) {
+  uint32_t len = buff.cursor() - start;
+  return Token(type, curr_lineno, column, start - buff.data(), len, sym);
+}
+
+Token Lexer::error_token(int lineno, const string &err_msg) {
+  Symbol sym = SymbolTable::global().intern(err_msg);
+  return Token(ERROR, lineno, 0, buff.offset(), 0, sym);
+}
+
+/* remove all characters that are part of comments. The opening '/' '*' has
+   already been consumed */
+Token Lexer::ml_comment() {
   int comment_stack = 1;
   int lineno = curr_lineno;
+  const char *end = buff.limit();
 
   while (comment_stack) {
-    char curr = buff.get_next();
-
-    if (curr == '*') {
-      char next = buff.lookahead(0);
-      if (next == '/') {
-        /* pop comment_end off buff */
-        buff.get_next();
-        comment_stack--;
-      }
-    } else if (curr == '/') {
-      char next = buff.lookahead(0);
-      if (next == '*') {
-        buff.get_next(); /* pop * off buff */
-        comment_stack++;
-        lineno = curr_lineno;
-      }
-    } else if (curr == '\n') {
-      curr_lineno++;
-    } else if (curr == '\0') {
+    const char *p = find_any(buff.cursor(), end, '*', '/', '\n');
+    if (p == end) {
+      buff.seek(end);
       string err_str =
           filepath + ":" + to_string(lineno) + " Lexer Error: EOF in comment. ";
-      t = Token(lineno, ERROR, err_str);
-      return t;
+      return error_token(lineno, err_str);
+    }
+    buff.seek(p + 1);
+
+    if (*p == '\n') {
+      newline();
+    } else if (*p == '*' && buff.lookahead(0) == '/') {
+      buff.advance(1);
+      comment_stack--;
+    } else if (*p == '/' && buff.lookahead(0) == '*') {
+      buff.advance(1);
+      comment_stack++;
+      lineno = curr_lineno;
     }
   }
-  return t;
+  return Token(EMPTY);
 }
 
-/* find every string */
+/* consumes a string literal up to and including the closing '"'. Returns the
+   number of chars inside the quotes, or -1 with string_err_buff set */
 int Lexer::get_string() {
   string_err_buff = "";
   int string_start_lineno = curr_lineno;
-  int char_buff_size = 0;
+  const char *first = buff.cursor();
+  const char *end = buff.limit();
+
   while (true) {
-    char curr = buff.get_next();
-
-    if (curr == '\0') {
-      char_buff_size = -1;
-      string_err_buff = filepath + ":" + to_string(string_start_lineno) + ": " +
-                        "Lexer Error: EOF in string.";
-    } else if (curr == '\n') {
-      curr_lineno++;
-      char_buff[char_buff_size++] = curr;
-      continue;
-    } else if (char_buff_size >= MAX_STRING_LEN) {
-      char_buff_size = -1;
-      string_err_buff =
-          filepath + ":" + to_string(string_start_lineno) + ": " +
-          "Lexer Error: Verse too long. Maximum string length is " +
-          to_string(MAX_STRING_LEN);
-    } else if (curr == '\"') {
-      break;
-    } else {
-      char_buff[char_buff_size++] = curr;
+    const char *p = find_any(buff.cursor(), end, '\"', '\n', '\"');
+    if (p == end) {
+      buff.seek(end);
+      string_err_buff = filepath + ":" + to_string(string_start_lineno) +
+                        ": " + "Lexer Error: EOF in string.";
+      return -1;
     }
+    buff.seek(p + 1);
+    if (*p == '\"') break;
+    newline();
   }
-  return char_buff_size;
-}
 
-/* Called from the parser. On each call, returns the next token. */
-Token Lexer::get_next_token() {
-  Token t = Token(EMPTY);
-
-  while (buff.has_next()) {
-    string curr;
-    curr += buff.get_next();
-
-    // Multiline comment check
-    if (curr == "/" && buff.lookahead(0) == '*') {
-      buff.get_next();  // consume '*'
-      Token et = ml_comment();
-      if (et.get_type() == ERROR) return et;
-      continue;
-    } else if (curr == "-" && buff.lookahead(0) == '-') {
-      /* single line comments */
-      buff.get_next();  // pop trailing '-'
-      while (buff.lookahead(0) != '\n' && buff.has_next()) {
-        buff.get_next();
-      }
-      continue;
-    }
+  int num_chars = buff.cursor() - first - 1;
+  if (num_chars > MAX_STRING_LEN) {
+    string_err_buff = filepath + ":" + to_string(string_start_lineno) + ": " +
+                      "Lexer Error: Verse too long. Maximum string length is " +
+                      to_string(MAX_STRING_LEN);
+    return -1;
+  }
+  return num_chars;
+}
 
-    if (curr == "*" && buff.lookahead(0) == '/') {
-      string err_msg = filepath + ":" + to_string(curr_lineno) +
-                       ": Lexer Error: Unrecognized token " + curr +
-                       buff.lookahead(0);
-      t = Token(curr_lineno, ERROR, err_msg);
-      break;
-    }
+/* keyword, TYPEID, BOOL_CONST or OBJECTID for the word [START, cursor) */
+Token Lexer::word_token(const char *start, int column) {
+  size_t len = buff.cursor() - start;
 
-    if (curr == "\n") {
-      curr_lineno++;
-      continue;
-    }
+  TokenType keyword = lookup_keyword(start, len);
+  if (keyword != EMPTY) {
+    /* keywords are identified by type alone and carry no text */
+    return Token(keyword, curr_lineno, column, start - buff.data(), len,
+                 sym::Empty);
+  }
+  if ((*start >= 'A' && *start <= 'Z') || is_basic_class_name(start, len)) {
+    return make_token(TYPEID, start, column);
+  }
+  if ((len == 4 && !memcmp(start, "true", 4)) ||
+      (len == 5 && !memcmp(start, "false", 5))) {
+    return make_token(BOOL_CONST, start, column);
+  }
+  return make_token(OBJECTID, start, column);
+}
 
-    if (curr == "\t" || curr == " ") continue;
+/* Called from the parser. On each call, returns the next token. Returns an
+   EMPTY token once only blanks and comments are left. */
+Token Lexer::get_next_token() {
+  const char *end = buff.limit();
 
-    // Special characters
-    if (is_special_char(curr)) {
-      t = Token(curr_lineno, SPECIAL_CHAR, curr);
-      break;
+  while (true) {
+    int newlines = 0;
+    const char *after_nl = NULL;
+    const char *p = skip_blanks(buff.cursor(), end, newlines, after_nl);
+    if (newlines) {
+      curr_lineno += newlines;
+      line_start = after_nl;
     }
+    buff.seek(p);
+    if (p == end) return Token(EMPTY);
 
-    /* binary operators */
-    string possible = curr + buff.lookahead(0);
-    if (is_binop(possible)) {
-      curr += buff.get_next();
-      t = Token(curr_lineno, BINOP, curr);
-      break;
-    } else if (is_binop(curr)) {
-      t = Token(curr_lineno, BINOP, curr);
-      break;
-    }
+    const char *start = p;
+    int column = start - line_start + 1;
+    unsigned char c = *p;
+    char next = p + 1 < end ? p[1] : '\0';
 
-    // Handle STRING_CONST
-    if (curr == "\"") {
-      int num_chars = get_string();
-      if (num_chars >= 0) {
-        string str(char_buff, num_chars);
-        t = Token(curr_lineno, STR_CONST, "\"" + str + "\"");
-      } else {
-        t = Token(curr_lineno, ERROR, string_err_buff);
-      }
-      break;
-    }
+    switch (CHARS.cls[c]) {
+      case CC_ALPHA:
+        buff.seek(scan_ident(p + 1, end));
+        return word_token(start, column);
 
-    if (curr == "\'") {
-      string c;
-      c += buff.get_next();
-      if (buff.lookahead(0) != '\'') {
-        // TODO: on char error, need to panic parse until... or include warning?
-        t = Token(curr_lineno, ERROR,
-                  filepath + ":" + to_string(curr_lineno) +
-                      ": Lexer Error: char's must be enclosed in single quotes "
-                      "and only one character long ");
-      } else {
-        buff.get_next();
-        t = Token(curr_lineno, CHAR_CONST, "\'" + c + "\'");
+      case CC_DIGIT: {
+        p = scan_digits(p + 1, end);
+        bool is_deci = p < end && *p == '.';
+        if (is_deci) p = scan_digits(p + 1, end);
+        buff.seek(p);
+        return make_token(is_deci ? DECI_CONST : INT_CONST, start, column);
       }
-      break;
-    }
 
-    // Handle INT_CONST or DECI_CONST
-    if (isnumber(curr[0])) {
-      bool is_deci = false;
-      while (isnumber(buff.lookahead(0))) {
-        curr += buff.get_next();
-      }
-      if (buff.lookahead(0) == '.') {
-        is_deci = true;
-        curr += buff.get_next();
-        while (isnumber(buff.lookahead(0))) {
-          curr += buff.get_next();
+      case CC_SPECIAL:
+        buff.seek(p + 1);
+        return make_token(SPECIAL_CHAR, start, column, CHARS.sym[c]);
+
+      case CC_OP: {
+        if (c == '/' && next == '*') {
+          buff.seek(p + 2);
+          Token et = ml_comment();
+          if (et.get_type() == ERROR) return et;
+          continue;
+        }
+        if (c == '-' && next == '-') {
+          /* single line comments. Leave the '\n' for skip_blanks */
+          const char *nl =
+              static_cast<const char *>(memchr(p + 2, '\n', end - (p + 2)));
+          buff.seek(nl ? nl : end);
+          continue;
+        }
+        if (c == '*' && next == '/') {
+          buff.seek(p + 1);
+          string err_msg = filepath + ":" + to_string(curr_lineno) +
+                           ": Lexer Error: Unrecognized token */";
+          return error_token(curr_lineno, err_msg);
         }
-      }
-      if (is_deci) {
-        t = Token(curr_lineno, DECI_CONST, curr);
-      } else {
-        t = Token(curr_lineno, INT_CONST, curr);
-      }
-      break;
-    }
 
-    // Handle keywords, typeids, objectids
-    if (isalpha(curr[0])) {
-      while (isalnum(buff.lookahead(0)) || buff.lookahead(0) == '_') {
-        curr += buff.get_next();
+        Symbol two = sym::Empty;
+        if (next == '=') {
+          switch (c) {
+            case '<': two = sym::LEQ; break;
+            case '>': two = sym::GEQ; break;
+            case '=': two = sym::Equal; break;
+            case '!': two = sym::NotEqual; break;
+            case '+': two = sym::PlusEquals; break;
+            case '-': two = sym::MinusEquals; break;
+            case '*': two = sym::TimesEquals; break;
+            case '/': two = sym::DivideEquals; break;
+          }
+        } else if (c == '&' && next == '&') {
+          two = sym::And;
+        } else if (c == '|' && next == '|') {
+          two = sym::Or;
+        }
+        if (two != sym::Empty) {
+          buff.seek(p + 2);
+          return make_token(BINOP, start, column, two);
+        }
+        if (CHARS.sym[c] != sym::Empty) {
+          buff.seek(p + 1);
+          return make_token(BINOP, start, column, CHARS.sym[c]);
+        }
+        break; /* a lone '!', '&' or '|' */
       }
 
-      string curr_upper = curr;
-      transform(curr_upper.begin(), curr_upper.end(), curr_upper.begin(),
-                ::toupper);
-
-      if (
-          // KEYWORDS_STR.find(curr_upper) != KEYWORDS_STR.end()
-          is_uppercase_keyword(curr_upper)) {
-        t = Token(curr_lineno, KEYWORDS_STR_TO_TTYPE[curr_upper], "");
-      } else if (isupper(curr[0])
-                 // || BASIC_TYPES.find(curr) != BASIC_TYPES.end()
-                 || is_basic_class(curr)) {
-        t = Token(curr_lineno, TYPEID, curr);
-      } else if (curr == "true" || curr == "false") {
-        t = Token(curr_lineno, BOOL_CONST, curr);
-      } else {
-        t = Token(curr_lineno, OBJECTID, curr);
-      }
-      break;
+      case CC_DQUOTE:
+        /* the token text is the literal with its quotes, as in the source */
+        buff.seek(p + 1);
+        if (get_string() >= 0) return make_token(STR_CONST, start, column);
+        return error_token(curr_lineno, string_err_buff);
+
+      case CC_SQUOTE:
+        buff.seek(p + 2 <= end ? p + 2 : end);
+        if (buff.lookahead(0) != '\'') {
+          // TODO: on char error, need to panic parse until... or include
+          // warning?
+          return error_token(
+              curr_lineno,
+              filepath + ":" + to_string(curr_lineno) +
+                  ": Lexer Error: char's must be enclosed in single quotes "
+                  "and only one character long ");
+        }
+        buff.advance(1);
+        return make_token(CHAR_CONST, start, column);
+
+      default:
+        break;
     }
 
     // Handle unrecognized tokens
+    buff.seek(p + 1);
     string err_msg = filepath + ":" + to_string(curr_lineno) +
-                     ": Lexer Error: Unrecognized token " + curr;
-    t = Token(curr_lineno, ERROR, err_msg);
-    break;
+                     ": Lexer Error: Unrecognized token " + string(1, c);
+    return error_token(curr_lineno, err_msg);
   }
-  return t;
 }
 
 bool Lexer::has_more() { return buff.has_next(); }
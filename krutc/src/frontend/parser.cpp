@@ -2,16 +2,28 @@
 
 #include <cassert>
 #include <cctype>
+#include <climits>
 #include <iostream>
 #include <set>
-#include <stack>
 
 using namespace std;
 
-void Parser::panic_recover(set<string> ss) {
+/* BINOP_PRECEDENCE, indexed by the operator's interned symbol */
+static int get_op_precedence(Symbol op) {
+  static const vector<int> prec = [] {
+    vector<int> p(sym::NUM_PREDEFINED, -1);
+    for (const auto &entry : BINOP_PRECEDENCE) {
+      p[SymbolTable::global().intern(entry.first)] = entry.second;
+    }
+    return p;
+  }();
+  return op < prec.size() ? prec[op] : -1;
+}
+
+void Parser::panic_recover(set<Symbol> ss) {
   while (true) {
-    Token t = tbuff.lookahead(0);
-    if ((ss.find(t.get_str()) != ss.end()) || t.get_type() == EMPTY) {
+    const Token &t = tbuff.lookahead(0);
+    if ((ss.find(t.get_sym()) != ss.end()) || t.get_type() == EMPTY) {
       break;
     }
     tbuff.get_next();
@@ -20,17 +32,17 @@ void Parser::panic_recover(set<string> ss) {
 
 /* For any nested chars: (), {}, [], will pop until final closing one, taking
  * into account that it is possible to be stacked */
-void Parser::panic_recover_nest(string s, string comp, bool show) {
+void Parser::panic_recover_nest(Symbol s, Symbol comp, bool show) {
   int stack = 0;
   if (show) {
     cerr << "      ";
   }
   while (true) {
-    Token t = tbuff.lookahead(0);
-    if (t.get_str() == comp) {
+    const Token &t = tbuff.lookahead(0);
+    if (t.is(comp)) {
       stack++;
     }
-    if (t.get_str() == s) {
+    if (t.is(s)) {
       if (stack == 0) {
         break;
       } else {
@@ -38,7 +50,7 @@ void Parser::panic_recover_nest(string s, string comp, bool show) {
       }
     }
     if (show) {
-      if (t.get_str() == "") {
+      if (t.is(sym::Empty)) {
         cerr << t.get_type_str();
       } else {
         cerr << t.get_str();
@@ -51,13 +63,17 @@ void Parser::panic_recover_nest(string s, string comp, bool show) {
   }
 }
 
+/* once the lexer has failed, the syntax errors that follow are almost always
+   fallout from the bad token, so they are counted but not shown */
 void Parser::parser_error(int lineno, std::string &err_msg) {
+  parser_errors++;
+  if (tbuff.has_errors) return;
   Error e = Error(SYNTAX_ERROR, filename, lineno, err_msg);
   e.print();
-  parser_errors++;
 }
 
 void Parser::parser_warning(int lineno, std::string &warn_msg) {
+  if (tbuff.has_errors) return;
   Warning w = Warning(SYNTAX_ERROR, filename, lineno, warn_msg);
   w.print();
 }
@@ -79,15 +95,15 @@ FormalList Parser::parse_formallist() {
 
   FormalList formal_list;
 
-  while (tbuff.lookahead(0).get_str() != ")") {
-    Type_ *type;
+  while (!tbuff.lookahead(0).is(sym::CloseP)) {
+    Type_ *type = NULL;
     string name;
     Token next = tbuff.lookahead(0);
     int lineno = next.get_lineno();
     if (next.get_type() != TYPEID) {
       string err_msg = "Expected type in formal definition";
       parser_error(lineno, err_msg);
-      if (next.get_str() == ")") {
+      if (next.is(sym::CloseP)) {
         break;
       }
     } else {
@@ -98,7 +114,7 @@ FormalList Parser::parse_formallist() {
     if (next.get_type() != OBJECTID) {
       string err_msg = "Parameter definition missing name";
       parser_error(lineno, err_msg);
-      if (next.get_str() == ")") {
+      if (next.is(sym::CloseP)) {
         break;
       }
     } else {
@@ -106,18 +122,18 @@ FormalList Parser::parse_formallist() {
     }
     tbuff.get_next();
 
-    FormalStmt *f = new FormalStmt(type, name);
+    FormalStmt *f = arena.make<FormalStmt>(type, name);
     f->lineno = lineno;
     formal_list.push_back(f);
 
-    if (tbuff.lookahead(0).get_str() == ",") {
+    if (tbuff.lookahead(0).is(sym::Comma)) {
       tbuff.get_next();
-      if (tbuff.lookahead(0).get_str() == ")") {
+      if (tbuff.lookahead(0).is(sym::CloseP)) {
         string warn_msg = "Expected another formal definition";
         parser_warning(lineno, warn_msg);
         break;
       }
-    } else if (tbuff.lookahead(0).get_str() == ")") {
+    } else if (tbuff.lookahead(0).is(sym::CloseP)) {
       break;
     } else if (tbuff.lookahead(0).get_type() == TYPEID) {
       /* case: void meth(int a int b) {...} */
@@ -130,7 +146,7 @@ FormalList Parser::parse_formallist() {
           "Expected either ',' or closing ')' in formal definition. Instead "
           "got:";
       parser_error(lineno, err_msg);
-      panic_recover_nest(")", "(", true);
+      panic_recover_nest(sym::CloseP, sym::OpenP, true);
     }
   }
 
@@ -145,15 +161,15 @@ MethodStmt *Parser::parse_methodstmt(Type_ *type, string name) {
   FormalList formal_list;
   StmtList stmt_list;
 
-  parse_check_and_pop("(");  // pop leading "("
+  parse_check_and_pop(sym::OpenP);  // pop leading "("
 
   formal_list = parse_formallist();
 
-  parse_check_and_pop(")");  // pop closing ')'
+  parse_check_and_pop(sym::CloseP);  // pop closing ')'
 
-  parse_check_and_pop("{");  // parse opening {
+  parse_check_and_pop(sym::OpenBrace);  // parse opening {
 
-  while (tbuff.lookahead(0).get_str() != "}" && tbuff.has_next()) {
+  while (!tbuff.lookahead(0).is(sym::CloseBrace) && tbuff.has_next()) {
     Stmt *stmt = parse_stmt();
     if (dynamic_cast<ClassStmt *>(stmt)) {
       string err_msg = "Class can only be defined in outer scope";
@@ -162,9 +178,10 @@ MethodStmt *Parser::parse_methodstmt(Type_ *type, string name) {
     stmt_list.push_back(stmt);
   }
 
-  parse_check_and_pop("}");
+  parse_check_and_pop(sym::CloseBrace);
 
-  MethodStmt *methodstmt = new MethodStmt(type, name, formal_list, stmt_list);
+  MethodStmt *methodstmt =
+      arena.make<MethodStmt>(type, name, formal_list, stmt_list);
   methodstmt->lineno = methodstmt_lineno;
   debug_msg("END parse_method_stmt()");
 
@@ -175,23 +192,22 @@ AttrStmt *Parser::parse_attrstmt(Type_ *type, string name) {
   debug_msg("BEGIN parse_attrstmt()");
   int attrstmt_lineno = tbuff.lookahead(0).get_lineno();
   // string name;
-  ExprStmt *init;
+  ExprStmt *init = NULL;
 
   Token decider_tok = tbuff.lookahead(0);
-  if (decider_tok.get_str() == ";") {
+  if (decider_tok.is(sym::SemiColon)) {
     tbuff.get_next();  // pop ';'
     init = NULL;
-  } else if (decider_tok.get_str() == "=") {
+  } else if (decider_tok.is(sym::Define)) {
     tbuff.get_next();  // pop "="
-    if (tbuff.lookahead(0).get_str() == ";") {
+    if (tbuff.lookahead(0).is(sym::SemiColon)) {
       string err_msg = "Expected expression after attribute definition";
       parser_error(tbuff.lookahead(0).get_lineno(), err_msg);
       init = NULL;
-    } else if (!build_expr_tq(";"))
-      init = NULL;
-    else
-      init = parse_exprstmt();
-    parse_check_and_pop(";");
+    } else {
+      init = parse_exprstmt(sym::SemiColon);
+    }
+    parse_check_and_pop(sym::SemiColon);
   } else {
     /* this should never hit because its checked in parse_features() */
     string err_msg =
@@ -200,7 +216,7 @@ AttrStmt *Parser::parse_attrstmt(Type_ *type, string name) {
     parser_error(decider_tok.get_lineno(), err_msg);
   }
 
-  AttrStmt *attrstmt = new AttrStmt(type, name, init);
+  AttrStmt *attrstmt = arena.make<AttrStmt>(type, name, init);
   attrstmt->lineno = attrstmt_lineno;
   debug_msg("END parse_attrstmt()");
   return attrstmt;
@@ -209,8 +225,9 @@ AttrStmt *Parser::parse_attrstmt(Type_ *type, string name) {
 Type_ *Parser::parse_typeexpr() {
   debug_msg("BEGIN parse_typeexpr()");
 
-  string name;
+  Symbol name;
   Type_ *nested;
+  Type_ *value = NULL;
   int lineno = tbuff.lookahead(0).get_lineno();
 
   Token name_tok = tbuff.lookahead(0);
@@ -218,16 +235,20 @@ Type_ *Parser::parse_typeexpr() {
     string err_msg = "Expected typeid in type declaration. Instead got `" +
                      name_tok.get_str() + "`";
     parser_error(lineno, err_msg);
-    name = "";
+    name = sym::Empty;
   } else {
-    name = name_tok.get_str();
+    name = name_tok.get_sym();
   }
   tbuff.get_next();  // pop outer Type_
 
-  if (tbuff.lookahead(0).get_str() == "<") {
+  if (tbuff.lookahead(0).is(sym::LessThan)) {
     tbuff.get_next();  // pop opening '<'
     nested = parse_typeexpr();
-    if (tbuff.lookahead(0).get_str() == ">") {
+    if (tbuff.lookahead(0).is(sym::Comma)) {
+      tbuff.get_next();  // pop ',' before a second type argument
+      value = parse_typeexpr();
+    }
+    if (tbuff.lookahead(0).is(sym::GreaterThan)) {
       tbuff.get_next();  // pop closing '>'
     } else {
       string err_msg = "Expected closing caret '>'";
@@ -237,8 +258,7 @@ Type_ *Parser::parse_typeexpr() {
     nested = NULL;
   }
 
-  Type_ *expr = new Type_(name, nested);
-  expr->lineno = lineno;
+  Type_ *expr = types.get(name, nested, value);
   debug_msg("END parse_typeexpr()");
   return expr;
 }
@@ -249,12 +269,12 @@ Feature *Parser::parse_feature() {
 
   Type_ *type = parse_typeexpr();
 
-  if (tbuff.lookahead(0).get_str() == ">") {
+  if (tbuff.lookahead(0).is(sym::GreaterThan)) {
     string err_msg = "Unbalanced '<' '>' in type declaration";
     parser_error(tbuff.lookahead(0).get_lineno(), err_msg);
     tbuff.get_next();
 
-    while (tbuff.lookahead(0).get_str() == ">") {
+    while (tbuff.lookahead(0).is(sym::GreaterThan)) {
       tbuff.get_next();
     }
   }
@@ -270,15 +290,15 @@ Feature *Parser::parse_feature() {
   } else {
     name = name_tok.get_str();
   }
-  if (name_tok.get_type() != SPECIAL_CHAR && name_tok.get_str() != "=") {
+  if (name_tok.get_type() != SPECIAL_CHAR && !name_tok.is(sym::Define)) {
     tbuff.get_next();
   }
 
   Feature *f;
-  if (tbuff.lookahead(0).get_str() == "(") {
+  if (tbuff.lookahead(0).is(sym::OpenP)) {
     f = parse_methodstmt(type, name);
-  } else if (tbuff.lookahead(0).get_str() == ";" ||
-             tbuff.lookahead(0).get_str() == "=") {
+  } else if (tbuff.lookahead(0).is(sym::SemiColon) ||
+             tbuff.lookahead(0).is(sym::Define)) {
     f = parse_attrstmt(type, name);
   } else {
     string err_msg =
@@ -291,16 +311,17 @@ Feature *Parser::parse_feature() {
   return f;
 }
 
-int Parser::parse_check_and_pop(string s) {
+int Parser::parse_check_and_pop(Symbol s) {
+  const string &s_str = SymbolTable::global().str(s);
   if (!tbuff.has_next()) {
-    string err_msg = "Expected '" + s + "', instead got EOF";
+    string err_msg = "Expected '" + s_str + "', instead got EOF";
     parser_error(0, err_msg);
     return -1;
   }
   Token t = tbuff.lookahead(0);
-  if (t.get_str() != s) {
+  if (!t.is(s)) {
     string err_msg =
-        "Error: Expected '" + s + "', instead got '" + t.get_str() + "'";
+        "Error: Expected '" + s_str + "', instead got '" + t.get_str() + "'";
     parser_error(t.get_lineno(), err_msg);
     panic_recover({s});
     tbuff.get_next();  // pop t
@@ -318,16 +339,15 @@ ForStmt *Parser::parse_for_stmt() {
   ExprStmt *repeat;
   StmtList stmt_list;
 
-  Token for_tok = tbuff.lookahead(0);
-  assert(for_tok.get_type() == FOR);
+  assert(tbuff.lookahead(0).get_type() == FOR);
   tbuff.get_next();  // pop 'FOR'
 
-  parse_check_and_pop("(");
+  parse_check_and_pop(sym::OpenP);
 
   Token next = tbuff.lookahead(0);
-  if (next.get_str() == ";") {
+  if (next.is(sym::SemiColon)) {
     stmt = NULL;
-    parse_check_and_pop(";");  // pop ';'
+    parse_check_and_pop(sym::SemiColon);  // pop ';'
   } else {
     stmt = parse_stmt();
 
@@ -337,35 +357,29 @@ ForStmt *Parser::parse_for_stmt() {
            << endl;
     }
 
-    if (tbuff.lookahead(0).get_str() == ";") {
+    if (tbuff.lookahead(0).is(sym::SemiColon)) {
       /* if stmt is of type Stmt */
-      parse_check_and_pop(";");
+      parse_check_and_pop(sym::SemiColon);
     }
   }
 
-  if (tbuff.lookahead(0).get_str() != ";") {
-    if (!build_expr_tq(";"))
-      stmt = NULL;
-    else
-      cond = parse_exprstmt();
+  if (!tbuff.lookahead(0).is(sym::SemiColon)) {
+    cond = parse_exprstmt(sym::SemiColon);
   } else {
     cond = NULL;
   }
-  parse_check_and_pop(";");  // pop ';'
+  parse_check_and_pop(sym::SemiColon);  // pop ';'
 
-  if (tbuff.lookahead(0).get_str() != ")") {
-    if (!build_expr_tq(")"))
-      repeat = NULL;
-    else
-      repeat = parse_exprstmt();
+  if (!tbuff.lookahead(0).is(sym::CloseP)) {
+    repeat = parse_exprstmt(sym::CloseP);
   } else {
     repeat = NULL;
   }
-  parse_check_and_pop(")");  // pop ')'
+  parse_check_and_pop(sym::CloseP);  // pop ')'
 
-  parse_check_and_pop("{");
+  parse_check_and_pop(sym::OpenBrace);
 
-  while (tbuff.has_next() && tbuff.lookahead(0).get_str() != "}") {
+  while (tbuff.has_next() && !tbuff.lookahead(0).is(sym::CloseBrace)) {
     Stmt *stmt = parse_stmt();
     if (dynamic_cast<ClassStmt *>(stmt)) {
       string err_msg = "Class can only be defined in outer scope";
@@ -374,9 +388,9 @@ ForStmt *Parser::parse_for_stmt() {
     stmt_list.push_back(stmt);
   }
 
-  parse_check_and_pop("}");
+  parse_check_and_pop(sym::CloseBrace);
 
-  ForStmt *for_stmt = new ForStmt(stmt, cond, repeat, stmt_list);
+  ForStmt *for_stmt = arena.make<ForStmt>(stmt, cond, repeat, stmt_list);
   for_stmt->lineno = forstmt_lineno;
   debug_msg("END parse_for_stmt()");
   return for_stmt;
@@ -386,7 +400,7 @@ vector<string> Parser::get_parents() {
   tbuff.get_next();  // pop keyword INHERITS
 
   vector<string> parents;
-  while (tbuff.has_next() && tbuff.lookahead(0).get_str() != "{") {
+  while (tbuff.has_next() && !tbuff.lookahead(0).is(sym::OpenBrace)) {
     Token parent = tbuff.lookahead(0);
     if (parent.get_type() != TYPEID) {
       string err_msg = "Inheritee cannot be of type " + parent.get_type_str();
@@ -407,9 +421,9 @@ vector<string> Parser::get_parents() {
     tbuff.get_next();  // pop parent token
 
     Token next = tbuff.lookahead(0);
-    if (next.get_str() == "{")  // dont pop '{'
+    if (next.is(sym::OpenBrace))  // dont pop '{'
       break;
-    if (next.get_str() == ",") {  // pop ','
+    if (next.is(sym::Comma)) {  // pop ','
       tbuff.get_next();
       continue;
     } else {
@@ -429,8 +443,7 @@ ClassStmt *Parser::parse_class_stmt() {
   vector<string> parents;
   FeatureList feature_list;
 
-  Token class_tok = tbuff.lookahead(0);
-  assert(class_tok.get_type() == CLASS);
+  assert(tbuff.lookahead(0).get_type() == CLASS);
   tbuff.get_next();  // pop CLASS
 
   Token next = tbuff.lookahead(0);
@@ -452,15 +465,15 @@ ClassStmt *Parser::parse_class_stmt() {
     }
   }
 
-  parse_check_and_pop("{");
+  parse_check_and_pop(sym::OpenBrace);
 
-  while (tbuff.has_next() && tbuff.lookahead(0).get_str() != "}") {
+  while (tbuff.has_next() && !tbuff.lookahead(0).is(sym::CloseBrace)) {
     if (tbuff.lookahead(0).get_type() != TYPEID) {
       string err_msg =
           "Every CLASS must be defined by only METHODS or ATTRIBUTES";
       parser_error(tbuff.lookahead(0).get_lineno(), err_msg);
       // recover to next typeid
-      panic_recover({"}", ";"});
+      panic_recover({sym::CloseBrace, sym::SemiColon});
       tbuff.get_next();
       continue;
     }
@@ -468,9 +481,9 @@ ClassStmt *Parser::parse_class_stmt() {
     feature_list.push_back(f);
   }
 
-  parse_check_and_pop("}");
+  parse_check_and_pop(sym::CloseBrace);
 
-  ClassStmt *class_stmt = new ClassStmt(name, parents, feature_list);
+  ClassStmt *class_stmt = arena.make<ClassStmt>(name, parents, feature_list);
   class_stmt->lineno = classstmt_lineno;
   debug_msg("END parse_class_stmt()");
   return class_stmt;
@@ -485,17 +498,14 @@ IfStmt *Parser::parse_if_stmt() {
   tbuff.get_next();  // pop if
 
   /* evaluate expression */
-  parse_check_and_pop("(");
-  if (!build_expr_tq(")"))
-    pred = NULL;
-  else
-    pred = parse_exprstmt();
-  parse_check_and_pop(")");
+  parse_check_and_pop(sym::OpenP);
+  pred = parse_exprstmt(sym::CloseP);
+  parse_check_and_pop(sym::CloseP);
 
-  parse_check_and_pop("{");
+  parse_check_and_pop(sym::OpenBrace);
 
   while (true) {
-    if (tbuff.lookahead(0).get_str() == "}" ||
+    if (tbuff.lookahead(0).is(sym::CloseBrace) ||
         tbuff.lookahead(0).get_type() == EMPTY) {
       break;
     }
@@ -510,14 +520,14 @@ IfStmt *Parser::parse_if_stmt() {
     }
   }
 
-  parse_check_and_pop("}");
+  parse_check_and_pop(sym::CloseBrace);
 
   if (tbuff.lookahead(0).get_type() == ELSE) {
     tbuff.get_next();  // pop else
-    parse_check_and_pop("{");
+    parse_check_and_pop(sym::OpenBrace);
 
     while (true) {
-      if (tbuff.lookahead(0).get_str() == "}" ||
+      if (tbuff.lookahead(0).is(sym::CloseBrace) ||
           tbuff.lookahead(0).get_type() == EMPTY) {
         break;
       }
@@ -531,10 +541,10 @@ IfStmt *Parser::parse_if_stmt() {
       }
     }
 
-    parse_check_and_pop("}");
+    parse_check_and_pop(sym::CloseBrace);
   }
 
-  IfStmt *if_stmt = new IfStmt(pred, then_branch, else_branch);
+  IfStmt *if_stmt = arena.make<IfStmt>(pred, then_branch, else_branch);
   if_stmt->lineno = lineno;
   debug_msg("END parse_if_stmt()");
   return if_stmt;
@@ -549,17 +559,14 @@ WhileStmt *Parser::parse_while_stmt() {
   tbuff.get_next();  // pop 'while'
 
   /* evaluate expression */
-  parse_check_and_pop("(");
-  if (!build_expr_tq(")"))
-    pred = NULL;
-  else
-    pred = parse_exprstmt();
-  parse_check_and_pop(")");
+  parse_check_and_pop(sym::OpenP);
+  pred = parse_exprstmt(sym::CloseP);
+  parse_check_and_pop(sym::CloseP);
 
-  parse_check_and_pop("{");
+  parse_check_and_pop(sym::OpenBrace);
 
   while (true) {
-    if (tbuff.lookahead(0).get_str() == "}" ||
+    if (tbuff.lookahead(0).is(sym::CloseBrace) ||
         tbuff.lookahead(0).get_type() == EMPTY) {
       break;
     }
@@ -573,9 +580,9 @@ WhileStmt *Parser::parse_while_stmt() {
     }
   }
 
-  parse_check_and_pop("}");
+  parse_check_and_pop(sym::CloseBrace);
 
-  WhileStmt *whilestmt = new WhileStmt(pred, stmt_list);
+  WhileStmt *whilestmt = arena.make<WhileStmt>(pred, stmt_list);
   whilestmt->lineno = lineno;
   debug_msg("END parse_while_stmt()");
   return whilestmt;
@@ -588,236 +595,243 @@ WhileStmt *Parser::parse_while_stmt() {
 //
 //
 ////////////////////////////////////////////////////////////
-void Parser::calibrate_expr_tq() {
-  int lineno = expr_tq.tq.front().get_lineno();
-  int binop_index = -1;
-  int binop_prec = -1;
-  stack<string> stk;
-
-  for (int i = 0; i < (int)expr_tq.tq.size(); i++) {
-    Token t = expr_tq.tq[i];
-    if (t.get_str() == "(" || t.get_str() == "[")
-      stk.push(t.get_str());
-    else if (t.get_str() == ")" || t.get_str() == "]")
-      stk.pop();
-    else if (t.get_type() == BINOP && stk.empty()) {
-      int curr_precedence = get_op_precedence(t.get_str());
-      if (curr_precedence > binop_prec) {
-        binop_prec = curr_precedence;
-        binop_index = i;
-      }
-    }
-  }
-  expr_tq.lineno = lineno;
-  expr_tq.binop_index = binop_index;
-  expr_tq.binop_prec = binop_prec;
-}
-
-/* builds up an expression token deque which stops after finding 'S'*/
-bool Parser::build_expr_tq(string s) {
-  int lineno = tbuff.lookahead(0).get_lineno();
-  int binop_index = -1;
-  int binop_prec = -1;
-  int paren_stack = 0;
-  int bracket_stack = 0;
 
-  stack<string> stk;
-  bool stk_error = false;
+/*
+  Expressions are parsed in one pass straight off the TokenBuffer by
+  precedence climbing over BINOP_PRECEDENCE. A higher precedence number binds
+  more loosely: `* /`, then `+ -`, comparisons, `== !=`, `&&`, `||`, and
+  assignments last. Operators of equal precedence group to the left, so
+  `a - b - c` is `(a - b) - c`, except assignments, which group to the
+  right.
+
+  A missing operand is not an error: `-5` is a BinopExpr with a NULL lhs and
+  `x = ;` one with a NULL rhs. An operator with no left operand applies to
+  the operand right after it, so `-a * b` is `(-a) * b`.
+
+  Every node's lineno is the line of the first token of its source range.
+*/
+#define LOOSEST_PREC INT_MAX
+
+/* records the first error in the current expression; later ones are fallout
+   and are swallowed. parse_exprstmt() reports it once it has recovered */
+void Parser::expr_fail(int lineno, string err_msg, bool dump) {
+  if (expr_error) return;
+  expr_error = true;
+  expr_err_lineno = lineno;
+  expr_err_msg = err_msg;
+  expr_dump = dump;
+}
 
-  int i = -1;
+/* skips the rest of a failed expression, up to END or ';' outside of any
+   brackets, and reports the error. Dumps the skipped tokens if expr_fail()
+   asked for it */
+void Parser::expr_recover(Symbol end) {
+  string skipped;
+  int depth = 0;
   while (true) {
-    i++;
-    Token t = tbuff.lookahead(0);
-    /* regardless of S, expr cannot include ';' */
-    if (t.get_type() == EMPTY || t.get_str() == ";") {
-      break;
-    }
-
-    /* sometimes the expression ends with a ')' and expression contains parens
-     */
-    if (t.get_str() == s) {
-      if (s != ")")
-        break;
-      else if (stk.empty())
-        break;
+    const Token &t = tbuff.lookahead(0);
+    if (t.get_type() == EMPTY || t.is(sym::SemiColon)) break;
+    if (depth == 0 && t.is(end)) break;
+
+    if (t.is(sym::OpenP) || t.is(sym::OpenBrack)) {
+      depth++;
+    } else if ((t.is(sym::CloseP) || t.is(sym::CloseBrack)) && depth > 0) {
+      depth--;
     }
+    skipped += (t.is(sym::Empty) ? t.get_type_str() : t.get_str()) + " ";
+    tbuff.get_next();
+  }
 
-    if (t.get_str() == "[" || t.get_str() == "(")
-      stk.push(t.get_str());
-    else if (t.get_str() == ")") {
-      if (!stk.empty()) {
-        string top = stk.top();
-        if (top == "(") {
-          stk.pop();
-        } else {
-          stk_error = true;
-        }
-      } else {
-        stk_error = true;
-      }
-    } else if (t.get_str() == "]") {
-      if (!stk.empty()) {
-        string top = stk.top();
-        if (top == "[") {
-          stk.pop();
-        } else {
-          stk_error = true;
-        }
-      } else {
-        stk_error = true;
-      }
-    }
+  parser_error(expr_err_lineno, expr_err_msg);
+  if (expr_dump && !tbuff.has_errors) cout << skipped << endl;
+}
 
-    else if (stk.empty() && t.get_type() == BINOP) {
-      int curr_prec = get_op_precedence(t.get_str());
-      if (curr_prec > binop_prec) {
-        binop_index = i;
-        binop_prec = curr_prec;
-      }
-    }
+/* true if the next token can end an expression that is terminated by END */
+bool Parser::at_expr_end(Symbol end) {
+  const Token &t = tbuff.lookahead(0);
+  return t.get_type() == EMPTY || t.is(sym::SemiColon) || t.is(end);
+}
 
-    expr_tq.tq.push_back(t);
+/* consumes CLOSE, which ends a bracketed expression starting on LINENO */
+void Parser::expect_close(Symbol close, int lineno) {
+  const Token &t = tbuff.lookahead(0);
+  if (t.is(close)) {
     tbuff.get_next();
+    return;
   }
-
-  expr_tq.lineno = lineno;
-  expr_tq.binop_index = binop_index;
-  expr_tq.binop_prec = binop_prec;
-
-  if (!stk.empty() || stk_error) {
-    string err_msg = "Unbalanced '[' ']' or '(' ')'";
-    parser_error(lineno, err_msg);
-    expr_tq.tq.clear();
-    return false;
+  if (t.get_type() == EMPTY || t.is(sym::SemiColon) || t.is(sym::CloseP) ||
+      t.is(sym::CloseBrack) || t.is(sym::CloseBrace)) {
+    expr_fail(expr_lineno, "Unbalanced '[' ']' or '(' ')'", false);
+  } else {
+    expr_fail(lineno, "Unrecognized expression", true);
   }
-
-  return true;
 }
 
-ExprStmt *Parser::parse_exprstmt() {
+/* parses an expression terminated by END (or ';'), leaving END in the
+   buffer. Returns NULL for an empty or malformed expression */
+ExprStmt *Parser::parse_exprstmt(Symbol end) {
   debug_msg("BEGIN: parse_exprstmt()");
-
-  if (expr_tq.tq.empty()) return NULL;
-
-  calibrate_expr_tq();
-
-  ExprStmt *expr;
-  int lineno = expr_tq.tq.front().get_lineno();
-
-  /* check to see expr type */
-  Token t = expr_tq.tq.front();
-  if (expr_tq.binop_index != -1) {
-    expr = parse_binopexpr();
-  } else if (t.get_type() == RETURN) {
-    expr = parse_returnexpr();
-  } else if (t.get_type() == NEW) {
-    expr = parse_newexpr();
-  } else if (t.get_type() == INT_CONST) {
-    expr = parse_int_const_expr();
-  } else if (t.get_type() == DECI_CONST) {
-    expr = parse_deci_const_expr();
-  } else if (t.get_type() == BOOL_CONST) {
-    expr = parse_bool_const_expr();
-  } else if (t.get_type() == STR_CONST) {
-    expr = parse_str_const_expr();
-  } else if (t.get_type() == CHAR_CONST) {
-    expr = parse_char_const_expr();
-  } else if (t.get_type() == OBJECTID && expr_tq.tq.size() == 1) {
-    expr = parse_objectid_expr();
-  } else if (t.get_str() == "[" && expr_tq.tq.back().get_str() == "]") {
-    expr = parse_list_const_expr();
-  } else if (t.get_str() == "(" && expr_tq.tq.back().get_str() == ")") {
-    expr_tq.tq.pop_front();
-    expr_tq.tq.pop_back();
-    expr = parse_exprstmt();
-  } else if (expr_tq.tq.back().get_str() == ")") {
-    expr = parse_dispexpr();
-  } else if (expr_tq.tq.back().get_str() == "]") {
-    expr = parse_list_elem_ref_expr();
-  } else if (t.get_str() == "{" && expr_tq.tq.back().get_str() == "}") {
-    expr = parse_set_const_expr();
-  }
-
-  if (!expr_tq.tq.empty()) {
-    if (t.get_type() == OBJECTID) {
-      // error here on an attribute that is not basic and lowercase
-      // ex: gang g;
+  expr_error = false;
+  expr_dump = false;
+  expr_lineno = tbuff.lookahead(0).get_lineno();
+
+  ExprStmt *expr = parse_binopexpr(LOOSEST_PREC);
+  if (!expr_error && !at_expr_end(end)) {
+    const Token &t = tbuff.lookahead(0);
+    if (t.is(sym::CloseP) || t.is(sym::CloseBrack)) {
+      expr_fail(expr_lineno, "Unbalanced '[' ']' or '(' ')'", false);
+    } else {
+      expr_fail(expr_lineno, "Unrecognized expression", true);
     }
-    bool val = expr_tq.tq.back().get_str() == ")";
-    string err_msg = "Unrecognized expression";
-    parser_error(lineno, err_msg);
-    expr_tq.dump();
-    expr_tq.tq.clear();
+  }
+  if (expr_error) {
+    expr_recover(end);
     return NULL;
   }
 
-  expr->lineno = lineno;
   debug_msg("END: parse_exprstmt()");
   return expr;
 }
 
-ExprList Parser::parse_comma_separated_exprlist() {
-  ExprList exprlist;
+/* parses operands joined by binops of precedence MAX_PREC or tighter */
+ExprStmt *Parser::parse_binopexpr(int max_prec) {
+  int lineno = tbuff.lookahead(0).get_lineno();
+  ExprStmt *lhs = parse_postfixexpr();
+  bool prefix = !lhs;
+
+  while (!expr_error) {
+    const Token &t = tbuff.lookahead(0);
+    if (t.get_type() != BINOP) break;
+    int prec = get_op_precedence(t.get_sym());
+    if (prec > max_prec && !prefix) break;
+
+    debug_msg("BEGIN parse_binopexpr()");
+    string op = t.get_str();
+    tbuff.get_next();  // pop op
+    /* the right side takes only tighter operators, which groups equal
+       ones to the left; assignments take their own level too */
+    int rhs_prec = prefix ? -1 : lexing::is_assign_op(op) ? prec : prec - 1;
+    ExprStmt *rhs = parse_binopexpr(rhs_prec);
+    bool negation = prefix && op == lexing::Minus;
+    prefix = false;
+
+    if (negation) {
+      /* -x as 0 - x; an int 0 takes x's type in the arithmetic */
+      lhs = arena.make<IntConstExpr>(0);
+      lhs->lineno = lineno;
+    }
+    lhs = arena.make<BinopExpr>(lhs, op, rhs, negation);
+    lhs->lineno = lineno;
+    debug_msg("END parse_binopexpr()");
+  }
+  return lhs;
+}
 
-  ExprTQ original = expr_tq;
-  expr_tq.tq.clear();
+/* a primary followed by any number of `.name(args)` and `[index]` */
+ExprStmt *Parser::parse_postfixexpr() {
+  int lineno = tbuff.lookahead(0).get_lineno();
+  ExprStmt *expr = parse_primaryexpr();
+  if (!expr) return NULL;
+
+  while (!expr_error) {
+    const Token &t = tbuff.lookahead(0);
+    if (t.is(sym::Period)) {
+      tbuff.get_next();  // pop '.'
+      expr = parse_dispexpr(expr, lineno);
+    } else if (t.is(sym::OpenBrack)) {
+      expr = parse_list_elem_ref_expr(expr, lineno);
+    } else {
+      break;
+    }
+    if (expr) expr->lineno = lineno;
+  }
+  return expr;
+}
 
-  int stack = 0;
-  while (!original.tq.empty()) {
-    Token t = original.tq.front();
-    original.tq.pop_front();
-    if (t.get_str() == "(" || t.get_str() == "[")
-      stack++;
-    else if (t.get_str() == ")" || t.get_str() == "]")
-      stack--;
-    else if (t.get_str() == "," && stack == 0) {
-      if (original.tq.empty()) {
-        string err_msg = "Expected expression after ','";
-        parser_error(t.get_lineno(), err_msg);
-      }
+/* returns NULL, consuming nothing, if the next token cannot start an
+   operand */
+ExprStmt *Parser::parse_primaryexpr() {
+  const Token &t = tbuff.lookahead(0);
+  int lineno = t.get_lineno();
 
-      ExprStmt *expr = parse_exprstmt();
-      if (expr) exprlist.push_back(expr);
-      continue;
-    }
+  switch (t.get_type()) {
+    case RETURN:
+      return parse_returnexpr();
+    case NEW:
+      return parse_newexpr();
+    case INT_CONST:
+      return parse_int_const_expr();
+    case DECI_CONST:
+      return parse_deci_const_expr();
+    case BOOL_CONST:
+      return parse_bool_const_expr();
+    case STR_CONST:
+      return parse_str_const_expr();
+    case CHAR_CONST:
+      return parse_char_const_expr();
+    case OBJECTID:
+    case TYPEID:
+      if (tbuff.lookahead(1).is(sym::OpenP)) {
+        /* a call with no calling object, e.g. print(s) */
+        return parse_dispexpr(NULL, lineno);
+      }
+      if (t.get_type() == OBJECTID) return parse_objectid_expr();
+      return NULL;
+    default:
+      break;
+  }
 
-    expr_tq.tq.push_back(t);
+  if (t.is(sym::OpenP)) {
+    tbuff.get_next();  // pop '('
+    ExprStmt *expr = parse_binopexpr(LOOSEST_PREC);
+    expect_close(sym::CloseP, lineno);
+    if (expr) expr->lineno = lineno;
+    return expr;
   }
+  if (t.is(sym::OpenBrack)) return parse_list_const_expr();
+  if (t.is(sym::OpenBrace)) return parse_set_const_expr();
+  return NULL;
+}
 
-  /* for the spill over*/
-  if (!expr_tq.tq.empty()) {
-    ExprStmt *expr = parse_exprstmt();
+/* parses `expr, expr, ...` up to, and including, CLOSE */
+ExprList Parser::parse_comma_separated_exprlist(Symbol close) {
+  ExprList exprlist;
+
+  while (!expr_error && !tbuff.lookahead(0).is(close)) {
+    int lineno = tbuff.lookahead(0).get_lineno();
+    ExprStmt *expr = parse_binopexpr(LOOSEST_PREC);
+    if (expr_error) break;
     if (expr) exprlist.push_back(expr);
+
+    const Token &t = tbuff.lookahead(0);
+    if (t.is(sym::Comma)) {
+      int comma_lineno = t.get_lineno();
+      tbuff.get_next();  // pop ','
+      if (tbuff.lookahead(0).is(close)) {
+        expr_fail(comma_lineno, "Expected expression after ','", false);
+      }
+    } else if (!t.is(close)) {
+      expect_close(close, lineno);
+    }
   }
 
+  if (!expr_error) tbuff.get_next();  // pop close
   return exprlist;
 }
 
 SetConstExpr *Parser::parse_set_const_expr() {
   debug_msg("BEGIN parse_set_const_expr()");
   ExprSet exprset;
-  int lineno = expr_tq.tq[0].get_lineno();
-  assert(expr_tq.tq.front().get_str() == "{");
-  assert(expr_tq.tq.back().get_str() == "}");
-
-  if (expr_tq.tq.empty()) {
-    /* this is allowed. ex: set s = {}; */
-    return NULL;
-  }
-
-  expr_tq.tq.pop_front();
-  expr_tq.tq.pop_back();
-
-  ExprList exprlist;
-  if (!expr_tq.tq.empty()) {
-    exprlist = parse_comma_separated_exprlist();
-  }
+  int lineno = tbuff.lookahead(0).get_lineno();
+  assert(tbuff.lookahead(0).is(sym::OpenBrace));
+  tbuff.get_next();  // pop '{'
 
+  ExprList exprlist = parse_comma_separated_exprlist(sym::CloseBrace);
   for (ExprStmt *e : exprlist) {
     exprset.insert(e);
   }
 
-  SetConstExpr *scex = new SetConstExpr(exprset);
+  SetConstExpr *scex = arena.make<SetConstExpr>(exprset);
   scex->lineno = lineno;
   debug_msg("END parse_set_const_expr()");
   return scex;
@@ -825,183 +839,78 @@ SetConstExpr *Parser::parse_set_const_expr() {
 
 ListConstExpr *Parser::parse_list_const_expr() {
   debug_msg("BEGIN parse_list_const_expr()");
-  ExprList exprlist;
-  int lineno = expr_tq.tq[0].get_lineno();
-  assert(expr_tq.tq.front().get_str() == "[");
-  assert(expr_tq.tq.back().get_str() == "]");
-
-  if (expr_tq.tq.empty()) {
-    /* this is allowed. ex: list l = []; */
-    return NULL;
-  }
-
-  expr_tq.tq.pop_front();
-  expr_tq.tq.pop_back();
+  int lineno = tbuff.lookahead(0).get_lineno();
+  assert(tbuff.lookahead(0).is(sym::OpenBrack));
+  tbuff.get_next();  // pop '['
 
-  if (!expr_tq.tq.empty()) {
-    exprlist = parse_comma_separated_exprlist();
-  }
+  ExprList exprlist = parse_comma_separated_exprlist(sym::CloseBrack);
 
-  ListConstExpr *list_const_expr = new ListConstExpr(exprlist);
+  ListConstExpr *list_const_expr = arena.make<ListConstExpr>(exprlist);
   list_const_expr->lineno = lineno;
   debug_msg("END parse_list_const_expr()");
   return list_const_expr;
 }
 
-SublistExpr *Parser::parse_sublist_expr(int colon_idx, ExprStmt *list_name) {
-  ExprStmt *st_idx;
-  ExprStmt *end_idx;
-
-  ExprTQ original = expr_tq;
-  expr_tq.tq.clear();
-  for (int i = 0; i < colon_idx; i++) {
-    expr_tq.tq.push_back(original.tq[i]);
-  }
-  if (!expr_tq.tq.empty())
-    st_idx = parse_exprstmt();
-  else  // need to be set to NULL because they are optional
-    st_idx = NULL;
-
-  expr_tq.tq.clear();
-  for (int i = colon_idx + 1; i < (int)original.tq.size(); i++) {
-    expr_tq.tq.push_back(original.tq[i]);
-  }
-  if (!expr_tq.tq.empty())
-    end_idx = parse_exprstmt();
-  else  // need to be set to NULL because they are optional
-    end_idx = NULL;
-
-  SublistExpr *sle = new SublistExpr(list_name, st_idx, end_idx);
-  return sle;
-}
-
-ListElemRef *Parser::parse_list_elem_ref_expr() {
-  int lineno = expr_tq.tq[0].get_lineno();
-  ExprStmt *list_name;
-  ExprStmt *index;
-
-  assert(expr_tq.tq.back().get_str() == "]");
+/* `list_name[index]`, or `list_name[start:end]` with either index optional */
+ListElemRef *Parser::parse_list_elem_ref_expr(ExprStmt *list_name,
+                                              int lineno) {
+  assert(tbuff.lookahead(0).is(sym::OpenBrack));
+  int brack_lineno = tbuff.lookahead(0).get_lineno();
+  tbuff.get_next();  // pop '['
 
-  int open_brack_idx = get_str_idx_expr_tq("[");
-  ExprTQ original = expr_tq;
-  expr_tq.tq.clear();
-  for (int i = 0; i < (int)open_brack_idx; i++) {
-    expr_tq.tq.push_back(original.tq[i]);
-  }
-  list_name = parse_exprstmt();
-
-  assert(expr_tq.tq.empty());
-
-  // also need to check for ":" in case it's SublistExpr
-  int stk = -1;  // starts at -1 because the first char is '['
-  bool is_sublist_expr = false;
-  int colon_idx = -1;
-  for (int i = open_brack_idx; i < (int)original.tq.size(); i++) {
-    if (original.tq[i].get_str() == "(" || original.tq[i].get_str() == "[") {
-      stk++;
-    } else if (original.tq[i].get_str() == ")" ||
-               original.tq[i].get_str() == "]") {
-      stk--;
-    }
-    if (stk == 0 && original.tq[i].get_str() == ":") {
-      colon_idx = i - open_brack_idx - 1;
-      is_sublist_expr = true;
-    }
-
-    expr_tq.tq.push_back(original.tq[i]);
-  }
+  ExprStmt *index = parse_binopexpr(LOOSEST_PREC);
+  if (expr_error) return NULL;
 
-  assert(expr_tq.tq[0].get_str() == "[" &&
-         expr_tq.tq[expr_tq.tq.size() - 1].get_str() == "]");
+  if (tbuff.lookahead(0).is(sym::Colon)) {
+    tbuff.get_next();  // pop ':'
+    ExprStmt *end_idx = parse_binopexpr(LOOSEST_PREC);
+    expect_close(sym::CloseBrack, brack_lineno);
 
-  expr_tq.tq.pop_front();
-  expr_tq.tq.pop_back();
-
-  if (is_sublist_expr) {
-    SublistExpr *sl = parse_sublist_expr(colon_idx, list_name);
+    SublistExpr *sl = arena.make<SublistExpr>(list_name, index, end_idx);
     sl->lineno = lineno;
     return sl;
   }
 
-  index = parse_exprstmt();
+  expect_close(sym::CloseBrack, brack_lineno);
 
-  ListElemRef *list_elem_ref = new ListElemRef(list_name, index);
+  ListElemRef *list_elem_ref = arena.make<ListElemRef>(list_name, index);
   list_elem_ref->lineno = lineno;
   return list_elem_ref;
 }
 
-int Parser::get_str_idx_expr_tq(string s) {
-  int idx = -1;
-
-  stack<string> stk;
-  for (int i = (int)expr_tq.tq.size() - 1; i >= 0; i--) {
-    Token t = expr_tq.tq[i];
-    if (t.get_str() == "]" || t.get_str() == ")") {
-      stk.push(t.get_str());
-    } else if (t.get_str() == "(" || t.get_str() == "[") {
-      stk.pop();
-    }
-
-    if (stk.empty() && t.get_str() == s) {
-      idx = i;
-      break;
-    }
-  }
-
-  assert(stk.empty());
-
-  return idx;
-}
-
-DispatchExpr *Parser::parse_dispexpr() {
+/* `name(args)`, called on CALLING_CLASS (NULL for a global call). For a
+   method call the '.' has already been consumed */
+DispatchExpr *Parser::parse_dispexpr(ExprStmt *calling_class, int lineno) {
   debug_msg("BEGIN parse_dispexpr()");
-  int lineno = expr_tq.tq.front().get_lineno();
-  ExprStmt *calling_class;
-  string name;
-  ExprList args;
-
-  int dot_index = get_str_idx_expr_tq(".");
-  ExprTQ original = expr_tq;
-  expr_tq.tq.clear();
-  for (int i = 0; i < dot_index; i++) {
-    expr_tq.tq.push_back(original.tq[i]);
-  }
-  /* parse on tokens from 0 to dot_index */
-  calling_class = parse_exprstmt();
-  assert(expr_tq.tq.empty());
-
-  for (int i = dot_index + 1; i < original.tq.size(); i++) {
-    expr_tq.tq.push_back(original.tq[i]);
+  const Token &name_tok = tbuff.lookahead(0);
+  if ((name_tok.get_type() != OBJECTID && name_tok.get_type() != TYPEID) ||
+      !tbuff.lookahead(1).is(sym::OpenP)) {
+    /* fields are not accessible from outside the class */
+    expr_fail(lineno, "Unrecognized expression", true);
+    return NULL;
   }
+  string name = name_tok.get_str();
+  tbuff.get_next();  // pop name
+  tbuff.get_next();  // pop '('
 
-  name = expr_tq.tq[0].get_str();
-  expr_tq.tq.pop_front();
-
-  assert(expr_tq.tq.front().get_str() == "(");
-  assert(expr_tq.tq.back().get_str() == ")");
-
-  expr_tq.tq.pop_front();
-  expr_tq.tq.pop_back();
+  ExprList args = parse_comma_separated_exprlist(sym::CloseP);
 
-  if (!expr_tq.tq.empty()) args = parse_comma_separated_exprlist();
-
-  DispatchExpr *disp_expr = new DispatchExpr(calling_class, name, args);
+  DispatchExpr *disp_expr = arena.make<DispatchExpr>(calling_class, name, args);
   disp_expr->lineno = lineno;
   return disp_expr;
 }
 
+/* `return` takes everything up to the end of the expression */
 ReturnExpr *Parser::parse_returnexpr() {
   debug_msg("BEGIN parse_returnexpr()");
-  int lineno = expr_tq.tq[0].get_lineno();
-  ExprStmt *expr;
+  int lineno = tbuff.lookahead(0).get_lineno();
 
-  assert(expr_tq.tq.front().get_type() == RETURN);
+  assert(tbuff.lookahead(0).get_type() == RETURN);
+  tbuff.get_next();  // pop 'return'
 
-  expr_tq.tq.pop_front();
-  calibrate_expr_tq();
-  expr = parse_exprstmt();
+  ExprStmt *expr = parse_binopexpr(LOOSEST_PREC);
 
-  ReturnExpr *retexpr = new ReturnExpr(expr);
+  ReturnExpr *retexpr = arena.make<ReturnExpr>(expr);
   retexpr->lineno = lineno;
   debug_msg("END parse_returnexpr()");
   return retexpr;
@@ -1009,66 +918,30 @@ ReturnExpr *Parser::parse_returnexpr() {
 
 NewExpr *Parser::parse_newexpr() {
   debug_msg("BEGIN parse_newexpr()");
-  int lineno = expr_tq.tq[0].get_lineno();
-  ExprStmt *expr;
+  int lineno = tbuff.lookahead(0).get_lineno();
 
-  assert(expr_tq.tq.front().get_type() == NEW);
+  assert(tbuff.lookahead(0).get_type() == NEW);
+  tbuff.get_next();  // pop 'new'
 
-  expr_tq.tq.pop_front();
-  if (expr_tq.tq.empty() || expr_tq.tq.front().get_type() != TYPEID) {
-    string err_msg = "There must be a class constructor following keyword NEW.";
-    parser_error(lineno, err_msg);
-    panic_recover({";"});
+  if (tbuff.lookahead(0).get_type() != TYPEID) {
+    expr_fail(lineno,
+              "There must be a class constructor following keyword NEW.",
+              false);
     return NULL;
   }
 
-  NewExpr *newexpr = new NewExpr(expr_tq.tq.front().get_str());
-  expr_tq.tq.pop_front();
+  NewExpr *newexpr = arena.make<NewExpr>(tbuff.get_next().get_str());
   newexpr->lineno = lineno;
   debug_msg("END parse_newexpr()");
   return newexpr;
 }
 
-BinopExpr *Parser::parse_binopexpr() {
-  debug_msg("BEGIN parse_binopexpr()");
-  int lineno = expr_tq.tq[expr_tq.binop_index].get_lineno();
-  ExprStmt *lhs;
-  string op;
-  ExprStmt *rhs;
-
-  Token op_tok = expr_tq.tq[expr_tq.binop_index];
-  assert(op_tok.get_type() == BINOP);
-  op = op_tok.get_str();
-
-  ExprTQ original = expr_tq;
-
-  /* create lhs expr_tq */
-  expr_tq.tq.clear();
-  for (int i = 0; i < original.binop_index; i++) {
-    expr_tq.tq.push_back(original.tq[i]);
-  }
-  lhs = parse_exprstmt();
-
-  /* create rhs expr_tq */
-  expr_tq.tq.clear();
-  for (int i = original.binop_index + 1; i < original.tq.size(); i++) {
-    expr_tq.tq.push_back(original.tq[i]);
-  }
-  rhs = parse_exprstmt();
-
-  BinopExpr *binop = new BinopExpr(lhs, op, rhs);
-  binop->lineno = lineno;
-  debug_msg("END parse_binopexpr()");
-  return binop;
-}
-
 IntConstExpr *Parser::parse_int_const_expr() {
   debug_msg("BEGIN: parse_int_const_expr()");
-  Token t = expr_tq.tq.front();
-  expr_tq.tq.pop_front();
+  Token t = tbuff.get_next();
   int lineno = t.get_lineno();
   long val = stol(t.get_str());
-  IntConstExpr *icstmt = new IntConstExpr(val);
+  IntConstExpr *icstmt = arena.make<IntConstExpr>(val);
   icstmt->lineno = lineno;
   debug_msg("END: parse_int_const_expr()");
   return icstmt;
@@ -1076,50 +949,45 @@ IntConstExpr *Parser::parse_int_const_expr() {
 
 DeciConstExpr *Parser::parse_deci_const_expr() {
   debug_msg("BEGIN: parse_deci_const_expr()");
-  Token t = expr_tq.tq.front();
-  expr_tq.tq.pop_front();
+  Token t = tbuff.get_next();
   int lineno = t.get_lineno();
   double val = stod(t.get_str());
-  DeciConstExpr *dex = new DeciConstExpr(val);
+  DeciConstExpr *dex = arena.make<DeciConstExpr>(val);
   dex->lineno = lineno;
   debug_msg("END: parse_deci_const_expr()");
   return dex;
 }
 
 BoolConstExpr *Parser::parse_bool_const_expr() {
-  Token t = expr_tq.tq.front();
-  expr_tq.tq.pop_front();
+  Token t = tbuff.get_next();
   int lineno = t.get_lineno();
   string val = t.get_str();
-  BoolConstExpr *bcstmt = new BoolConstExpr(val);
+  BoolConstExpr *bcstmt = arena.make<BoolConstExpr>(val);
   bcstmt->lineno = lineno;
   return bcstmt;
 }
 StrConstExpr *Parser::parse_str_const_expr() {
-  Token t = expr_tq.tq.front();
-  expr_tq.tq.pop_front();
+  Token t = tbuff.get_next();
   int lineno = t.get_lineno();
   string val = t.get_str();
-  StrConstExpr *strstmt = new StrConstExpr(val);
+  StrConstExpr *strstmt = arena.make<StrConstExpr>(val);
   strstmt->lineno = lineno;
   return strstmt;
 }
 
 CharConstExpr *Parser::parse_char_const_expr() {
-  Token t = expr_tq.tq.front();
-  expr_tq.tq.pop_front();
+  Token t = tbuff.get_next();
   int lineno = t.get_lineno();
   string c = t.get_str();
-  CharConstExpr *charexpr = new CharConstExpr(c);
+  CharConstExpr *charexpr = arena.make<CharConstExpr>(c);
   charexpr->lineno = lineno;
   return charexpr;
 }
 
 ObjectIdExpr *Parser::parse_objectid_expr() {
   debug_msg("BEGIN parse_objectid_expr()");
-  Token t = expr_tq.tq.front();
-  expr_tq.tq.pop_front();
-  ObjectIdExpr *objidexpr = new ObjectIdExpr(t.get_str());
+  Token t = tbuff.get_next();
+  ObjectIdExpr *objidexpr = arena.make<ObjectIdExpr>(t.get_str());
   objidexpr->lineno = t.get_lineno();
   debug_msg("END parse_objectid_expr()");
   return objidexpr;
@@ -1140,20 +1008,16 @@ Stmt *Parser::parse_stmt() {
   } else if (t.get_type() == WHILE) {
     stmt = parse_while_stmt();
   } else if (t.get_type() == BREAK) {
-    stmt = new BreakStmt();
+    stmt = arena.make<BreakStmt>();
     tbuff.get_next();  // pop 'break';
-    parse_check_and_pop(";");
+    parse_check_and_pop(sym::SemiColon);
   } else if (t.get_type() == CONTINUE) {
-    stmt = new ContStmt();
+    stmt = arena.make<ContStmt>();
     tbuff.get_next();  // pop 'continue'
-    parse_check_and_pop(";");
+    parse_check_and_pop(sym::SemiColon);
   } else {
-    if (!build_expr_tq(";"))
-      stmt = NULL;
-    else {
-      stmt = parse_exprstmt();
-    }
-    if (parse_check_and_pop(";") == -1) {
+    stmt = parse_exprstmt(sym::SemiColon);
+    if (parse_check_and_pop(sym::SemiColon) == -1) {
       return NULL;
     }
   }
@@ -1170,30 +1034,26 @@ Program Parser::parse_program() {
   return program;
 }
 
+/* Reports lexer errors in source order. Tokens are lexed as the parser pulls
+   them, so this is only complete after parse_program() has drained the
+   stream. */
 bool Parser::check_lexer_errors() {
   if (tbuff.has_errors) {
-    token_dump();
+    for (const Token &t : tbuff.get_lexer_errors()) {
+      cout << t.get_str() << endl;
+    }
     return false;
   }
   return true;
 }
 
 void Parser::token_dump() {
-  if (tbuff.has_errors) {
-    while (tbuff.has_next()) {
-      Token t = tbuff.get_next();
-      if (t.get_type() == ERROR) {
-        lexer_error(t.get_lineno(), t.get_str());
-      }
-    }
-  } else {
-    while (tbuff.has_next()) {
-      Token t = tbuff.get_next();
-      t.dump();
-    }
+  while (tbuff.has_next()) {
+    Token t = tbuff.get_next();
+    t.dump();
   }
 }
 
-void Parser::debug_msg(string s) {
+void Parser::debug_msg(const char *s) {
   if (debug) cout << s << endl;
 }
@@ -5,38 +5,106 @@
 
 using namespace std;
 
-/* Given id S, returns a ptr to the Type_ of the first occurrence of S. */
-Type_* ScopeTable::lookup(string s) {
-  assert(table.size());
-  for (int i = (int)table.size() - 1; i >= 0; i--) {
-    map<string, Type_*>& scope = table[i];
-    if (scope.find(s) != scope.end()) {
-      return scope[s];
+#define EMPTY_BUCKET ((Symbol)-1)
+#define INITIAL_BUCKETS 64 /* must be a power of two */
+
+ScopeTable::ScopeTable() : buckets(INITIAL_BUCKETS, {EMPTY_BUCKET, -1}) {}
+
+/* the bucket of S, claiming an empty one if S has never been seen */
+size_t ScopeTable::find_bucket(Symbol s) {
+  size_t mask = buckets.size() - 1;
+  uint32_t h = s * 0x9E3779B1u;
+  size_t i = (h ^ (h >> 16)) & mask;
+  for (; buckets[i].sym != EMPTY_BUCKET; i = (i + 1) & mask) {
+    if (buckets[i].sym == s) return i;
+  }
+
+  /* keep the load factor under 1/2 */
+  if ((num_syms + 1) * 2 > buckets.size()) {
+    rehash();
+    return find_bucket(s);
+  }
+  buckets[i] = {s, -1};
+  num_syms++;
+  return i;
+}
+
+void ScopeTable::rehash() {
+  vector<Bucket> old(buckets.size() * 2, {EMPTY_BUCKET, -1});
+  old.swap(buckets);
+
+  size_t mask = buckets.size() - 1;
+  for (const Bucket &b : old) {
+    if (b.sym == EMPTY_BUCKET) continue;
+    uint32_t h = b.sym * 0x9E3779B1u;
+    size_t i = (h ^ (h >> 16)) & mask;
+    while (buckets[i].sym != EMPTY_BUCKET) i = (i + 1) & mask;
+    buckets[i] = b;
+    /* the bindings of this symbol now hang off bucket i */
+    for (int j = b.head; j >= 0; j = bindings[j].prev) {
+      bindings[j].bucket = (int)i;
     }
   }
-  return NULL;
+}
+
+/* Given id S, returns a ptr to the Type_ of the first occurrence of S. */
+Type_* ScopeTable::lookup(Symbol s) {
+  assert(scope_marks.size());
+  int head = buckets[find_bucket(s)].head;
+  return head >= 0 ? bindings[head].type : NULL;
+}
+
+Type_* ScopeTable::lookup(const string& s) {
+  return lookup(SymbolTable::global().intern(s));
 }
 
 /* Given id s, returns a ptr to S's Type_ if S is defined in the current scope
  */
-Type_* ScopeTable::check_current_scope(string s) {
-  assert(table.size());
-  map<string, Type_*>& scope = table[table.size() - 1];
-  if (scope.find(s) != scope.end()) return scope[s];
+Type_* ScopeTable::check_current_scope(Symbol s) {
+  assert(scope_marks.size());
+  int head = buckets[find_bucket(s)].head;
+  if (head >= 0 && bindings[head].depth == (int)scope_marks.size()) {
+    return bindings[head].type;
+  }
   return NULL;
 }
 
-void ScopeTable::add_elem(string key, Type_* value) {
-  assert(table.size());
-  table[table.size() - 1][key] = value;
+Type_* ScopeTable::check_current_scope(const string& s) {
+  return check_current_scope(SymbolTable::global().intern(s));
+}
+
+void ScopeTable::add_elem(Symbol s, Type_* type) {
+  assert(scope_marks.size());
+  int depth = (int)scope_marks.size();
+  num_changes++;
+  size_t b = find_bucket(s);
+  int head = buckets[b].head;
+  if (head >= 0 && bindings[head].depth == depth) {
+    /* redefined in the same scope: the newest type wins */
+    bindings[head].type = type;
+    return;
+  }
+  bindings.push_back({type, depth, head, (int)b});
+  buckets[b].head = (int)bindings.size() - 1;
+}
+
+void ScopeTable::add_elem(const string& s, Type_* type) {
+  add_elem(SymbolTable::global().intern(s), type);
 }
 
 void ScopeTable::push_scope() {
-  map<string, Type_*> m;
-  table.push_back(m);
+  scope_marks.push_back(bindings.size());
+  num_changes++;
 }
 
 void ScopeTable::pop_scope() {
-  assert(table.size());
-  table.pop_back();
+  assert(scope_marks.size());
+  size_t mark = scope_marks.back();
+  scope_marks.pop_back();
+  num_changes++;
+  while (bindings.size() > mark) {
+    const Binding &top = bindings.back();
+    buckets[top.bucket].head = top.prev;
+    bindings.pop_back();
+  }
 }
@@ -0,0 +1,76 @@
+#include "sourcebuffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+#define READ_CHUNK 65536
+
+SourceBuffer::SourceBuffer(const string filepath) {
+  bool is_stdin = filepath == "-";
+  int fd = is_stdin ? STDIN_FILENO : open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    cerr << "Error: Unable to open file " << filepath << endl;
+    throw runtime_error("unable to open " + filepath);
+  }
+
+  struct stat st;
+  bool ok;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    /* a regular file can still refuse mmap (some network filesystems) */
+    ok = map_file(fd, (size_t)st.st_size) || read_all(fd);
+  } else {
+    ok = read_all(fd);
+  }
+
+  if (!is_stdin) close(fd);
+
+  if (!ok) {
+    cerr << "Error: Unable to read file " << filepath << endl;
+    throw runtime_error("unable to read " + filepath);
+  }
+  curr = begin;
+}
+
+SourceBuffer::~SourceBuffer() {
+  if (mapping) munmap(mapping, mapping_len);
+}
+
+bool SourceBuffer::map_file(int fd, size_t len) {
+  void *p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED) return false;
+  /* the lexer makes exactly one front-to-back pass */
+  madvise(p, len, MADV_SEQUENTIAL);
+
+  mapping = p;
+  mapping_len = len;
+  begin = static_cast<const char *>(p);
+  end = begin + len;
+  return true;
+}
+
+bool SourceBuffer::read_all(int fd) {
+  owned.clear();
+  size_t used = 0;
+  while (true) {
+    owned.resize(used + READ_CHUNK);
+    ssize_t n = read(fd, owned.data() + used, READ_CHUNK);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (n == 0) break;
+    used += n;
+  }
+  owned.resize(used);
+  begin = owned.data();
+  end = begin + used;
+  return true;
+}
@@ -0,0 +1,97 @@
+#include "symboltable.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "constants.h"
+
+using namespace std;
+using namespace lexing;
+
+#define INITIAL_SLOTS 4096 /* must be a power of two */
+
+/* multiplicative hash over 8-byte words; identifiers are short */
+static uint32_t hash_bytes(string_view s) {
+  const uint64_t K = 0x9E3779B97F4A7C15ull;
+  uint64_t h = s.size() * K;
+  const char *p = s.data();
+  size_t n = s.size();
+  for (; n >= 8; p += 8, n -= 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    h = (h ^ w) * K;
+    h ^= h >> 29;
+  }
+  if (n) {
+    uint64_t w = 0;
+    memcpy(&w, p, n);
+    h = (h ^ w) * K;
+    h ^= h >> 29;
+  }
+  return (uint32_t)(h ^ (h >> 32));
+}
+
+SymbolTable::SymbolTable() : slots(INITIAL_SLOTS), hashes(INITIAL_SLOTS) {
+  const string predefined[] = {
+      "",          OpenP,       CloseP,      SemiColon, OpenBrack,
+      CloseBrack,  OpenBrace,   CloseBrace,  Period,    Comma,
+      Colon,       Plus,        Minus,       Times,     Divide,
+      LessThan,    GreaterThan, LEQ,         GEQ,       Equal,
+      NotEqual,    And,         Or,          PlusEquals, MinusEquals,
+      TimesEquals, DivideEquals, Define};
+  static_assert(sizeof(predefined) / sizeof(predefined[0]) ==
+                    sym::NUM_PREDEFINED,
+                "sym:: enum and predefined strings are out of sync");
+
+  for (const string &s : predefined) {
+    Symbol id = intern(s);
+    assert(id == num_strs - 1);
+    (void)id;
+  }
+}
+
+SymbolTable &SymbolTable::global() {
+  static SymbolTable table;
+  return table;
+}
+
+Symbol SymbolTable::intern(string_view s) {
+  uint32_t h = hash_bytes(s);
+  lock_guard<mutex> guard(lock);
+  size_t mask = slots.size() - 1;
+  size_t i = h & mask;
+  for (; slots[i]; i = (i + 1) & mask) {
+    if (hashes[i] == h && str(slots[i] - 1) == s) return slots[i] - 1;
+  }
+
+  Symbol id = (Symbol)num_strs;
+  size_t chunk = id >> SYMBOL_CHUNK_BITS;
+  if (chunk >= SYMBOL_MAX_CHUNKS) {
+    throw length_error("too many distinct identifiers and literals");
+  }
+  if (!chunks[chunk]) chunks[chunk].reset(new string[SYMBOL_CHUNK_SIZE]);
+  chunks[chunk][id & (SYMBOL_CHUNK_SIZE - 1)] = s;
+  num_strs++;
+  slots[i] = id + 1;
+  hashes[i] = h;
+  /* keep the load factor under 1/2 */
+  if (num_strs * 2 > slots.size()) rehash();
+  return id;
+}
+
+void SymbolTable::rehash() {
+  vector<Symbol> old_slots(slots.size() * 2);
+  vector<uint32_t> old_hashes(hashes.size() * 2);
+  old_slots.swap(slots);
+  old_hashes.swap(hashes);
+
+  size_t mask = slots.size() - 1;
+  for (size_t j = 0; j < old_slots.size(); j++) {
+    if (!old_slots[j]) continue;
+    size_t i = old_hashes[j] & mask;
+    while (slots[i]) i = (i + 1) & mask;
+    slots[i] = old_slots[j];
+    hashes[i] = old_hashes[j];
+  }
+}
@@ -25,7 +25,7 @@ void ClassStmt::dump(int n) {
   if (parents.size() > 0) {
     indent(n + 2);
     cout << "inherits: ";
-    for (string viber : parents) {
+    for (const string &viber : parents) {
       cout << viber + " ";
     }
     cout << endl;
@@ -75,7 +75,7 @@ void BreakStmt::dump(int n) {
   cout << name << endl;
 }
 
-void ExprStmt::dump(int n) {}
+void ExprStmt::dump(int) {}
 void IntConstExpr::dump(int n) {
   indent(n);
   cout << to_string(val) + " ";
@@ -94,6 +94,37 @@ void StrConstExpr::dump(int n) {
   indent(n);
   cout << str << endl;
 }
+
+string StrConstExpr::get_value() {
+  string s;
+  size_t end = str.size() > 0 ? str.size() - 1 : 0;
+  for (size_t i = 1; i < end; i++) {
+    if (str[i] != '\\' || i + 1 == end) {
+      s += str[i];
+      continue;
+    }
+    switch (str[++i]) {
+      case 'n':
+        s += '\n';
+        break;
+      case 't':
+        s += '\t';
+        break;
+      case '0':
+        s += '\0';
+        break;
+      case '\\':
+        s += '\\';
+        break;
+      default:
+        s += '\\';
+        s += str[i];
+        break;
+    }
+  }
+  return s;
+}
+
 void CharConstExpr::dump(int n) {
   indent(n);
   cout << c << endl;
@@ -185,21 +216,29 @@ void DispatchExpr::dump(int n) {
 }
 
 void Type_::dump(int n) {
-  cout << name;
+  cout << get_name();
   if (nested_type) {
     cout << "<";
     nested_type->dump(n + 1);
+    if (value_type) {
+      cout << ", ";
+      value_type->dump(n + 1);
+    }
     cout << ">";
   }
 }
 string Type_::to_str() {
-  string ret_str = name;
+  string ret_str = get_name();
 
-  if (nested_type) ret_str += "<" + nested_type->to_str() + ">";
+  if (value_type) {
+    ret_str += "<" + nested_type->to_str() + ", " + value_type->to_str() + ">";
+  } else if (nested_type) {
+    ret_str += "<" + nested_type->to_str() + ">";
+  }
   return ret_str;
 }
 
-void FormalStmt::dump(int n) {
+void FormalStmt::dump(int) {
   // indent(n);
   cout << type->to_str() + " " + name + ", ";
 }
@@ -4,50 +4,81 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <unordered_map>
 
 #include "constants.h"
 #include "error.h"
 #include "inheritance-graph.h"
-#include "scopetable.h"
+#include "threadpool.h"
 
 using namespace std;
 using namespace basic_classes;
 using namespace typechecking;
 
-static string curr_filename;  /* current filename */
-static int semant_errors = 0; /* semant errors */
-static int warnings = 0;      /* warnings */
-static ScopeTable scopetable; /* scope table */
-
-static vector<string> class_names;                /* vector of class names */
-static map<string, Type_ *> class_type;           /* class to Type_* */
-static map<string, ClassStmt *> classes;          /* class to ClassStmt* */
-static map<string, vector<string>> class_parents; /* class to parents */
-static map<string, set<string>> class_ancestors;  /* class to all ancestors */
-static map<string, set<MethodStmt *>> class_methods; /* class to methods */
-static map<string, set<AttrStmt *>> class_attrs;     /* class to attrs */
-/* intermediate map from class name to parent meths */
-static map<string, set<MethodStmt *>> parent_methods;
-/* intermediate map from class name to its parent attrs */
-static map<string, set<AttrStmt *>> parent_attrs;
-static set<MethodStmt *> global_methods; /* set of global methods */
-
-static bool conforms(Type_ *a, Type_ *b);
-static void populate_parent_feature_tables(string &child,
+static bool conforms(SemaContext &ctx, Type_ *a, Type_ *b);
+static bool conforms_util(SemaContext &ctx, Symbol a, Symbol b);
+static void populate_parent_feature_tables(SemaContext &ctx,
+                                           const string &child,
                                            map<string, bool> &visited);
 static bool check_valid_type_(Type_ *t);
-bool check_method_sigs(MethodStmt *p, MethodStmt *c, const string &cname);
+bool check_method_sigs(SemaContext &ctx, MethodStmt *p, MethodStmt *c,
+                       const string &cname);
 
-static void error(int lineno, const std::string &err_msg) {
-  Error e(SEMANTIC_ERROR, curr_filename, lineno, err_msg);
-  e.print();
-  semant_errors++;
+static void report(SemaContext &ctx, Error &e) {
+  if (!ctx.diag_buf) {
+    e.print();
+    return;
+  }
+  llvm::raw_string_ostream os(*ctx.diag_buf);
+  os.enable_colors(llvm::errs().colors_enabled());
+  e.print(os);
+}
+
+static void error(SemaContext &ctx, int lineno, const std::string &err_msg) {
+  Error e(SEMANTIC_ERROR, ctx.filename, lineno, err_msg);
+  report(ctx, e);
+  ctx.semant_errors++;
+}
+
+static void warning(SemaContext &ctx, int lineno, const std::string &warn_msg) {
+  Warning w(SEMANTIC_ERROR, ctx.filename, lineno, warn_msg);
+  report(ctx, w);
+  ctx.warnings++;
+}
+
+/* typechecks E and records its type on it for codegen */
+static Type_ *check(SemaContext &ctx, ExprStmt *e) {
+  Type_ *t = e->typecheck(ctx);
+  e->set_type(t);
+  return t;
 }
 
-static void warning(int lineno, const std::string &warn_msg) {
-  Warning w(SEMANTIC_ERROR, curr_filename, lineno, warn_msg);
-  w.print();
-  warnings++;
+/* the Type_ of class NAME, NULL if there is no such class. Unlike
+   class_type[], never inserts, so worker threads can share the map */
+static Type_ *class_type_of(SemaContext &ctx, const string &name) {
+  auto it = ctx.tables->class_type.find(name);
+  return it == ctx.tables->class_type.end() ? NULL : it->second;
+}
+
+/* a builtin method: no body, and at most two formals */
+MethodStmt *TypeChecker::builtin_method(Type_ *ret_type, const string &name,
+                                        Type_ *formal_type,
+                                        const string &formal_name,
+                                        Type_ *formal_type2,
+                                        const string &formal_name2) {
+  FormalList formal_list;
+  if (formal_type) {
+    FormalStmt *f = ctx.arena->make<FormalStmt>(formal_type, formal_name);
+    formal_list.push_back(f);
+  }
+  if (formal_type2) {
+    FormalStmt *f = ctx.arena->make<FormalStmt>(formal_type2, formal_name2);
+    formal_list.push_back(f);
+  }
+  MethodStmt *m = ctx.arena->make<MethodStmt>(ret_type, name,
+                                              move(formal_list), StmtList());
+  m->set_builtin();
+  return m;
 }
 
 //////////////////////////////////////////////////////////////
@@ -57,65 +88,72 @@ static void warning(int lineno, const std::string &warn_msg) {
 //////////////////////////////////////////////////////////////
 
 void TypeChecker::initialize_basic_classes() {
+  map<string, Type_ *> &class_type = ctx.tables->class_type;
   /*
   void ->
     parent: None
     no member attrs/methods
   */
-  class_type[Void] = new Type_(Void, NULL);
-  class_parents[Void] = {};
-  class_names.push_back(Void);
-  classes[Void] = new ClassStmt(Void, {}, {});
+  class_type[Void] = ctx.types->get(Void, nullptr);
+  ctx.tables->class_parents[Void] = {};
+  ctx.tables->class_names.push_back(Void);
+  ctx.tables->classes[Void] =
+      ctx.arena->make<ClassStmt>(Void, vector<string>(), FeatureList());
 
   /*
   object ->
     parent: None
     no member attrs/methods
   */
-  class_type[Object] = new Type_(Object, NULL);
-  class_parents[Object] = {};
-  class_names.push_back(Object);
-  classes[Object] = new ClassStmt(Object, {}, {});
+  class_type[Object] = ctx.types->get(Object, nullptr);
+  ctx.tables->class_parents[Object] = {};
+  ctx.tables->class_names.push_back(Object);
+  ctx.tables->classes[Object] =
+      ctx.arena->make<ClassStmt>(Object, vector<string>(), FeatureList());
 
   /*
   int ->
     parent: object
     no member attrs/methods
   */
-  class_type[Int] = new Type_(Int, NULL);
-  class_parents[Int].push_back(Object);
-  class_names.push_back(Int);
-  classes[Int] = new ClassStmt(Int, {Object}, {});
+  class_type[Int] = ctx.types->get(Int, nullptr);
+  ctx.tables->class_parents[Int].push_back(Object);
+  ctx.tables->class_names.push_back(Int);
+  ctx.tables->classes[Int] =
+      ctx.arena->make<ClassStmt>(Int, vector<string>{Object}, FeatureList());
 
   /*
   deci ->
     parent: object
     no member attr/methods
   */
-  class_type[Deci] = new Type_(Deci, NULL);
-  class_parents[Deci].push_back(Object);
-  class_names.push_back(Deci);
-  classes[Deci] = new ClassStmt(Deci, {Object}, {});
+  class_type[Deci] = ctx.types->get(Deci, nullptr);
+  ctx.tables->class_parents[Deci].push_back(Object);
+  ctx.tables->class_names.push_back(Deci);
+  ctx.tables->classes[Deci] =
+      ctx.arena->make<ClassStmt>(Deci, vector<string>{Object}, FeatureList());
 
   /*
   bool ->
     parent: object
     no member attrs/methods
   */
-  class_type[Bool] = new Type_(Bool, NULL);
-  class_parents[Bool].push_back(Object);
-  class_names.push_back(Bool);
-  classes[Bool] = new ClassStmt(Bool, {Object}, {});
+  class_type[Bool] = ctx.types->get(Bool, nullptr);
+  ctx.tables->class_parents[Bool].push_back(Object);
+  ctx.tables->class_names.push_back(Bool);
+  ctx.tables->classes[Bool] =
+      ctx.arena->make<ClassStmt>(Bool, vector<string>{Object}, FeatureList());
 
   /*
   char ->
     parent: object
     no member attrs/methods
   */
-  class_type[Char] = new Type_(Char, NULL);
-  class_parents[Char].push_back(Object);
-  class_names.push_back(Char);
-  classes[Char] = new ClassStmt(Char, {Object}, {});
+  class_type[Char] = ctx.types->get(Char, nullptr);
+  ctx.tables->class_parents[Char].push_back(Object);
+  ctx.tables->class_names.push_back(Char);
+  ctx.tables->classes[Char] =
+      ctx.arena->make<ClassStmt>(Char, vector<string>{Object}, FeatureList());
 
   /*
   string ->
@@ -136,21 +174,23 @@ void TypeChecker::initialize_basic_classes() {
         * if n is not present --> n = 0
         * if m is not present --> m = string.length()
   */
-  class_type[String] = new Type_(String, NULL);
-  class_parents[String].push_back(Object);
+  class_type[String] = ctx.types->get(String, nullptr);
+  ctx.tables->class_parents[String].push_back(Object);
   set<MethodStmt *> string_methods = {
-      new MethodStmt(class_type[Int], Length, {}, {}),
-      new MethodStmt(class_type[Void], Clear, {}, {}),
-      new MethodStmt(class_type[Bool], Is_Empty, {}, {}),
-      new MethodStmt(class_type[Char], Front, {}, {}),
-      new MethodStmt(class_type[Char], Back, {}, {})};
-  class_methods[String] = string_methods;
-  class_names.push_back(String);
+      builtin_method(class_type[Int], Length),
+      builtin_method(class_type[Void], Clear),
+      builtin_method(class_type[Bool], Is_Empty),
+      builtin_method(class_type[Char], Front),
+      builtin_method(class_type[Char], Back)};
+  ctx.tables->class_methods[String] = string_methods;
+  ctx.tables->class_names.push_back(String);
   FeatureList string_features;
   for (MethodStmt *m : string_methods) {
     string_features.push_back(m);
   }
-  classes[String] = new ClassStmt(String, {Object}, string_features);
+  ctx.tables->classes[String] =
+      ctx.arena->make<ClassStmt>(String, vector<string>{Object},
+                                  string_features);
 
   /*
   list<object> ->
@@ -176,29 +216,27 @@ void TypeChecker::initialize_basic_classes() {
         * if n is not present --> n = 0
         * if m is not present --> m = list.length()
   */
-  class_type[List] = new Type_(List, class_type[Object]);
-  class_parents[List].push_back(Object);
+  class_type[List] = ctx.types->get(List, class_type[Object]);
+  ctx.tables->class_parents[List].push_back(Object);
   set<MethodStmt *> list_methods = {
-      new MethodStmt(class_type[Int], Length, {}, {}),
-      new MethodStmt(class_type[Void], Clear, {}, {}),
-      new MethodStmt(class_type[Bool], Is_Empty, {}, {}),
-      new MethodStmt(class_type[Void], Push_Back,
-                     {new FormalStmt(class_type[Object], Object)}, {}),
-      new MethodStmt(class_type[Void], Push_Front,
-                     {new FormalStmt(class_type[Object], Object)}, {}),
-      new MethodStmt(class_type[Void], Pop_Front, {}, {}),
-      new MethodStmt(class_type[Void], Pop_Back, {}, {}),
-      new MethodStmt(class_type[Object], Front, {}, {}),
-      new MethodStmt(class_type[Object], Back, {}, {}),
-      new MethodStmt(class_type[Int], Contains,
-                     {new FormalStmt(class_type[Object], Object)}, {})};
-  class_methods[List] = list_methods;
-  class_names.push_back(List);
+      builtin_method(class_type[Int], Length),
+      builtin_method(class_type[Void], Clear),
+      builtin_method(class_type[Bool], Is_Empty),
+      builtin_method(class_type[Void], Push_Back, class_type[Object], Object),
+      builtin_method(class_type[Void], Push_Front, class_type[Object], Object),
+      builtin_method(class_type[Void], Pop_Front),
+      builtin_method(class_type[Void], Pop_Back),
+      builtin_method(class_type[Object], Front),
+      builtin_method(class_type[Object], Back),
+      builtin_method(class_type[Int], Contains, class_type[Object], Object)};
+  ctx.tables->class_methods[List] = list_methods;
+  ctx.tables->class_names.push_back(List);
   FeatureList list_features;
   for (MethodStmt *m : list_methods) {
     list_features.push_back(m);
   }
-  classes[List] = new ClassStmt(List, {Object}, list_features);
+  ctx.tables->classes[List] =
+      ctx.arena->make<ClassStmt>(List, vector<string>{Object}, list_features);
 
   /*
   set<object> -->
@@ -213,44 +251,97 @@ void TypeChecker::initialize_basic_classes() {
   operators -- in the form `set1` op `set2`
     acceptable ops: +, -, ==, !=
   */
-  class_type[Set] = new Type_(Set, class_type[Object]);
-  class_parents[Set].push_back(Object);
+  class_type[Set] = ctx.types->get(Set, class_type[Object]);
+  ctx.tables->class_parents[Set].push_back(Object);
   set<MethodStmt *> set_methods = {
-      new MethodStmt(class_type[Int], Length, {}, {}),
-      new MethodStmt(class_type[Void], Clear, {}, {}),
-      new MethodStmt(class_type[Bool], Is_Empty, {}, {}),
-      new MethodStmt(class_type[Void], Insert,
-                     {new FormalStmt(class_type[Object], Object)}, {}),
-      new MethodStmt(class_type[Bool], Remove,
-                     {new FormalStmt(class_type[Object], Object)}, {}),
-      new MethodStmt(class_type[Bool], Contains,
-                     {new FormalStmt(class_type[Object], Object)}, {}),
+      builtin_method(class_type[Int], Length),
+      builtin_method(class_type[Void], Clear),
+      builtin_method(class_type[Bool], Is_Empty),
+      builtin_method(class_type[Void], Insert, class_type[Object], Object),
+      builtin_method(class_type[Bool], Remove, class_type[Object], Object),
+      builtin_method(class_type[Bool], Contains, class_type[Object], Object),
   };
-  class_methods[Set] = set_methods;
-  class_names.push_back(Set);
+  ctx.tables->class_methods[Set] = set_methods;
+  ctx.tables->class_names.push_back(Set);
   FeatureList set_features;
   for (MethodStmt *m : set_methods) {
     set_features.push_back(m);
   }
-  classes[Set] = new ClassStmt(Set, {Object}, set_features);
+  ctx.tables->classes[Set] =
+      ctx.arena->make<ClassStmt>(Set, vector<string>{Object}, set_features);
+
+  /*
+  dict<object, object> -->
+    parent: object
+    int length() -- returns num keys in dict
+    void clear() -- empties the dict
+    bool is_empty() -- returns true if dict is empty, false otherwise
+    object get(object key) -- returns the value at key (Runtime error if
+      key is not in dict)
+    void insert(object key, object value) -- maps key to value, replacing
+      any value key had
+    bool remove(object key) -- removes key if key in dict,
+      returns true if removed, else false
+    bool contains(object key) -- returns true if key in dict
+    list<object> keys() -- returns the keys, in no particular order
+    list<object> values() -- returns the values, in the order of keys()
+    binary operators -- in the form `dict1` op `dict2`
+      acceptable ops: ==, !=
+  */
+  class_type[Dict] =
+      ctx.types->get(Dict, class_type[Object], class_type[Object]);
+  ctx.tables->class_parents[Dict].push_back(Object);
+  Type_ *object_list = ctx.types->get(List, class_type[Object]);
+  set<MethodStmt *> dict_methods = {
+      builtin_method(class_type[Int], Length),
+      builtin_method(class_type[Void], Clear),
+      builtin_method(class_type[Bool], Is_Empty),
+      builtin_method(class_type[Object], Get, class_type[Object], Dict_Key),
+      builtin_method(class_type[Void], Insert, class_type[Object], Dict_Key,
+                     class_type[Object], Dict_Value),
+      builtin_method(class_type[Bool], Remove, class_type[Object], Dict_Key),
+      builtin_method(class_type[Bool], Contains, class_type[Object], Dict_Key),
+      builtin_method(object_list, Keys),
+      builtin_method(object_list, Values),
+  };
+  ctx.tables->class_methods[Dict] = dict_methods;
+  ctx.tables->class_names.push_back(Dict);
+  FeatureList dict_features;
+  for (MethodStmt *m : dict_methods) {
+    dict_features.push_back(m);
+  }
+  ctx.tables->classes[Dict] =
+      ctx.arena->make<ClassStmt>(Dict, vector<string>{Object}, dict_features);
 }
 
-/* Returns false if T is invalid. ex: list, char<string> are invalid */
+/* Returns false if T is invalid. ex: list, char<string>, set<int, int>
+   and dict<int> are invalid */
 bool check_valid_type_(Type_ *t) {
   if (!t) return false;
 
   Type_ *nested = t->get_nested_type();
+  Type_ *value = t->get_value_type();
   bool is_container = (t->get_name() == List || t->get_name() == Set);
 
   if (is_container) {
-    return nested && check_valid_type_(nested);
+    return nested && !value && check_valid_type_(nested);
+  }
+  if (t->get_name() == Dict) {
+    return nested && value && check_valid_type_(nested) &&
+           check_valid_type_(value);
   }
 
   return !nested;
 }
 
+void TypeChecker::add_global_method(MethodStmt *m) {
+  ctx.tables->global_method_table.define(
+      SymbolTable::global().intern(m->get_name()), m, -1);
+}
+
 /* defines KrutC builtin methods */
 void TypeChecker::initialize_builtin_methods() {
+  map<string, Type_ *> &class_type = ctx.tables->class_type;
   /*
   void print(string s); -- prints s to console
   string to_str(int i); -- returns string representation of i
@@ -266,28 +357,24 @@ void TypeChecker::initialize_builtin_methods() {
     file object?? how does that work?
 
   */
-  global_methods.insert(new MethodStmt(
-      class_type[Void], Print, {new FormalStmt(class_type[String], "s")}, {}));
-  global_methods.insert(
-      new MethodStmt(class_type[String], Input,
-                     {new FormalStmt(class_type[String], "prompt")}, {}));
-  global_methods.insert(new MethodStmt(class_type[String], To_String,
-                                       {new FormalStmt(class_type[Int], "i")},
-                                       {}));
-  global_methods.insert(
-      new MethodStmt(class_type[Object], Type_Of,
-                     {new FormalStmt(class_type[Object], "o")}, {}));
-  global_methods.insert(new MethodStmt(
-      class_type[Int], Abs, {new FormalStmt(class_type[Int], "x")}, {}));
-  global_methods.insert(new MethodStmt(
-      class_type[Int], Sum, {new FormalStmt(class_type[List], "l")}, {}));
-  global_methods.insert(new MethodStmt(
-      class_type[Int], Min, {new FormalStmt(class_type[List], "l")}, {}));
-  global_methods.insert(new MethodStmt(
-      class_type[Int], Max, {new FormalStmt(class_type[List], "l")}, {}));
-  global_methods.insert(
-      new MethodStmt(class_type[Void], Kill,
-                     {new FormalStmt(class_type[String], "err_msg")}, {}));
+  add_global_method(
+      builtin_method(class_type[Void], Print, class_type[String], "s"));
+  add_global_method(
+      builtin_method(class_type[String], Input, class_type[String], "prompt"));
+  add_global_method(
+      builtin_method(class_type[String], To_String, class_type[Int], "i"));
+  add_global_method(
+      builtin_method(class_type[Object], Type_Of, class_type[Object], "o"));
+  add_global_method(
+      builtin_method(class_type[Int], Abs, class_type[Int], "x"));
+  add_global_method(
+      builtin_method(class_type[Int], Sum, class_type[List], "l"));
+  add_global_method(
+      builtin_method(class_type[Int], Min, class_type[List], "l"));
+  add_global_method(
+      builtin_method(class_type[Int], Max, class_type[List], "l"));
+  add_global_method(
+      builtin_method(class_type[Void], Kill, class_type[String], "err_msg"));
 }
 
 /* Declared classes (of the form class ClassName {...}) can only be decalared in
@@ -298,34 +385,35 @@ void TypeChecker::initialize_declared_classes() {
 
     ClassStmt *cs = dynamic_cast<ClassStmt *>(s);
     if (!cs) continue;
-    string name = cs->get_name();
+    const string &name = cs->get_name();
     // if class defined twice
-    if (class_type.find(name) != class_type.end()) {
+    if (ctx.tables->class_type.find(name) != ctx.tables->class_type.end()) {
       string err_msg = "Class " + name + " cannot be defined twice.";
-      error(cs->lineno, err_msg);
+      error(ctx, cs->lineno, err_msg);
       continue;
     }
-    class_type[name] = new Type_(name, NULL);
-    class_names.push_back(name);
+    ctx.tables->class_type[name] = ctx.types->get(name, nullptr);
+    ctx.tables->class_names.push_back(name);
+    ctx.tables->classes[name] = cs;
 
-    FeatureList feature_list = cs->get_feature_list();
-    for (Feature *f : feature_list) {
+    for (Feature *f : cs->get_feature_list()) {
       if (f->is_method()) {
         MethodStmt *m = static_cast<MethodStmt *>(f);
         if (m->get_name() == Constructor) {
           string err_msg = "Redefined constructor in class " + name +
                            ", or method named `constructor`. A method "
                            "`constructor` is builtin for every class.";
-          error(m->lineno, err_msg);
+          error(ctx, m->lineno, err_msg);
         }
-        set<MethodStmt *> *existing_methods = &class_methods[cs->get_name()];
+        set<MethodStmt *> *existing_methods =
+            &ctx.tables->class_methods[cs->get_name()];
         for (MethodStmt *em : *existing_methods) {
           // check current method against existing methods
           if (em->get_name() == m->get_name()) {
             string err_msg = "Method " + m->get_name() +
                              " cannot be defined twice in class " +
                              cs->get_name();
-            error(m->lineno, err_msg);
+            error(ctx, m->lineno, err_msg);
             continue;
           }
         }
@@ -336,27 +424,27 @@ void TypeChecker::initialize_declared_classes() {
           string err_msg = "Method `" + m->get_name() +
                            "` has invalid return type `" +
                            m->get_ret_type()->to_str() + "`";
-          error(m->lineno, err_msg);
+          error(ctx, m->lineno, err_msg);
         }
 
-        FormalList formal_list = m->get_formal_list();
-        for (FormalStmt *f : formal_list) {
+        for (FormalStmt *f : m->get_formal_list()) {
           if (!check_valid_type_(f->get_type())) {
             string err_msg = "Formal `" + f->get_name() +
                              "` has invalid type `" + f->get_type()->to_str() +
                              "`";
-            error(f->lineno, err_msg);
+            error(ctx, f->lineno, err_msg);
           }
         }
       } else {
         AttrStmt *a = static_cast<AttrStmt *>(f);
-        set<AttrStmt *> *existing_attrs = &class_attrs[cs->get_name()];
+        set<AttrStmt *> *existing_attrs =
+            &ctx.tables->class_attrs[cs->get_name()];
         for (AttrStmt *ea : *existing_attrs) {
           if (ea->get_name() == a->get_name()) {
             string err_msg = "Attribute " + a->get_name() +
                              " cannot be defined twice in class " +
                              cs->get_name();
-            error(a->lineno, err_msg);
+            error(ctx, a->lineno, err_msg);
             continue;
           }
         }
@@ -364,7 +452,7 @@ void TypeChecker::initialize_declared_classes() {
           string err_msg = "Attribute `" + a->get_name() + "` in class `" +
                            name + "` has invalid type `" +
                            a->get_type()->to_str() + "`";
-          error(a->lineno, err_msg);
+          error(ctx, a->lineno, err_msg);
         }
         existing_attrs->insert(
             a);  // this should insert it in class_attrs bc ptr
@@ -381,44 +469,41 @@ void TypeChecker::check_valid_class_parents() {
     ClassStmt *cs = dynamic_cast<ClassStmt *>(s);
     if (!cs) continue;
 
-    string name = cs->get_name();
-    vector<string> parents = cs->get_parents();
-    for (string parent : parents) {
-      if (class_type.find(parent) == class_type.end()) {
+    const string &name = cs->get_name();
+    /* keep only good parents so we can typecheck as if they were all good */
+    vector<string> &parents = ctx.tables->class_parents[name];
+    parents.clear();
+    for (const string &parent : cs->get_parents()) {
+      if (ctx.tables->class_type.find(parent) == ctx.tables->class_type.end()) {
         // unknown parent
         string err_msg =
             "Class " + name + " inheriting from unknown class " + parent;
-        error(cs->lineno, err_msg);
-        /* erase bad parents so we can typecheck as if they have good parents */
-        parents.erase(remove(parents.begin(), parents.end(), parent),
-                      parents.end());
+        error(ctx, cs->lineno, err_msg);
         continue;
       }
       if (basic_classes::is_basic_class(parent)) {
         string err_msg =
             "Class " + name + " cannot inherit from base class " + parent;
-        error(cs->lineno, err_msg);
-        /* erase bad parents so we can typecheck as if they have good parents */
-        parents.erase(remove(parents.begin(), parents.end(), parent),
-                      parents.end());
+        error(ctx, cs->lineno, err_msg);
         continue;
       }
+      parents.push_back(parent);
     }
     if (parents.empty()) parents.push_back(Object);
-    class_parents[name] = parents;
   }
 }
 
 /* prints class_parents */
-void print_class_parents() {
-  for (pair<string, vector<string>> clp : class_parents) {
+void print_class_parents(SemaContext &ctx) {
+  for (const pair<const string, vector<string>> &clp :
+       ctx.tables->class_parents) {
     cout << clp.first << ": ";
     if (clp.second.empty()) {
       cout << "None" << endl;
       continue;
     }
     cout << clp.second[0];
-    for (int i = 1; i < clp.second.size(); i++) {
+    for (size_t i = 1; i < clp.second.size(); i++) {
       cout << ", " + clp.second[i];
     }
     cout << endl;
@@ -429,16 +514,16 @@ void print_class_parents() {
   Returns false if graph contains inheritance cycles, true otherwise.
 */
 bool TypeChecker::check_inheritance_cycles() {
-  InheritanceGraph *g = new InheritanceGraph(class_parents);
+  InheritanceGraph g(ctx.tables->class_parents);
   vector<vector<string>> cycles;
-  g->check_for_cycles(cycles);
+  g.check_for_cycles(cycles);
   if (!cycles.empty()) {
     for (vector<string> &cycle : cycles) {
       string err_msg = "Cycle detected in classes " + cycle[0];
       for (int i = 1; i < (int)cycle.size(); i++) {
         err_msg += ", " + cycle[i];
       }
-      error(0, err_msg);
+      error(ctx, 0, err_msg);
     }
     return false;
   }
@@ -447,36 +532,37 @@ bool TypeChecker::check_inheritance_cycles() {
 
 /* DFS to populate a set of meths/attrs that is the intersection of the child's
  * parent's meths/attrs */
-void populate_parent_feature_tables(string &child, map<string, bool> &visited) {
+void populate_parent_feature_tables(SemaContext &ctx, const string &child,
+                                    map<string, bool> &visited) {
   visited[child] = true;
 
-  for (string &parent : class_parents[child]) {
+  for (string &parent : ctx.tables->class_parents[child]) {
     if (!visited[parent]) {
-      populate_parent_feature_tables(parent, visited);
+      populate_parent_feature_tables(ctx, parent, visited);
     }
-    for (MethodStmt *nmeth : class_methods[parent]) {
+    for (MethodStmt *nmeth : ctx.tables->class_methods[parent]) {
       bool can_insert = true;
-      for (MethodStmt *emeth : parent_methods[child]) {
+      for (MethodStmt *emeth : ctx.tables->parent_methods[child]) {
         if (emeth->get_name() == nmeth->get_name()) {
           can_insert = false;
           break;
         }
       }
       if (can_insert) {
-        parent_methods[child].insert(nmeth);
+        ctx.tables->parent_methods[child].insert(nmeth);
       }
     }
 
-    for (AttrStmt *nattr : class_attrs[parent]) {
+    for (AttrStmt *nattr : ctx.tables->class_attrs[parent]) {
       bool can_insert = true;
-      for (AttrStmt *eattr : parent_attrs[child]) {
+      for (AttrStmt *eattr : ctx.tables->parent_attrs[child]) {
         if (eattr->get_name() == nattr->get_name()) {
           can_insert = false;
           break;
         }
       }
       if (can_insert) {
-        parent_attrs[child].insert(nattr);
+        ctx.tables->parent_attrs[child].insert(nattr);
       }
     }
   }
@@ -484,89 +570,189 @@ void populate_parent_feature_tables(string &child, map<string, bool> &visited) {
 
 /* Returns true if return type and formal list are consistent between inherited
  * methods, otherwise false */
-bool check_method_sigs(MethodStmt *p, MethodStmt *c, const string &cname) {
+bool check_method_sigs(SemaContext &ctx, MethodStmt *p, MethodStmt *c,
+                       const string & /* cname */) {
   bool ret_val = true;
-  if (!conforms(c->get_ret_type(), p->get_ret_type())) {
+  if (!conforms(ctx, c->get_ret_type(), p->get_ret_type())) {
     string err_msg =
         "Return type `" + c->get_ret_type()->to_str() +
         "`";  //  of method `" + c->get_name() + "` in class `" + cname + "`";
     err_msg += " does not conform to inherited return type `" +
                p->get_ret_type()->to_str() + "` defined on line " +
                to_string(p->lineno);
-    error(c->lineno, err_msg);
+    error(ctx, c->lineno, err_msg);
     ret_val = false;
   }
 
   return ret_val;
 }
 
-set<string> get_ancestors(string t) {
-  set<string> ancs;
-  deque<string> frontier;
-  frontier.push_front(t);
+/* -1 if NAME is not a class */
+static int get_class_id(SemaContext &ctx, Symbol name) {
+  auto it = ctx.tables->class_id.find(name);
+  return it == ctx.tables->class_id.end() ? -1 : it->second;
+}
+
+/* ORs the ancestor rows of C's parents into C's row, parents first */
+static void fill_ancestor_bits(SemaContext &ctx, int c, vector<bool> &done) {
+  ClassTables &t = *ctx.tables;
+  done[c] = true;
+  uint64_t *row = &t.ancestor_bits[c * t.ancestor_words];
+  row[c / 64] |= (uint64_t)1 << (c % 64);
+
+  for (const string &parent : t.class_parents[t.class_names[c]]) {
+    int p = get_class_id(ctx, SymbolTable::global().intern(parent));
+    if (p < 0) continue;
+    if (!done[p]) fill_ancestor_bits(ctx, p, done);
+    const uint64_t *prow = &t.ancestor_bits[p * t.ancestor_words];
+    for (size_t w = 0; w < t.ancestor_words; w++) {
+      row[w] |= prow[w];
+    }
+  }
+}
 
-  while (!frontier.empty()) {
-    string curr = frontier.front();
-    frontier.pop_front();
+/* Gives every class a dense id and a bitset of the classes it conforms to.
+   Only valid once the inheritance graph is known to be acyclic. */
+void TypeChecker::populate_class_ancestors() {
+  ClassTables &t = *ctx.tables;
+  t.class_id.clear();
+  t.class_id.reserve(t.class_names.size());
+  for (int i = 0; i < (int)t.class_names.size(); i++) {
+    t.class_id[SymbolTable::global().intern(t.class_names[i])] = i;
+  }
 
-    for (const string &parent : class_parents[curr]) {
-      if (ancs.find(parent) == ancs.end()) {
-        ancs.insert(parent);
-        frontier.push_back(parent);
-      }
+  t.ancestor_words = (t.class_names.size() + 63) / 64;
+  t.ancestor_bits.assign(t.class_names.size() * t.ancestor_words, 0);
+  vector<bool> done(t.class_names.size(), false);
+  for (int i = 0; i < (int)t.class_names.size(); i++) {
+    if (!done[i]) fill_ancestor_bits(ctx, i, done);
+  }
+}
+
+/* Builds class C's feature tables, its parents' first. Methods resolve in
+   the README's left-to-right parent order, and C's own features override */
+static void build_feature_table(SemaContext &ctx, int c, vector<bool> &done) {
+  ClassTables &t = *ctx.tables;
+  done[c] = true;
+  MethodTable &meths = t.method_tables[c];
+  AttrTable &attrs = t.attr_tables[c];
+  SymbolTable &symtab = SymbolTable::global();
+
+  bool first = true;
+  for (const string &parent : t.class_parents[t.class_names[c]]) {
+    int p = get_class_id(ctx, symtab.intern(parent));
+    if (p < 0) continue;
+    if (!done[p]) build_feature_table(ctx, p, done);
+    if (first) {
+      /* the first parent's layout is a prefix of ours */
+      meths = t.method_tables[p];
+      attrs = t.attr_tables[p];
+      first = false;
+      continue;
+    }
+    for (const MethodTable::Entry &e : t.method_tables[p].get_entries()) {
+      meths.inherit(e);
+    }
+    for (const AttrTable::Entry &e : t.attr_tables[p].get_entries()) {
+      attrs.inherit(e);
     }
   }
 
-  return ancs;
+  for (Feature *f : t.classes[t.class_names[c]]->get_feature_list()) {
+    if (f->is_method()) {
+      MethodStmt *m = static_cast<MethodStmt *>(f);
+      meths.define(symtab.intern(m->get_name()), m, c);
+    } else {
+      AttrStmt *a = static_cast<AttrStmt *>(f);
+      attrs.define(symtab.intern(a->get_name()), a, c);
+    }
+  }
 }
 
-void TypeChecker::populate_class_ancestors() {
-  for (const string &name : class_names) {
-    class_ancestors[name] = get_ancestors(name);
+/* Gives every class its finalized, name-interned method and attribute
+   tables, which double as its vtable and field layouts */
+void TypeChecker::build_feature_tables() {
+  ClassTables &t = *ctx.tables;
+  t.method_tables.assign(t.class_names.size(), MethodTable());
+  t.attr_tables.assign(t.class_names.size(), AttrTable());
+  vector<bool> done(t.class_names.size(), false);
+  for (int i = 0; i < (int)t.class_names.size(); i++) {
+    if (!done[i]) build_feature_table(ctx, i, done);
   }
 }
 
+void TypeChecker::print_stats(std::ostream &os) {
+  size_t made = ctx.specializations_made;
+  size_t hits = ctx.specialization_lookups - made;
+  os << "cmp_meth cache: " << made << " made, " << hits << " hits / "
+     << ctx.specialization_lookups << " lookups";
+  if (ctx.specialization_lookups) {
+    os << " (" << 100 * hits / ctx.specialization_lookups << "% hit rate)";
+  }
+  os << endl;
+  if (jobs > 1) {
+    os << "typecheck:      " << num_deferred << " method bodies on " << jobs
+       << " threads, " << num_steals << " stolen" << endl;
+  }
+}
+
+const MethodTable *TypeChecker::get_method_table(const string &cname) {
+  int c = get_class_id(ctx, SymbolTable::global().intern(cname));
+  return c < 0 ? NULL : &ctx.tables->method_tables[c];
+}
+
+const AttrTable *TypeChecker::get_attr_table(const string &cname) {
+  int c = get_class_id(ctx, SymbolTable::global().intern(cname));
+  return c < 0 ? NULL : &ctx.tables->attr_tables[c];
+}
+
+bool TypeChecker::inherits_from(const string &a, const string &b) {
+  SymbolTable &symtab = SymbolTable::global();
+  return conforms_util(ctx, symtab.intern(a), symtab.intern(b));
+}
+
 /* First populates all the parents feature tables, then populates/checks
    the childs feature tables */
 void TypeChecker::populate_feature_tables() {
   map<string, bool> visited;
-  for (pair<string, vector<string>> entry : class_parents) {
+  for (const pair<const string, vector<string>> &entry :
+       ctx.tables->class_parents) {
     if (!visited[entry.first]) {
-      populate_parent_feature_tables(entry.first, visited);
+      populate_parent_feature_tables(ctx, entry.first, visited);
     }
   }
 
-  for (const string &cname : class_names) {
+  for (const string &cname : ctx.tables->class_names) {
     /* for every class */
-    for (MethodStmt *pmeth : parent_methods[cname]) {
+    for (MethodStmt *pmeth : ctx.tables->parent_methods[cname]) {
       bool can_insert = true;
-      for (MethodStmt *cmeth : class_methods[cname]) {
+      for (MethodStmt *cmeth : ctx.tables->class_methods[cname]) {
         if (pmeth->get_name() == cmeth->get_name()) {
-          if (!check_method_sigs(pmeth, cmeth, cname)) {
+          if (!check_method_sigs(ctx, pmeth, cmeth, cname)) {
             can_insert = false;
             break;
           }
         }
       }
       if (can_insert) {
-        class_methods[cname].insert(pmeth);
+        ctx.tables->class_methods[cname].insert(pmeth);
       }
     }
 
-    for (AttrStmt *pattr : parent_attrs[cname]) {
+    for (AttrStmt *pattr : ctx.tables->parent_attrs[cname]) {
       bool can_insert = true;
-      for (AttrStmt *cattr : class_attrs[cname]) {
+      for (AttrStmt *cattr : ctx.tables->class_attrs[cname]) {
         if (pattr->get_name() == cattr->get_name()) {
           string err_msg = "Class " + cname +
                            " cannot redefine inherited attribute `" +
                            cattr->get_name() + "` defined by parent on line " +
                            to_string(pattr->lineno);
-          error(cattr->lineno, err_msg);
+          error(ctx, cattr->lineno, err_msg);
           can_insert = false;
         }
       }
       if (can_insert) {
-        class_attrs[cname].insert(pattr);
+        ctx.tables->class_attrs[cname].insert(pattr);
       }
     }
   }
@@ -586,60 +772,61 @@ bool TypeChecker::check_global_features() {
         string err_msg = "Method `" + m->get_name() +
                          "` has invalid return type `" +
                          m->get_ret_type()->to_str() + "`";
-        error(m->lineno, err_msg);
+        error(ctx, m->lineno, err_msg);
         ret_val = false;
       }
 
       /* check formal type is valid */
-      FormalList formal_list = m->get_formal_list();
+      const FormalList &formal_list = m->get_formal_list();
       for (FormalStmt *f : formal_list) {
         if (!check_valid_type_(f->get_type())) {
           string err_msg = "Formal `" + f->get_name() + "` has invalid type `" +
                            f->get_type()->to_str() + "`";
-          error(f->lineno, err_msg);
+          error(ctx, f->lineno, err_msg);
           ret_val = false;
         }
       }
 
       /* check if method is already defined */
       bool can_insert = true;
-      for (MethodStmt *gm : global_methods) {
-        if (gm->get_name() == m->get_name()) {
-          string err_msg =
-              "method `" + m->get_name() + "` cannot be defined twice";
-          error(m->lineno, err_msg);
-          ret_val = false;
-          can_insert = false;
-        }
+      if (ctx.tables->global_method_table.lookup(
+              SymbolTable::global().intern(m->get_name()))) {
+        string err_msg =
+            "method `" + m->get_name() + "` cannot be defined twice";
+        error(ctx, m->lineno, err_msg);
+        ret_val = false;
+        can_insert = false;
       }
       if (can_insert) {
         if (m->get_name() == Main) {
-          if (!conforms(class_type[Void], m->get_ret_type())) {
+          if (!conforms(ctx, ctx.tables->class_type[Void], m->get_ret_type())) {
             string err_msg = "method 'main' must return void";
-            error(m->lineno, err_msg);
+            error(ctx, m->lineno, err_msg);
           }
           if (formal_list.size() != 1) {
             string err_msg =
                 "method 'main' must have one argument: list<string> args";
-            error(m->lineno, err_msg);
+            error(ctx, m->lineno, err_msg);
           } else {
             FormalStmt *f = formal_list[0];
             Type_ *ft = f->get_type();
-            if (!conforms(ft, new Type_(List, class_type[String]))) {
+            Type_ *args_type =
+                ctx.types->get(List, ctx.tables->class_type[String]);
+            if (!conforms(ctx, ft, args_type)) {
               string err_msg =
                   "method 'main' must have one argument: list<string> args";
-              error(m->lineno, err_msg);
+              error(ctx, m->lineno, err_msg);
             }
           }
         }
-        global_methods.insert(m);
+        add_global_method(m);
       }
     } else {
       AttrStmt *a = static_cast<AttrStmt *>(f);
       if (!check_valid_type_(a->get_type())) {
         string err_msg = "Attribute `" + a->get_name() +
                          "` has invalid type `" + a->get_type()->to_str() + "`";
-        error(a->lineno, err_msg);
+        error(ctx, a->lineno, err_msg);
         ret_val = false;
       }
     }
@@ -649,7 +836,9 @@ bool TypeChecker::check_global_features() {
 
 /* entry point for type checking, called from main. */
 int TypeChecker::typecheck() {
-  curr_filename = filename;
+  /* start from scratch, so typecheck() can be called again */
+  ctx = SemaContext(arena, types, filename);
+  worker_arenas.clear();
 
   initialize_basic_classes();
   initialize_builtin_methods();
@@ -658,29 +847,92 @@ int TypeChecker::typecheck() {
 
   if (!check_inheritance_cycles()) {
     /* cannot continue typechecking if there are inheritance cycles */
-    return semant_errors++;
+    return ctx.semant_errors++;
   }
 
   populate_class_ancestors();
 
   populate_feature_tables();
 
+  build_feature_tables();
+
   if (!check_global_features()) {
     /* cannot continue typechecking if global features have type declaration
      * errors */
-    return semant_errors;
+    return ctx.semant_errors;
   }
 
-  scopetable.push_scope();
+  /* with -j N, this pass only queues the method bodies */
+  string diags;
+  vector<DeferredMethod> deferred;
+  if (jobs > 1) {
+    ctx.diag_buf = &diags;
+    ctx.deferred = &deferred;
+  }
 
-  for (int i = 0; i < program.len(); i++) {
-    Stmt *s = program.ith(i);
-    s->typecheck();
+  ctx.scopetable.push_scope();
+
+  for (Stmt *s : program) {
+    s->typecheck(ctx);
+  }
+
+  ctx.scopetable.pop_scope();
+
+  if (jobs > 1) {
+    ctx.diag_buf = NULL;
+    ctx.deferred = NULL;
+    check_deferred_methods(deferred, diags);
+  }
+
+  return ctx.semant_errors;
+}
+
+/* Checks the method bodies queued by the first pass on a pool of JOBS
+   threads. Each worker has its own context (scope table, arena, cmp_meth
+   cache) and they all read the same class tables. Prints all diagnostics of
+   the program, in source order. */
+void TypeChecker::check_deferred_methods(vector<DeferredMethod> &deferred,
+                                         const string &diags) {
+  WorkStealingPool pool(jobs);
+  vector<SemaContext> workers(pool.get_num_workers(), ctx);
+  for (SemaContext &w : workers) {
+    /* specialized methods are made while checking bodies */
+    worker_arenas.emplace_back(new AstArena);
+    w.arena = worker_arenas.back().get();
   }
 
-  scopetable.pop_scope();
+  /* a body leaves the scope table as it found it, so a worker only needs a
+     new copy when the snapshot changes */
+  vector<const ScopeTable *> worker_scope(workers.size(), NULL);
+  pool.run(deferred.size(), [&](size_t w, size_t t) {
+    SemaContext &wctx = workers[w];
+    DeferredMethod &d = deferred[t];
+    if (worker_scope[w] != d.scope.get()) {
+      wctx.scopetable = *d.scope;
+      worker_scope[w] = d.scope.get();
+    }
+    wctx.diag_buf = &d.diags;
+    wctx.semant_errors = wctx.warnings = 0;
+    d.method->typecheck(wctx);
+    d.errors = wctx.semant_errors;
+    d.warnings = wctx.warnings;
+  });
+
+  size_t pos = 0;
+  for (const DeferredMethod &d : deferred) {
+    llvm::errs() << diags.substr(pos, d.diag_pos - pos) << d.diags;
+    pos = d.diag_pos;
+    ctx.semant_errors += d.errors;
+    ctx.warnings += d.warnings;
+  }
+  llvm::errs() << diags.substr(pos);
 
-  return semant_errors;
+  for (const SemaContext &w : workers) {
+    ctx.specializations_made += w.specializations_made;
+    ctx.specialization_lookups += w.specialization_lookups;
+  }
+  num_deferred = deferred.size();
+  num_steals = pool.get_num_steals();
 }
 
 //////////////////////////////////////////////////////////////
@@ -691,57 +943,56 @@ int TypeChecker::typecheck() {
 //
 //////////////////////////////////////////////////////////////
 
-/* returns true of a conforms to b, false otherwise */
-bool conforms_util(const string &a, const string &b) {
+/* returns true of a conforms to b, false otherwise. A bit test once
+   populate_class_ancestors() has run */
+static bool conforms_util(SemaContext &ctx, Symbol a, Symbol b) {
   if (a == b) {
     return true;
   }
 
-  stack<string> frontier;
-  frontier.push(a);
-  set<string> visited;
-
-  while (!frontier.empty()) {
-    string curr = frontier.top();
-    frontier.pop();
-
-    if (curr == b) {
-      return true;
-    }
-
-    visited.insert(curr);
-
-    for (string &parent : class_parents[curr]) {
-      if (visited.find(parent) == visited.end()) {
-        frontier.push(parent);
-      }
-    }
+  int ca = get_class_id(ctx, a);
+  int cb = get_class_id(ctx, b);
+  if (ca < 0 || cb < 0) {
+    return false;
   }
-  return false;
+  const ClassTables &t = *ctx.tables;
+  return t.ancestor_bits[ca * t.ancestor_words + cb / 64] >> (cb % 64) & 1;
 }
 
 /* Given two ptrs to Type_ objects, returns true if A conforms to B, false
  * otherwise. */
-bool conforms(Type_ *a, Type_ *b) {
+bool conforms(SemaContext &ctx, Type_ *a, Type_ *b) {
+  if (a == b) {
+    /* types are interned */
+    return true;
+  }
+
   if (b->get_name() == Object) {
     /* every class conforms to Object class */
     return true;
   }
 
-  if (!conforms_util(a->get_name(), b->get_name())) {
+  if (!conforms_util(ctx, a->get_sym(), b->get_sym())) {
     return false;
   }
 
   Type_ *a_nest = a->get_nested_type();
   Type_ *b_nest = b->get_nested_type();
 
-  if (a_nest == NULL && b_nest != NULL || a_nest != NULL && b_nest == NULL) {
+  if ((a_nest == NULL && b_nest != NULL) ||
+      (a_nest != NULL && b_nest == NULL)) {
     return false;
   } else if (a_nest == NULL && b_nest == NULL)
     return true;
   // if (a_nest != NULL && b_nest != NULL)
-  else
-    return conforms(a_nest, b_nest);
+  else if (!conforms(ctx, a_nest, b_nest))
+    return false;
+
+  /* dicts: the value types, the same way */
+  Type_ *a_val = a->get_value_type();
+  Type_ *b_val = b->get_value_type();
+  if (a_val == NULL || b_val == NULL) return a_val == b_val;
+  return conforms(ctx, a_val, b_val);
 }
 
 //////////////////////////////////////////////////////////////
@@ -756,22 +1007,34 @@ bool conforms(Type_ *a, Type_ *b) {
   STATEMENTS should return NULL on every typecheck
 */
 
-Type_ *FormalStmt::typecheck() {
-  scopetable.add_elem(name, type);
+Type_ *FormalStmt::typecheck(SemaContext &ctx) {
+  ctx.scopetable.add_elem(name, type);
   return NULL;
 }
 
-static bool in_method = false; /* to ensure ReturnExpr* only occur in methods */
-static MethodStmt *curr_method; /* the current method being typechecked */
-static int curr_method_num_nested_rex = 0;
+/* queues M's body, with a snapshot of the scope it would be checked in */
+static void defer_method(SemaContext &ctx, MethodStmt *m) {
+  if (!ctx.deferred_scope ||
+      ctx.deferred_scope_changes != ctx.scopetable.get_num_changes()) {
+    ctx.deferred_scope = make_shared<const ScopeTable>(ctx.scopetable);
+    ctx.deferred_scope_changes = ctx.scopetable.get_num_changes();
+  }
+  ctx.deferred->push_back(
+      {m, ctx.deferred_scope, ctx.diag_buf->size(), "", 0, 0});
+}
+
+Type_ *MethodStmt::typecheck(SemaContext &ctx) {
+  if (ctx.deferred && !ctx.in_method) {
+    defer_method(ctx, this);
+    return NULL;
+  }
 
-Type_ *MethodStmt::typecheck() {
-  scopetable.push_scope();
-  in_method = true;
-  curr_method = this;
+  ctx.scopetable.push_scope();
+  ctx.in_method = true;
+  ctx.curr_method = this;
   /* add all formals */
   for (FormalStmt *f : formal_list) {
-    f->typecheck();
+    f->typecheck(ctx);
   }
 
   /*
@@ -797,21 +1060,21 @@ Type_ *MethodStmt::typecheck() {
 
     if (contains_ret_expr) {
       string warn_msg = "Any code after return expression is dead code";
-      warning(s->lineno, warn_msg);
+      warning(ctx, s->lineno, warn_msg);
       /* no need to keep typechecking */
       break;
     }
 
     if (dynamic_cast<MethodStmt *>(s)) {
       string err_msg = "Cannot nest method definitions";
-      error(s->lineno, err_msg);
+      error(ctx, s->lineno, err_msg);
       continue;
     }
 
-    s->typecheck();
+    s->typecheck(ctx);
 
     if (dynamic_cast<IfStmt *>(s)) {
-      curr_method_num_nested_rex--;
+      ctx.curr_method_num_nested_rex--;
     }
 
     if (dynamic_cast<ReturnExpr *>(s)) {
@@ -820,134 +1083,134 @@ Type_ *MethodStmt::typecheck() {
   }
 
   if (!contains_ret_expr) {
-    if (curr_method_num_nested_rex != stmt_list.size() ||
+    if (ctx.curr_method_num_nested_rex != (int)stmt_list.size() ||
         stmt_list.size() == 0) {
       string err_msg =
           "Method `" + name + "` does not return in all control paths";
-      error(lineno, err_msg);
+      error(ctx, lineno, err_msg);
     }
   }
 
-  in_method = false;
-  curr_method_num_nested_rex = 0;
-  curr_method = NULL;
-  scopetable.pop_scope();
+  ctx.in_method = false;
+  ctx.curr_method_num_nested_rex = 0;
+  ctx.curr_method = NULL;
+  ctx.scopetable.pop_scope();
   return NULL;
 }
 
-Type_ *IfStmt::typecheck() {
-  Type_ *pred_type = pred->typecheck();
-  if (pred_type && !conforms(pred_type, class_type[Bool])) {
+Type_ *IfStmt::typecheck(SemaContext &ctx) {
+  Type_ *pred_type = check(ctx, pred);
+  if (pred_type && !conforms(ctx, pred_type, class_type_of(ctx, Bool))) {
     string err_msg =
         "Expected bool in predicate, instead got `" + pred_type->to_str() + "`";
-    error(pred->lineno, err_msg);
+    error(ctx, pred->lineno, err_msg);
   }
 
   for (Stmt *s : then_branch) {
-    s->typecheck();
+    s->typecheck(ctx);
   }
 
   for (Stmt *s : else_branch) {
-    s->typecheck();
+    s->typecheck(ctx);
   }
 
   return NULL;
 }
 
-Type_ *ClassStmt::typecheck() {
-  scopetable.push_scope();
+Type_ *ClassStmt::typecheck(SemaContext &ctx) {
+  ctx.scopetable.push_scope();
 
   for (Feature *f : feature_list) {
     if (f->is_method()) {
       MethodStmt *m = static_cast<MethodStmt *>(f);
-      m->typecheck();
+      m->typecheck(ctx);
     } else {
       AttrStmt *a = static_cast<AttrStmt *>(f);
-      a->typecheck();
+      a->typecheck(ctx);
     }
   }
 
-  scopetable.pop_scope();
+  ctx.scopetable.pop_scope();
 
   return NULL;
 }
 
-Type_ *ForStmt::typecheck() {
-  if (stmt) stmt->typecheck();
+Type_ *ForStmt::typecheck(SemaContext &ctx) {
+  if (stmt) stmt->typecheck(ctx);
 
   if (cond) {
-    Type_ *c_type = cond->typecheck();
-    if (!conforms(class_type[Bool], c_type)) {
+    Type_ *c_type = check(ctx, cond);
+    if (!conforms(ctx, class_type_of(ctx, Bool), c_type)) {
       string err_str = "For loop conditional must be of type Bool";
-      error(cond->lineno, err_str);
+      error(ctx, cond->lineno, err_str);
     }
   }
 
-  if (repeat) repeat->typecheck();
+  if (repeat) check(ctx, repeat);
 
   for (Stmt *s : stmt_list) {
-    s->typecheck();
+    s->typecheck(ctx);
   }
 
   return NULL;
 }
 
 /* checks if init expr type conforms to declared, adds to scopetable */
-Type_ *AttrStmt::typecheck() {
+Type_ *AttrStmt::typecheck(SemaContext &ctx) {
   Type_ *init_type;
 
-  if (conforms(type, class_type[Void])) {
+  if (conforms(ctx, type, class_type_of(ctx, Void))) {
     /* variable cannot be void */
     string err_msg = "Variable " + name + " cannot be declared as Void";
-    error(lineno, err_msg);
+    error(ctx, lineno, err_msg);
     goto done;
   }
 
-  if (!class_type[type->get_name()]) {
+  if (!class_type_of(ctx, type->get_name())) {
     /* unknown type */
     string err_msg = "Undefined type `" + type->get_name() + "`";
-    error(lineno, err_msg);
+    error(ctx, lineno, err_msg);
     goto done;
   }
 
   if (!init) goto done;
 
-  init_type = init->typecheck();
+  init_type = check(ctx, init);
   if (!init_type) {
     /* if there's no initializing of variable */
     goto done;
   }
 
-  if (init_type && !conforms(init_type, type)) {
+  if (init_type && !conforms(ctx, init_type, type)) {
     string err_msg = "Variable `" + name + "` (declared as " + type->to_str() +
                      ") is initialized to a value of type " +
                      init_type->to_str();
-    error(lineno, err_msg);
+    error(ctx, lineno, err_msg);
   }
 
 done:
   /* give declared type precedence on error, else they are the same */
-  scopetable.add_elem(name, type);
+  ctx.scopetable.add_elem(name, type);
   return NULL;
 }
 
-Type_ *WhileStmt::typecheck() {
-  Type_ *pred_t = pred->typecheck();
+Type_ *WhileStmt::typecheck(SemaContext &ctx) {
+  Type_ *pred_t = check(ctx, pred);
 
-  if (!conforms(class_type[Bool], pred_t)) {
+  if (!conforms(ctx, class_type_of(ctx, Bool), pred_t)) {
     string err_str = "Predicate in while loop must be of type bool";
-    error(pred->lineno, err_str);
+    error(ctx, pred->lineno, err_str);
   }
 
   for (Stmt *s : stmt_list) {
-    s->typecheck();
+    s->typecheck(ctx);
   }
 
   return NULL;
 }
 
-Type_ *BreakStmt::typecheck() { return NULL; }
-Type_ *ContStmt::typecheck() { return NULL; }
+Type_ *BreakStmt::typecheck(SemaContext &) { return NULL; }
+Type_ *ContStmt::typecheck(SemaContext &) { return NULL; }
 
 //////////////////////////////////////////////////////////////
 //
@@ -958,72 +1221,75 @@ Type_ *ContStmt::typecheck() { return NULL; }
 //////////////////////////////////////////////////////////////
 
 /* this checks the declared return type with the actual return type */
-void check_rex(Type_ *ret_type_actual, int lineno) {
-  assert(in_method);
-  Type_ *ret_type_decl = curr_method->get_ret_type();
-  if (conforms(ret_type_decl, class_type[Void])) {
+void check_rex(SemaContext &ctx, Type_ *ret_type_actual, int lineno) {
+  assert(ctx.in_method);
+  Type_ *ret_type_decl = ctx.curr_method->get_ret_type();
+  if (conforms(ctx, ret_type_decl, class_type_of(ctx, Void))) {
     // if return type of method is void
-    if (!conforms(ret_type_actual, class_type[Void])) {
+    if (ret_type_actual &&
+        !conforms(ctx, ret_type_actual, class_type_of(ctx, Void))) {
       // if return value is not void
-      string warn_msg = "Void method `" + curr_method->get_name() +
+      string warn_msg = "Void method `" + ctx.curr_method->get_name() +
                         "` may return `" + ret_type_actual->to_str() + "`";
-      warning(lineno, warn_msg);
+      warning(ctx, lineno, warn_msg);
     }
   } else {
     // return type is not void
     if (!ret_type_actual) {
       // but returning void value
-      string err_msg = "method `" + curr_method->get_name() +
+      string err_msg = "method `" + ctx.curr_method->get_name() +
                        "` has return type of " + ret_type_decl->to_str() +
                        " and is returning a `void` value";
-      error(lineno, err_msg);
-    } else if (!conforms(ret_type_actual, ret_type_decl)) {
+      error(ctx, lineno, err_msg);
+    } else if (!conforms(ctx, ret_type_actual, ret_type_decl)) {
       // returning wrong type
-      string err_msg = "method `" + curr_method->get_name() +
+      string err_msg = "method `" + ctx.curr_method->get_name() +
                        "` is returning a `" + ret_type_actual->to_str() +
                        "` when its declared return type is `" +
                        ret_type_decl->to_str() + "`";
-      error(lineno, err_msg);
+      error(ctx, lineno, err_msg);
     }
   }
 }
 
-Type_ *ReturnExpr::typecheck() {
+Type_ *ReturnExpr::typecheck(SemaContext &ctx) {
   Type_ *t = NULL;
-  if (expr) t = expr->typecheck();
+  if (expr) t = check(ctx, expr);
 
-  if (!in_method) {
+  if (!ctx.in_method) {
     string warn_msg = "Return expression outside of method has no function";
-    warning(lineno, warn_msg);
+    warning(ctx, lineno, warn_msg);
   } else {
-    check_rex(t, lineno);
-    curr_method_num_nested_rex++;
+    check_rex(ctx, t, lineno);
+    ctx.curr_method_num_nested_rex++;
   }
   /* possible that RETURN has no expression */
   return t;
 }
 
-Type_ *ListElemRef::typecheck() {
+Type_ *ListElemRef::typecheck(SemaContext &ctx) {
   /* should return T = list<object> */
-  Type_ *index_type = index->typecheck();
+  Type_ *index_type = check(ctx, index);
 
-  if (!conforms(index_type, class_type[Int])) {
+  if (!conforms(ctx, index_type, class_type_of(ctx, Int))) {
     string err_msg =
         "When indexing a list, the index expression must be of type Int";
-    error(lineno, err_msg);
+    error(ctx, lineno, err_msg);
   }
 
-  Type_ *name_type = list_name->typecheck();
+  Type_ *name_type = check(ctx, list_name);
   if (!name_type) return NULL;
 
+  /* string[n] is the char at n */
+  if (name_type == class_type_of(ctx, String)) return class_type_of(ctx, Char);
   return name_type->get_nested_type();
 }
 
-Type_ *SublistExpr::typecheck() {
+Type_ *SublistExpr::typecheck(SemaContext &ctx) {
   ExprStmt *st_idx = get_st_idx();
   Type_ *st_idx_type_;
   if (st_idx) {
-    st_idx_type_ = st_idx->typecheck();
+    st_idx_type_ = check(ctx, st_idx);
   } else {
     st_idx_type_ = NULL;
   }
@@ -1031,24 +1297,25 @@ Type_ *SublistExpr::typecheck() {
   ExprStmt *end_idx = get_end_idx();
   Type_ *end_idx_type_;
   if (end_idx) {
-    end_idx_type_ = end_idx->typecheck();
+    end_idx_type_ = check(ctx, end_idx);
   } else {
     end_idx_type_ = NULL;
   }
 
-  if ((st_idx_type_ && !conforms(st_idx_type_, class_type[Int])) ||
-      (end_idx_type_ && !conforms(end_idx_type_, class_type[Int]))) {
+  if ((st_idx_type_ && !conforms(ctx, st_idx_type_, class_type_of(ctx, Int))) ||
+      (end_idx_type_ &&
+       !conforms(ctx, end_idx_type_, class_type_of(ctx, Int)))) {
     string err_msg =
         "When creating sublist list[a:b], both a and b must be ints";
-    error(lineno, err_msg);
+    error(ctx, lineno, err_msg);
   }
 
   // if (!conforms(end_idx_t, class_type[Int])) {
   //   string err_msg = "When creating sublist l[a:b], both a and b must be
-  //   ints"; error(lineno, err_msg);
+  //   ints"; error(ctx, lineno, err_msg);
   // }
 
-  Type_ *name_type = get_list_name()->typecheck();
+  Type_ *name_type = check(ctx, get_list_name());
   if (!name_type) {
     return NULL;
   }
@@ -1067,93 +1334,130 @@ Type_ *SublistExpr::typecheck() {
    of type `int`, so that a `string` would result in an error
 
 */
-MethodStmt *update_cmp_meth(Type_ *calling_type, MethodStmt *orig) {
+MethodStmt *update_cmp_meth(SemaContext &ctx, Type_ *calling_type,
+                            MethodStmt *orig) {
   Type_ *ret_type;
   string name;
   FormalList formal_list;
 
   Type_ *nested_type = calling_type->get_nested_type();
-  if (conforms(class_type[Object], orig->get_ret_type())) {
-    ret_type = nested_type;
+  /* a dict's methods take and return values as well as keys */
+  Type_ *value_type = calling_type->get_value_type();
+  Type_ *ret_nested = orig->get_ret_type()->get_nested_type();
+  if (conforms(ctx, class_type_of(ctx, Object), orig->get_ret_type())) {
+    ret_type = value_type ? value_type : nested_type;
+  } else if (value_type && ret_nested &&
+             conforms(ctx, class_type_of(ctx, Object), ret_nested)) {
+    /* keys() and values() */
+    ret_type = ctx.types->get(orig->get_ret_type()->get_sym(),
+                              orig->get_name() == Values ? value_type
+                                                         : nested_type);
   } else {
     ret_type = orig->get_ret_type();
   }
 
   name = orig->get_name();
-  FormalList orig_formal_list = orig->get_formal_list();
-
-  for (FormalStmt *f : orig_formal_list) {
+  for (FormalStmt *f : orig->get_formal_list()) {
     FormalStmt *new_f;
-    if (conforms(class_type[Object], f->get_type())) {
-      new_f = new FormalStmt(nested_type, Object);
+    if (value_type && f->get_name() == Dict_Value) {
+      new_f = ctx.arena->make<FormalStmt>(value_type, Dict_Value);
+    } else if (conforms(ctx, class_type_of(ctx, Object), f->get_type())) {
+      new_f = ctx.arena->make<FormalStmt>(nested_type, Object);
     } else {
       new_f = f;
     }
     formal_list.push_back(new_f);
   }
 
-  MethodStmt *m = new MethodStmt(ret_type, name, formal_list, {});
+  MethodStmt *m = ctx.arena->make<MethodStmt>(
+      ret_type, move(name), move(formal_list), StmtList());
+  if (orig->is_builtin()) m->set_builtin();
   return m;
 }
 
-Type_ *DispatchExpr::typecheck() {
-  MethodStmt *cmp_meth;
-  Type_ *calling_type;
+/* update_cmp_meth(), made once per (container type, method) and reused */
+static MethodStmt *specialize(SemaContext &ctx, Type_ *calling_type, int slot,
+                              MethodStmt *orig) {
+  ctx.specialization_lookups++;
+  uint64_t key = (uint64_t)calling_type->get_id() << 32 | (uint32_t)slot;
+  MethodStmt *&m = ctx.specializations[key];
+  if (!m) {
+    m = update_cmp_meth(ctx, calling_type, orig);
+    ctx.specializations_made++;
+  }
+  return m;
+}
+
+/* true if T is a list whose elements sum() and min()/max() can reduce */
+static bool is_numeric_list(Type_ *t) {
+  Type_ *elem = t ? t->get_nested_type() : NULL;
+  if (!elem) return true; /* already reported, or an empty literal */
+  const string &e = elem->get_name();
+  return e == Int || e == Deci || e == Bool || e == Char;
+}
+
+Type_ *DispatchExpr::typecheck(SemaContext &ctx) {
+  MethodStmt *cmp_meth = NULL;
+  int method_slot = -1;
+  Type_ *calling_type = NULL; /* stays NULL for global methods */
   bool exists = false;
   if (calling_expr) {
-    calling_type = calling_expr->typecheck();
+    calling_type = check(ctx, calling_expr);
+    if (!calling_type) {
+      /* the calling expression has already been reported */
+      return NULL;
+    }
     // check method exists for calling type
-    string class_name = calling_type->get_name();
-    set<MethodStmt *> &meths = class_methods[class_name];
-    for (MethodStmt *m : meths) {
-      if (m->get_name() == name) {
-        exists = true;
-        cmp_meth = m;
-        break;
-      }
+    const string &class_name = calling_type->get_name();
+    int c = get_class_id(ctx, calling_type->get_sym());
+    const MethodTable::Entry *e =
+        c < 0 ? NULL : ctx.tables->method_tables[c].lookup(sym);
+    if (e) {
+      exists = true;
+      cmp_meth = e->feature;
+      method_slot = e->slot;
     }
     if (!exists) {
-      string err_msg = "Class `" + class_type[class_name]->to_str() +
+      string err_msg = "Class `" + class_type_of(ctx, class_name)->to_str() +
                        "` has no method " + name + "`";
-      error(lineno, err_msg);
+      error(ctx, lineno, err_msg);
     }
   } else {
     // check global methods
-    for (MethodStmt *m : global_methods) {
-      if (m->get_name() == name) {
-        exists = true;
-        cmp_meth = m;
-        break;
-      }
+    const MethodTable::Entry *e = ctx.tables->global_method_table.lookup(sym);
+    if (e) {
+      exists = true;
+      cmp_meth = e->feature;
     }
     if (!exists) {
       string err_msg = "Method `" + name + "` does not exist";
-      error(lineno, err_msg);
+      error(ctx, lineno, err_msg);
     }
   }
   if (exists) {
-    if (calling_type->get_nested_type()) {
-      cmp_meth = update_cmp_meth(calling_type, cmp_meth);
+    if (calling_type && calling_type->get_nested_type()) {
+      cmp_meth = specialize(ctx, calling_type, method_slot, cmp_meth);
     }
+    resolve(cmp_meth, method_slot);
 
-    FormalList fl = cmp_meth->get_formal_list();
+    const FormalList &fl = cmp_meth->get_formal_list();
 
     /* check num args and num params are equal */
     if (args.size() != fl.size()) {
       string err_msg = "Dispatch of method `" + name + "` requires " +
                        to_string(fl.size()) + " arg(s), you provided " +
                        to_string(args.size()) + " arg(s)";
-      error(lineno, err_msg);
+      error(ctx, lineno, err_msg);
     } else {
       for (int i = 0; i < (int)args.size(); i++) {
         ExprStmt *arg = args[i];
-        Type_ *arg_type = arg->typecheck();
+        Type_ *arg_type = check(ctx, arg);
         if (i > (int)fl.size() - 1) {
           string warn_msg = "Method " + cmp_meth->get_name() + " has " +
                             to_string(fl.size()) +
                             " arguments, so any more will be ignored.";
-          warning(lineno, warn_msg);
-        } else if (!conforms(arg_type, fl[i]->get_type())) {
+          warning(ctx, lineno, warn_msg);
+        } else if (!conforms(ctx, arg_type, fl[i]->get_type())) {
           string suffix;
           /* this is pretty humor lmao */
           switch ((i + 1) % 10) {
@@ -1175,132 +1479,187 @@ Type_ *DispatchExpr::typecheck() {
                            "()` needs to be of type `" +
                            fl[i]->get_type()->to_str() + "` instead of type `" +
                            arg_type->to_str() + "`";
-          error(lineno, err_msg);
+          error(ctx, lineno, err_msg);
+        } else if (!calling_type &&
+                   (name == Sum || name == Min || name == Max) &&
+                   !is_numeric_list(arg_type)) {
+          /* the runtime adds and compares elements as numbers */
+          string err_msg = "The argument of function call `" + name +
+                           "()` needs to be a list of int, deci, bool or "
+                           "char instead of type `" +
+                           arg_type->to_str() + "`";
+          error(ctx, lineno, err_msg);
         }
       }
     }
   }
-  return cmp_meth->get_ret_type();
+  return cmp_meth ? cmp_meth->get_ret_type() : NULL;
 }
 
-Type_ *IntConstExpr::typecheck() { return class_type[Int]; }
+Type_ *IntConstExpr::typecheck(SemaContext &ctx) {
+  return class_type_of(ctx, Int);
+}
 
-Type_ *DeciConstExpr::typecheck() { return class_type[Deci]; }
+Type_ *DeciConstExpr::typecheck(SemaContext &ctx) {
+  return class_type_of(ctx, Deci);
+}
 
-Type_ *ObjectIdExpr::typecheck() {
-  Type_ *type_ = scopetable.lookup(name);
+Type_ *ObjectIdExpr::typecheck(SemaContext &ctx) {
+  Type_ *type_ = ctx.scopetable.lookup(sym);
   if (!type_) {
     string err_msg = "Unknown variable: `" + name + "`";
-    error(lineno, err_msg);
+    error(ctx, lineno, err_msg);
     return NULL;
   }
   return type_;
 }
 
-Type_ *BoolConstExpr::typecheck() { return class_type[Bool]; }
+Type_ *BoolConstExpr::typecheck(SemaContext &ctx) {
+  return class_type_of(ctx, Bool);
+}
 
-Type_ *lub(Type_ *a, Type_ *b) {
+Type_ *lub(SemaContext &ctx, Type_ *a, Type_ *b) {
   if (!a || !b) {
-    return class_type[Object];
+    return class_type_of(ctx, Object);
+  }
+
+  if (a == b) {
+    return a;
   }
 
-  if (a->get_name() == b->get_name()) {
+  if (a->get_sym() == b->get_sym()) {
     if (!a->get_nested_type() && !b->get_nested_type()) {
       return a;
     }
-    return lub(a->get_nested_type(), b->get_nested_type());
+    return lub(ctx, a->get_nested_type(), b->get_nested_type());
   }
 
-  set<string> a_ancs = class_ancestors[a->get_name()];
-  set<string> b_ancs = class_ancestors[b->get_name()];
+  int ca = get_class_id(ctx, a->get_sym());
+  int cb = get_class_id(ctx, b->get_sym());
+  if (ca < 0 || cb < 0) {
+    return class_type_of(ctx, Object);
+  }
 
-  for (const string &aa : a_ancs) {
-    if (b_ancs.find(aa) != b_ancs.end()) {
-      return class_type[aa];
+  /* the alphabetically first ancestor the two have in common */
+  const ClassTables &t = *ctx.tables;
+  const uint64_t *a_row = &t.ancestor_bits[ca * t.ancestor_words];
+  const uint64_t *b_row = &t.ancestor_bits[cb * t.ancestor_words];
+  const string *common = NULL;
+  for (size_t w = 0; w < t.ancestor_words; w++) {
+    uint64_t bits = a_row[w] & b_row[w];
+    while (bits) {
+      int c = (int)(w * 64 + __builtin_ctzll(bits));
+      bits &= bits - 1;
+      if (c == ca || c == cb) continue; /* not a proper ancestor */
+      if (!common || t.class_names[c] < *common) common = &t.class_names[c];
     }
   }
 
-  return class_type[Object];
+  return common ? class_type_of(ctx, *common) : class_type_of(ctx, Object);
 }
 
-Type_ *SetConstExpr::typecheck() {
-  // TODO: !!!
-  return NULL;
+/* like a list literal: set<T>, T the lub of the elements */
+Type_ *SetConstExpr::typecheck(SemaContext &ctx) {
+  if (exprset.empty()) {
+    return NULL;
+  }
+
+  Type_ *lca = NULL;
+  for (ExprStmt *e : exprset) {
+    Type_ *curr_t = check(ctx, e);
+    if (!lca) {
+      lca = curr_t;
+    } else if (!conforms(ctx, curr_t, lca)) {
+      lca = lub(ctx, lca, curr_t);
+    }
+  }
+
+  return ctx.types->get(Set, lca);
 }
 
-Type_ *ListConstExpr::typecheck() {
+Type_ *ListConstExpr::typecheck(SemaContext &ctx) {
   if (exprlist.empty()) {
     // return NULL if empty list
     return NULL;
   }
 
-  Type_ *lca = exprlist[0]->typecheck();
+  /* every element is checked, even once the lub has reached object, so
+     codegen knows how to store each one */
+  Type_ *lca = check(ctx, exprlist[0]);
   for (int i = 1; i < (int)exprlist.size(); i++) {
-    Type_ *curr_t = exprlist[i]->typecheck();
-    if (conforms(curr_t, lca)) {
+    Type_ *curr_t = check(ctx, exprlist[i]);
+    if (conforms(ctx, curr_t, lca)) {
       continue;
     }
-    lca = lub(lca, curr_t);
-    if (conforms(class_type[Object], lca)) {
-      break;
-    }
+    lca = lub(ctx, lca, curr_t);
   }
 
-  return new Type_(List, lca);
+  return ctx.types->get(List, lca);
 }
 
-Type_ *StrConstExpr::typecheck() { return class_type[String]; }
+Type_ *StrConstExpr::typecheck(SemaContext &ctx) {
+  return class_type_of(ctx, String);
+}
 
-Type_ *CharConstExpr::typecheck() { return class_type[Char]; }
+Type_ *CharConstExpr::typecheck(SemaContext &ctx) {
+  return class_type_of(ctx, Char);
+}
 
-Type_ *NewExpr::typecheck() {
-  Type_ *type_ = class_type[newclass];
+Type_ *NewExpr::typecheck(SemaContext &ctx) {
+  Type_ *type_ = class_type_of(ctx, newclass);
   if (!type_) {
     string err_msg = "Unknown type " + newclass + " in new expression";
-    error(lineno, err_msg);
+    error(ctx, lineno, err_msg);
     return NULL;
   }
-  return class_type[newclass];
+  return class_type_of(ctx, newclass);
 }
 
-Type_ *BinopExpr::typecheck() {
-  Type_ *lhs_type = lhs->typecheck();
-  Type_ *rhs_type = rhs->typecheck();
+Type_ *BinopExpr::typecheck(SemaContext &ctx) {
+  if (!lhs || !rhs) {
+    string err_msg = "Operator `" + op + "` is missing an operand";
+    error(ctx, lineno, err_msg);
+    return NULL;
+  }
+  Type_ *rhs_type = check(ctx, rhs);
+  Type_ *lhs_type = check(ctx, lhs);
 
-  if (BINOP_PRECEDENCE[op] >= 4) {
+  if (lexing::is_assign_op(op)) {
     /* ensuring that any +=, -=, *=, /=, = ops
        cannot be done on any const expr */
     string classname = lhs->classname();
     if (classname.find("Const") != std::string::npos) {
       string err_msg =
           "Left side of operator `" + op + "` cannot be a constant value";
-      error(lineno, err_msg);
+      error(ctx, lineno, err_msg);
     }
   }
 
-  if (!conforms(lhs_type, rhs_type)) {
+  if (!conforms(ctx, lhs_type, rhs_type)) {
     /* if int and deci in same operation ==> deci */
-    if (((conforms(lhs_type, class_type[Int]) &&
-          conforms(rhs_type, class_type[Deci]))) ||
-        (conforms(lhs_type, class_type[Deci]) &&
-         conforms(rhs_type, class_type[Int]))) {
-      string warn_msg = "Operation `" + op +
-                        "` done on `int` and `deci` will evaluate to `deci`";
-      warning(lineno, warn_msg);
-      lhs_type = class_type[Deci]; /* setting the return type */
+    if (((conforms(ctx, lhs_type, class_type_of(ctx, Int)) &&
+          conforms(ctx, rhs_type, class_type_of(ctx, Deci)))) ||
+        (conforms(ctx, lhs_type, class_type_of(ctx, Deci)) &&
+         conforms(ctx, rhs_type, class_type_of(ctx, Int)))) {
+      if (!negation) {
+        string warn_msg = "Operation `" + op +
+                          "` done on `int` and `deci` will evaluate to `deci`";
+        warning(ctx, lineno, warn_msg);
+      }
+      lhs_type = class_type_of(ctx, Deci); /* setting the return type */
     } else {
       string err_msg =
           "Left side type (" + lhs_type->to_str() + ") of operator `" + op +
           "` is not the same as right side type (" + rhs_type->to_str() + ")";
-      error(lineno, err_msg);
+      error(ctx, lineno, err_msg);
     }
   }
 
-  if (BINOP_PRECEDENCE[op] == 2 || BINOP_PRECEDENCE[op] == 3) {
+  if (lexing::is_bool_op(op)) {
     /* any of the comparing operators:
       <, >, <=, >=, ==, !=, &&, ||
     */
-    return class_type[Bool];
+    return class_type_of(ctx, Bool);
   }
 
   return lhs_type;
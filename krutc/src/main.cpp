@@ -1,20 +1,62 @@
+#include <cstdlib>
 #include <iostream>
-
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "astarena.h"
+#include "codegen.h"
+#include "emitter.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "optimizer.h"
 #include "parser.h"
+#include "phasetimer.h"
+#include "typecontext.h"
 #include "typechecker.h"
 
 using namespace std;
 
+static void print_stats(AstArena &arena, TypeContext &types) {
+  cerr << "-- stats --" << endl;
+  arena.print_stats(cerr);
+  types.print_stats(cerr);
+}
+
+static bool ends_with(const string &s, const string &suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
 int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    cerr << "Usage: " << argv[0] << " <file.krut>" << endl;
+  /* `krutc run <file.krut>` compiles the script in memory and runs it */
+  bool run = argc >= 2 && string(argv[1]) == "run";
+  int first_arg = run ? 2 : 1;
+  /* the file is the first argument that is neither a flag nor a flag's
+     value, so flags may come before it */
+  int file_arg = 0;
+  for (int i = first_arg; i < argc && string(argv[i]) != "--"; i++) {
+    string arg = argv[i];
+    if (arg == "-o" || arg == "-j") {
+      i++;
+    } else if (arg[0] != '-') {
+      file_arg = i;
+      break;
+    }
+  }
+  if (!file_arg) {
+    cerr << "Usage: " << argv[0] << " [run] <file.krut> [flags]"
+         << " [-- script args]" << endl;
+    cerr << "  " << argv[0] << " <file.krut> -o <exe>     build an executable"
+         << endl;
+    cerr << "  " << argv[0] << " <file.krut> -c [-o <obj>] compile only"
+         << endl;
     return -1;
   }
-  string filename = argv[1];
+  string filename = argv[file_arg];
   string suffix = ".krut";
 
-  if (filename.compare(filename.size() - suffix.size(), suffix.size(),
-                       suffix) != 0) {
+  if (!ends_with(filename, suffix)) {
     cerr << "Error: file must be of type" + suffix << endl;
     return -1;
   }
@@ -22,38 +64,101 @@ int main(int argc, char *argv[]) {
   bool token_dump = false;
   bool debug = false;
   bool tree = false;
-  if (argc >= 3) {
-    for (int i = 2; i < argc; i++) {
-      string flag = argv[i];
-      if (flag == "-debug") {
-        debug = true;
-      } else if (flag == "-tdump") {
-        token_dump = true;
-      } else if (flag == "-tree") {
-        tree = true;
-      } else {
-        cerr << "Error: Unknown flag " + flag << endl;
-        cerr << "Expected flag '-tdump', '-debug', or '-tree'." << endl;
+  bool stats = false;
+  int jobs = 1;
+  bool emit_llvm = false;
+  bool time = false;
+  bool compile_only = false;
+  bool interp = false;
+  bool tiered = false;
+  int opt_level = 2;
+  string march;
+  string out_path;
+  /* what the script sees as its arguments, starting with its path */
+  vector<string> script_args = {filename};
+  for (int i = first_arg; i < argc; i++) {
+    if (i == file_arg) continue;
+    string flag = argv[i];
+    if (flag == "--" && run) {
+      script_args.insert(script_args.end(), argv + i + 1, argv + argc);
+      break;
+    } else if (flag == "-debug") {
+      debug = true;
+    } else if (flag == "-tdump") {
+      token_dump = true;
+    } else if (flag == "-tree") {
+      tree = true;
+    } else if (flag == "-stats") {
+      stats = true;
+    } else if (flag == "-j") {
+      jobs = i + 1 < argc ? atoi(argv[++i]) : 0;
+      if (jobs < 1) {
+        cerr << "Error: -j expects a number of threads" << endl;
+        return -1;
+      }
+    } else if (flag == "-emit-llvm") {
+      emit_llvm = true;
+    } else if (flag == "-o") {
+      if (i + 1 >= argc) {
+        cerr << "Error: -o expects an output file" << endl;
+        return -1;
       }
+      out_path = argv[++i];
+    } else if (flag == "-time") {
+      time = true;
+    } else if (flag == "-c") {
+      compile_only = true;
+    } else if (flag.size() == 3 && flag.compare(0, 2, "-O") == 0 &&
+               flag[2] >= '0' && flag[2] <= '3') {
+      opt_level = flag[2] - '0';
+    } else if (flag.compare(0, 7, "-march=") == 0) {
+      march = flag.substr(7);
+    } else if (flag == "-interp" && run) {
+      interp = true;
+    } else if (flag == "-tiered" && run) {
+      tiered = true;
+    } else {
+      cerr << "Error: Unknown flag " + flag << endl;
+      cerr << "Expected flag '-tdump', '-debug', '-tree', '-stats', "
+              "'-j N', '-emit-llvm', '-o <file>', '-c', '-O0'..'-O3', "
+              "'-march=<cpu>', '-time', or with run, '-interp' or "
+              "'-tiered'."
+           << endl;
     }
   }
 
-  Parser parser = Parser(filename, debug, token_dump);
+  PhaseTimer timer;
+
+  /* owns the AST; every node is freed when main returns */
+  AstArena arena;
+  TypeContext types(arena);
 
+  Parser parser = Parser(filename, arena, types, debug, token_dump);
+
+  Program program = parser.parse_program();
+  timer.end("parse");
+
+  /* the lexer runs alongside the parser, so its errors are known only now */
   if (!parser.check_lexer_errors()) {
+    if (stats) print_stats(arena, types);
     return -1;
   }
 
-  Program program = parser.parse_program();
-
   if (parser.parser_errors) {
     /* cannot typecheck if the parser has errors */
+    if (stats) print_stats(arena, types);
     return -1;
   }
 
-  TypeChecker typechecker = TypeChecker(program, debug, filename);
+  TypeChecker typechecker = TypeChecker(program, arena, types, debug, filename);
+  typechecker.jobs = jobs;
 
   int semant_errors = typechecker.typecheck();
+  timer.end("typecheck");
+  if (stats) {
+    print_stats(arena, types);
+    typechecker.print_stats(cerr);
+  }
 
   if (semant_errors) {
     return -1;
@@ -63,14 +168,73 @@ int main(int argc, char *argv[]) {
     program.dump();
   }
 
-  // CodeGen cgen = CodeGen(program, filename);
+  if (interp || tiered) {
+    /* run as bytecode, which starts at once; with -tiered, hot methods
+       are compiled by the JIT as the script runs */
+    Interpreter interpreter(program, typechecker, filename, tiered,
+                            opt_level);
+    interpreter.compile();
+    timer.end("bytecode");
+    int status = interpreter.run(script_args);
+    timer.end("run");
+    if (stats) interpreter.print_stats(cerr);
+    if (time) timer.print(cerr);
+    return status;
+  }
 
-  // // TODO: are there going to be CGen errors?
-  // int cgen_errors = cgen.codegen();
+  CodeGen cgen = CodeGen(program, typechecker, filename);
 
-  // if (cgen_errors) {
-  //   return -1;
-  // }
+  int cgen_errors = cgen.codegen();
+  timer.end("codegen");
+
+  if (cgen_errors) {
+    return -1;
+  }
+
+  /* outputs are named after <file>.krut unless -o says otherwise; an -o
+     file ending in .ll or .bc is LLVM IR */
+  string base = filename.substr(0, filename.size() - suffix.size());
+  if (ends_with(out_path, ".ll") || ends_with(out_path, ".bc")) {
+    emit_llvm = true;
+  }
+
+  if (run) {
+    /* the IR as generated, before the JIT optimizes it */
+    if (emit_llvm && !cgen.write(out_path.empty() ? base + ".ll" : out_path)) {
+      return -1;
+    }
+    /* from here on, the script's exit status is krutc's */
+    int status = jit_run(cgen.take_context(), cgen.take_module(), opt_level,
+                         script_args, timer);
+    if (time) timer.print(cerr);
+    return status;
+  }
+
+  if (emit_llvm || compile_only || !out_path.empty()) {
+    unique_ptr<llvm::TargetMachine> tm =
+        create_target_machine(march, opt_level);
+    if (!tm) {
+      return -1;
+    }
+    llvm::Module &module = *cgen.get_module();
+    set_target(module, *tm);
+    optimize_module(module, opt_level, tm.get());
+    timer.end("optimize");
+
+    bool ok;
+    if (emit_llvm) {
+      ok = cgen.write(out_path.empty() ? base + ".ll" : out_path);
+    } else if (compile_only) {
+      ok = emit_object(module, *tm, out_path.empty() ? base + ".o" : out_path);
+    } else {
+      ok = emit_executable(module, *tm, out_path);
+    }
+    timer.end("emit");
+    if (!ok) {
+      return -1;
+    }
+  }
 
-  return 1;
+  if (time) timer.print(cerr);
+  return 0;
 }
\ No newline at end of file
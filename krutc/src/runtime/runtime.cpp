@@ -0,0 +1,984 @@
+#include "runtime.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+/* set control bytes: a full bucket's holds 7 bits of its key's hash */
+#define CTRL_EMPTY ((int8_t)0x80)
+#define CTRL_DELETED ((int8_t)0xFE)
+#define SET_GROUP 16 /* buckets probed at once */
+
+static const char *krut_filename = "";
+static KrutList *krut_argv = NULL;
+
+[[noreturn]] static void fail(int64_t line, const string &err_msg) {
+  fflush(stdout);
+  fprintf(stderr, "%s:%lld: Runtime Error: %s\n", krut_filename,
+          (long long)line, err_msg.c_str());
+  exit(1);
+}
+
+static void *xmalloc(size_t size) {
+  void *p = malloc(size ? size : 1);
+  if (!p) {
+    fprintf(stderr, "Runtime Error: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+static void *xrealloc(void *p, size_t size) {
+  p = realloc(p, size ? size : 1);
+  if (!p) {
+    fprintf(stderr, "Runtime Error: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+void krut_init(const char *filename, int argc, char **argv) {
+  krut_filename = filename;
+  krut_argv = krut_list_new(KRUT_KIND_STR, argc);
+  for (int i = 0; i < argc; i++) {
+    krut_list_push_back(krut_argv,
+                        (int64_t)krut_str_new(argv[i], strlen(argv[i])));
+  }
+}
+
+KrutList *krut_args() {
+  return krut_argv ? krut_argv : krut_list_new(KRUT_KIND_STR, 0);
+}
+
+void krut_div_by_zero(int64_t line) { fail(line, "division by zero"); }
+
+void krut_null_dispatch(int64_t line) {
+  fail(line, "dispatch on an uninitialized object");
+}
+
+void krut_unsupported(int64_t line, const char *what) {
+  fail(line, what);
+}
+
+void *krut_alloc(int64_t size) { return calloc(1, size ? size : 1); }
+
+KrutString *krut_class_name(void *obj) {
+  if (!obj) return krut_str_new("object", 6);
+  const char *name = **(const char ***)obj;
+  return krut_str_new(name, strlen(name));
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Strings
+//
+//////////////////////////////////////////////////////////////
+
+/*
+  A string of up to KRUT_STR_INLINE bytes keeps them in its handle; a
+  longer one points into a KrutStrBuf, which slices of it share rather
+  than copy. Writing a character of a string whose buffer is shared
+  first copies it, so a slice and the string it came from never see each
+  other's writes.
+
+  Like lists, strings are references: `t = s`, passing s, or reading it
+  out of a container all hand over the same string, and `t[0] = 'x'`
+  changes s too. Slicing and concatenation make new strings.
+
+  A concatenation whose left side ends where its buffer's used bytes end
+  puts the right side in the free bytes after it, in place, and returns a
+  new string over the longer run of the same buffer. No other string
+  includes those bytes, so nothing that exists can tell, and `s += t` in
+  a loop is amortized O(len(t)). A new string is returned either way,
+  since another variable may hold the old one.
+*/
+
+/* a NULL string (an uninitialized global) reads as "" */
+static int64_t str_len(KrutString *s) { return s ? s->len : 0; }
+static const char *str_data(KrutString *s) { return s ? s->data : ""; }
+
+static KrutStrBuf *str_buf_new(int64_t cap) {
+  KrutStrBuf *buf = (KrutStrBuf *)xmalloc(sizeof(KrutStrBuf) + cap);
+  buf->shared = 0;
+  buf->cap = cap;
+  buf->used = 0;
+  return buf;
+}
+
+static KrutString *str_alloc() {
+  return (KrutString *)xmalloc(sizeof(KrutString));
+}
+
+/* points S at LEN bytes of BUF from DATA on */
+static void str_view(KrutString *s, KrutStrBuf *buf, char *data, int64_t len) {
+  s->len = len;
+  s->data = data;
+  s->buf = buf;
+}
+
+/* a string of LEN uninitialized bytes, with room for CAP in its buffer */
+static KrutString *str_make(int64_t len, int64_t cap) {
+  KrutString *s = str_alloc();
+  if (cap <= KRUT_STR_INLINE) {
+    s->len = len;
+    s->data = s->inline_data;
+    s->buf = NULL;
+    return s;
+  }
+  KrutStrBuf *buf = str_buf_new(cap);
+  buf->used = len;
+  str_view(s, buf, buf->bytes, len);
+  return s;
+}
+
+KrutString *krut_str_new(const char *data, int64_t len) {
+  KrutString *s = str_make(len, len);
+  memcpy(s->data, data, len);
+  return s;
+}
+
+KrutString *krut_str_concat(KrutString *a, KrutString *b) {
+  int64_t alen = str_len(a), blen = str_len(b);
+  KrutStrBuf *buf = a ? a->buf : NULL;
+  bool at_end = buf && a->data + alen == buf->bytes + buf->used;
+  if (at_end && buf->cap - buf->used >= blen) {
+    memcpy(a->data + alen, str_data(b), blen);
+    buf->used += blen;
+    buf->shared = 1;
+    KrutString *s = str_alloc();
+    str_view(s, buf, a->data, alen + blen);
+    return s;
+  }
+  /* a string being appended to gets room to grow */
+  int64_t cap = at_end ? 2 * (alen + blen) : alen + blen;
+  KrutString *s = str_make(alen + blen, cap);
+  memcpy(s->data, str_data(a), alen);
+  memcpy(s->data + alen, str_data(b), blen);
+  return s;
+}
+
+int64_t krut_str_eq(KrutString *a, KrutString *b) {
+  return str_len(a) == str_len(b) &&
+         memcmp(str_data(a), str_data(b), str_len(a)) == 0;
+}
+
+int64_t krut_str_cmp(KrutString *a, KrutString *b) {
+  int64_t alen = str_len(a), blen = str_len(b);
+  int c = memcmp(str_data(a), str_data(b), alen < blen ? alen : blen);
+  if (c) return c < 0 ? -1 : 1;
+  return alen < blen ? -1 : alen > blen;
+}
+
+int64_t krut_str_length(KrutString *s) { return str_len(s); }
+
+/* the buffer is left as it is, for the strings that share it */
+void krut_str_clear(KrutString *s) {
+  if (s) s->len = 0;
+}
+
+int64_t krut_str_is_empty(KrutString *s) { return str_len(s) == 0; }
+
+static void check_index(int64_t i, int64_t len, int64_t line) {
+  if (i < 0 || i >= len) {
+    fail(line, "index " + to_string(i) +
+                            " out of range for length " + to_string(len));
+  }
+}
+
+static void check_slice(int64_t start, int64_t end, int64_t len,
+                        int64_t line) {
+  if (start < 0 || end > len || start > end) {
+    fail(line, "slice [" + to_string(start) + ":" + to_string(end) +
+                            "] out of range for length " + to_string(len));
+  }
+}
+
+int64_t krut_str_front(KrutString *s, int64_t line) {
+  if (!str_len(s)) fail(line, "front() of an empty string");
+  return (unsigned char)s->data[0];
+}
+
+int64_t krut_str_back(KrutString *s, int64_t line) {
+  if (!str_len(s)) fail(line, "back() of an empty string");
+  return (unsigned char)s->data[s->len - 1];
+}
+
+int64_t krut_str_get(KrutString *s, int64_t i, int64_t line) {
+  check_index(i, str_len(s), line);
+  return (unsigned char)s->data[i];
+}
+
+void krut_str_set(KrutString *s, int64_t i, int64_t c, int64_t line) {
+  check_index(i, str_len(s), line);
+  if (s->buf && s->buf->shared) {
+    /* copy on write, to a buffer of S's own */
+    KrutStrBuf *buf = str_buf_new(s->len);
+    memcpy(buf->bytes, s->data, s->len);
+    buf->used = s->len;
+    str_view(s, buf, buf->bytes, s->len);
+  }
+  s->data[i] = (char)c;
+}
+
+/* a view of S's buffer, or inline if short enough */
+KrutString *krut_str_slice(KrutString *s, int64_t start, int64_t end,
+                           int64_t line) {
+  check_slice(start, end, str_len(s), line);
+  int64_t len = end - start;
+  if (len <= KRUT_STR_INLINE) return krut_str_new(str_data(s) + start, len);
+  KrutString *view = str_alloc();
+  s->buf->shared = 1;
+  str_view(view, s->buf, s->data + start, len);
+  return view;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Element comparison and hashing, by kind
+//
+//////////////////////////////////////////////////////////////
+
+static double slot_deci(int64_t v) {
+  double d;
+  memcpy(&d, &v, sizeof(d));
+  return d;
+}
+
+static uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  return h ^ (h >> 33);
+}
+
+/* the bytes each element of L takes */
+static int64_t elem_size(const KrutList *l) {
+  return l->kind == KRUT_KIND_BYTE ? 1 : sizeof(int64_t);
+}
+
+/* element I of L, as a slot */
+static int64_t list_at(const KrutList *l, int64_t i) {
+  if (l->kind == KRUT_KIND_BYTE) return ((uint8_t *)l->data)[i];
+  return ((int64_t *)l->data)[i];
+}
+
+static void list_put(KrutList *l, int64_t i, int64_t v) {
+  if (l->kind == KRUT_KIND_BYTE) {
+    ((uint8_t *)l->data)[i] = (uint8_t)v;
+  } else {
+    ((int64_t *)l->data)[i] = v;
+  }
+}
+
+/* 8 bytes at a time, then the rest */
+static uint64_t str_hash(KrutString *s) {
+  const char *p = str_data(s);
+  int64_t n = str_len(s);
+  uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t)n;
+  for (; n >= 8; p += 8, n -= 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    h = mix(h ^ w);
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, p, n);
+  return mix(h ^ tail);
+}
+
+static bool elem_eq(int64_t kind, int64_t a, int64_t b) {
+  switch (kind) {
+    case KRUT_KIND_DECI:
+      return slot_deci(a) == slot_deci(b);
+    case KRUT_KIND_STR:
+      return krut_str_eq((KrutString *)a, (KrutString *)b);
+    case KRUT_KIND_LIST:
+      return krut_list_eq((KrutList *)a, (KrutList *)b);
+    case KRUT_KIND_SET:
+      return krut_set_eq((KrutSet *)a, (KrutSet *)b);
+    case KRUT_KIND_DICT:
+      return krut_dict_eq((KrutDict *)a, (KrutDict *)b);
+    default:
+      return a == b;
+  }
+}
+
+static uint64_t elem_hash(int64_t kind, int64_t v) {
+  switch (kind) {
+    case KRUT_KIND_DECI: {
+      double d = slot_deci(v);
+      if (d == 0) d = 0; /* -0.0 == 0.0 */
+      int64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      return mix(bits);
+    }
+    case KRUT_KIND_STR:
+      return str_hash((KrutString *)v);
+    case KRUT_KIND_LIST: {
+      KrutList *l = (KrutList *)v;
+      uint64_t h = 0;
+      for (int64_t i = 0; l && i < l->len; i++) {
+        h = mix(h + elem_hash(l->kind, list_at(l, i)));
+      }
+      return h;
+    }
+    case KRUT_KIND_SET: {
+      /* order independent */
+      KrutSet *s = (KrutSet *)v;
+      uint64_t h = 0;
+      for (int64_t i = 0; s && i < s->cap; i++) {
+        if (s->ctrl[i] >= 0) h += elem_hash(s->kind, s->keys[i * s->width]);
+      }
+      return mix(h);
+    }
+    case KRUT_KIND_DICT: {
+      /* order independent, like a set of (key, value) pairs */
+      KrutDict *d = (KrutDict *)v;
+      uint64_t h = 0;
+      for (int64_t i = 0; d && i < d->keys.cap; i++) {
+        if (d->keys.ctrl[i] >= 0) {
+          h += mix(elem_hash(d->keys.kind, d->keys.keys[2 * i]) ^
+                   elem_hash(d->vkind, d->keys.keys[2 * i + 1]));
+        }
+      }
+      return mix(h);
+    }
+    default:
+      return mix(v);
+  }
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Lists
+//
+//////////////////////////////////////////////////////////////
+
+/*
+  A list's elements are contiguous from data on, with CAP - LEN free
+  elements after them and FRONT free ones before, so that both ends grow
+  and shrink in amortized O(1) and an element is always at data[i].
+*/
+static char *list_base(KrutList *l) {
+  return (char *)l->data - l->front * elem_size(l);
+}
+
+/* makes room for CAP elements from data on */
+static void list_reserve(KrutList *l, int64_t cap) {
+  if (cap <= l->cap) return;
+  int64_t size = elem_size(l);
+  /* a queue that has popped at least as many as it holds slides back to
+     the start of its buffer, which costs no more than those pops did */
+  if (l->front >= l->len && l->front + l->cap >= cap) {
+    memmove(list_base(l), l->data, l->len * size);
+    l->data = list_base(l);
+    l->cap += l->front;
+    l->front = 0;
+    return;
+  }
+  int64_t new_cap = l->cap ? (l->front + l->cap) * 2 : 4;
+  if (new_cap < cap) new_cap = cap;
+  char *base = (char *)xrealloc(list_base(l), (l->front + new_cap) * size);
+  l->data = base + l->front * size;
+  l->cap = new_cap;
+}
+
+/* makes room for an element before data */
+static void list_reserve_front(KrutList *l) {
+  if (l->front) return;
+  int64_t size = elem_size(l);
+  int64_t room = l->len > 4 ? l->len : 4;
+  char *base = (char *)xmalloc((room + l->cap) * size);
+  memcpy(base + room * size, l->data, l->len * size);
+  free(list_base(l));
+  l->data = base + room * size;
+  l->front = room;
+}
+
+KrutList *krut_list_new(int64_t kind, int64_t cap) {
+  KrutList *l = (KrutList *)xmalloc(sizeof(KrutList));
+  l->len = 0;
+  l->cap = 0;
+  l->data = NULL;
+  l->kind = kind;
+  l->front = 0;
+  list_reserve(l, cap);
+  return l;
+}
+
+int64_t krut_list_length(KrutList *l) { return l->len; }
+
+void krut_list_clear(KrutList *l) {
+  l->data = list_base(l);
+  l->cap += l->front;
+  l->front = 0;
+  l->len = 0;
+}
+
+int64_t krut_list_is_empty(KrutList *l) { return l->len == 0; }
+
+void krut_list_push_back(KrutList *l, int64_t v) {
+  list_reserve(l, l->len + 1);
+  list_put(l, l->len++, v);
+}
+
+void krut_list_push_front(KrutList *l, int64_t v) {
+  list_reserve_front(l);
+  l->data = (char *)l->data - elem_size(l);
+  l->front--;
+  l->cap++;
+  l->len++;
+  list_put(l, 0, v);
+}
+
+void krut_list_pop_back(KrutList *l, int64_t line) {
+  if (!l->len) fail(line, "pop_back() of an empty list");
+  l->len--;
+}
+
+void krut_list_pop_front(KrutList *l, int64_t line) {
+  if (!l->len) fail(line, "pop_front() of an empty list");
+  l->data = (char *)l->data + elem_size(l);
+  l->front++;
+  l->cap--;
+  l->len--;
+}
+
+int64_t krut_list_front(KrutList *l, int64_t line) {
+  if (!l->len) fail(line, "front() of an empty list");
+  return list_at(l, 0);
+}
+
+int64_t krut_list_back(KrutList *l, int64_t line) {
+  if (!l->len) fail(line, "back() of an empty list");
+  return list_at(l, l->len - 1);
+}
+
+int64_t krut_list_contains(KrutList *l, int64_t v) {
+  for (int64_t i = 0; i < l->len; i++) {
+    if (elem_eq(l->kind, list_at(l, i), v)) return i;
+  }
+  return -1;
+}
+
+int64_t krut_list_get(KrutList *l, int64_t i, int64_t line) {
+  check_index(i, l->len, line);
+  return list_at(l, i);
+}
+
+void krut_list_set(KrutList *l, int64_t i, int64_t v, int64_t line) {
+  check_index(i, l->len, line);
+  list_put(l, i, v);
+}
+
+KrutList *krut_list_slice(KrutList *l, int64_t start, int64_t end,
+                          int64_t line) {
+  check_slice(start, end, l->len, line);
+  KrutList *s = krut_list_new(l->kind, end - start);
+  int64_t size = elem_size(l);
+  memcpy(s->data, (char *)l->data + start * size, (end - start) * size);
+  s->len = end - start;
+  return s;
+}
+
+KrutList *krut_list_concat(KrutList *a, KrutList *b) {
+  /* as list<object>, a list of bytes can meet one of slots */
+  if (elem_size(a) != elem_size(b)) {
+    KrutList *l = krut_list_new(KRUT_KIND_BITS, a->len + b->len);
+    for (int64_t i = 0; i < a->len; i++) list_put(l, l->len++, list_at(a, i));
+    for (int64_t i = 0; i < b->len; i++) list_put(l, l->len++, list_at(b, i));
+    return l;
+  }
+  KrutList *l = krut_list_new(a->kind, a->len + b->len);
+  int64_t size = elem_size(l);
+  memcpy(l->data, a->data, a->len * size);
+  memcpy((char *)l->data + a->len * size, b->data, b->len * size);
+  l->len = a->len + b->len;
+  return l;
+}
+
+int64_t krut_list_eq(KrutList *a, KrutList *b) {
+  if (a == b) return 1;
+  if (!a || !b || a->len != b->len) return 0;
+  for (int64_t i = 0; i < a->len; i++) {
+    if (!elem_eq(a->kind, list_at(a, i), list_at(b, i))) return 0;
+  }
+  return 1;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Sets: a Swiss table
+//
+//////////////////////////////////////////////////////////////
+
+/*
+  Buckets come in groups of SET_GROUP. Each has a control byte, which is
+  CTRL_EMPTY, CTRL_DELETED, or, when full, 7 bits of its key's hash (H2).
+  The rest of the hash (H1) picks the group a probe starts at; the probe
+  compares H2 against a whole group's control bytes at once, compares
+  keys only where they match, and stops at the first group with an empty
+  bucket. A group that has an empty bucket has never been full, so no
+  probe goes past it, and a key removed from it leaves its bucket empty
+  rather than deleted.
+
+  A dict keeps each value in the slot after its key, so that finding a
+  key finds its value in the same cache line.
+
+  The probe is compiled once for each element kind, so that ints, bools
+  and chars are hashed and compared inline, and strings without a switch.
+*/
+
+/* a bit mask, one bit per bucket of a group */
+static inline int lowest_bit(uint32_t mask) {
+#ifdef __GNUC__
+  return __builtin_ctz(mask);
+#else
+  int i = 0;
+  while (!(mask >> i & 1)) i++;
+  return i;
+#endif
+}
+
+struct SetGroup {
+#if defined(__SSE2__)
+  __m128i ctrl;
+  explicit SetGroup(const int8_t *p)
+      : ctrl(_mm_loadu_si128((const __m128i *)p)) {}
+  uint32_t match(int8_t h2) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+  }
+  /* empty or deleted: the high bit set */
+  uint32_t match_free() const { return _mm_movemask_epi8(ctrl); }
+#else
+  const int8_t *ctrl;
+  explicit SetGroup(const int8_t *p) : ctrl(p) {}
+  uint32_t match(int8_t h2) const {
+    uint32_t mask = 0;
+    for (int i = 0; i < SET_GROUP; i++) mask |= (uint32_t)(ctrl[i] == h2) << i;
+    return mask;
+  }
+  uint32_t match_free() const {
+    uint32_t mask = 0;
+    for (int i = 0; i < SET_GROUP; i++) mask |= (uint32_t)(ctrl[i] < 0) << i;
+    return mask;
+  }
+#endif
+  uint32_t match_empty() const { return match(CTRL_EMPTY); }
+  uint32_t match_full() const { return ~match_free() & 0xFFFF; }
+};
+
+template <int64_t K>
+static inline uint64_t set_hash(int64_t v) {
+  if (K == KRUT_KIND_BITS || K == KRUT_KIND_BYTE) return mix(v);
+  if (K == KRUT_KIND_STR) return str_hash((KrutString *)v);
+  return elem_hash(K, v);
+}
+
+template <int64_t K>
+static inline bool set_eq(int64_t a, int64_t b) {
+  if (K == KRUT_KIND_BITS || K == KRUT_KIND_BYTE) return a == b;
+  if (K == KRUT_KIND_STR) return krut_str_eq((KrutString *)a, (KrutString *)b);
+  return elem_eq(K, a, b);
+}
+
+/* calls F<kind>(args...) with S's kind as a constant */
+#define SET_DISPATCH(kind, f, ...)                   \
+  switch (kind) {                                    \
+    case KRUT_KIND_DECI:                             \
+      return f<KRUT_KIND_DECI>(__VA_ARGS__);         \
+    case KRUT_KIND_STR:                              \
+      return f<KRUT_KIND_STR>(__VA_ARGS__);          \
+    case KRUT_KIND_LIST:                             \
+      return f<KRUT_KIND_LIST>(__VA_ARGS__);         \
+    case KRUT_KIND_SET:                              \
+      return f<KRUT_KIND_SET>(__VA_ARGS__);          \
+    case KRUT_KIND_DICT:                             \
+      return f<KRUT_KIND_DICT>(__VA_ARGS__);         \
+    default:                                         \
+      return f<KRUT_KIND_BITS>(__VA_ARGS__);         \
+  }
+
+/* the bucket holding V, whose hash is H, or -1 */
+template <int64_t K>
+static int64_t set_find(const KrutSet *s, int64_t v, uint64_t h) {
+  if (!s->cap) return -1;
+  uint64_t groups = s->cap / SET_GROUP;
+  uint64_t g = (h >> 7) & (groups - 1);
+  for (uint64_t step = 1;; step++) {
+    SetGroup group(s->ctrl + g * SET_GROUP);
+    for (uint32_t m = group.match(h & 0x7F); m; m &= m - 1) {
+      int64_t i = g * SET_GROUP + lowest_bit(m);
+      if (set_eq<K>(s->keys[i * s->width], v)) return i;
+    }
+    if (group.match_empty() || step > groups) return -1;
+    g = (g + step) & (groups - 1); /* visits every group */
+  }
+}
+
+/* the first free bucket on the probe path of hash H */
+static int64_t set_free_bucket(const KrutSet *s, uint64_t h) {
+  uint64_t groups = s->cap / SET_GROUP;
+  uint64_t g = (h >> 7) & (groups - 1);
+  for (uint64_t step = 1;; step++) {
+    uint32_t m = SetGroup(s->ctrl + g * SET_GROUP).match_free();
+    if (m) return g * SET_GROUP + lowest_bit(m);
+    g = (g + step) & (groups - 1);
+  }
+}
+
+/* puts V, which S does not hold, in S; S has room for it. Returns its
+   bucket */
+static int64_t set_put(KrutSet *s, int64_t v, uint64_t h) {
+  int64_t i = set_free_bucket(s, h);
+  if (s->ctrl[i] == CTRL_EMPTY) s->used++;
+  s->ctrl[i] = h & 0x7F;
+  s->keys[i * s->width] = v;
+  s->len++;
+  return i;
+}
+
+static void set_init(KrutSet *s, int64_t kind, int64_t width) {
+  s->len = s->cap = s->used = 0;
+  s->keys = NULL;
+  s->ctrl = NULL;
+  s->kind = kind;
+  s->width = width;
+}
+
+/* CAP empty buckets */
+static void set_alloc(KrutSet *s, int64_t cap) {
+  s->cap = cap;
+  s->keys = (int64_t *)xmalloc(cap * s->width * sizeof(int64_t));
+  s->ctrl = (int8_t *)xmalloc(cap);
+  memset(s->ctrl, CTRL_EMPTY, cap);
+  s->len = s->used = 0;
+}
+
+KrutSet *krut_set_new(int64_t kind) {
+  KrutSet *s = (KrutSet *)xmalloc(sizeof(KrutSet));
+  set_init(s, kind, 1);
+  return s;
+}
+
+/* calls F(bucket) for each full bucket of S, a group at a time */
+template <class F>
+static void set_each_bucket(const KrutSet *s, F f) {
+  for (int64_t g = 0; g < s->cap; g += SET_GROUP) {
+    for (uint32_t m = SetGroup(s->ctrl + g).match_full(); m; m &= m - 1) {
+      f(g + lowest_bit(m));
+    }
+  }
+}
+
+/* calls F(key) for each key of S */
+template <class F>
+static void set_each(const KrutSet *s, F f) {
+  set_each_bucket(s, [&](int64_t i) { f(s->keys[i * s->width]); });
+}
+
+/* moves S's keys, and a dict's values, to a table of CAP buckets */
+template <int64_t K>
+static void set_rehash(KrutSet *s, int64_t cap) {
+  KrutSet old = *s;
+  set_alloc(s, cap);
+  set_each_bucket(&old, [&](int64_t i) {
+    const int64_t *from = old.keys + i * old.width;
+    int64_t j = set_put(s, from[0], set_hash<K>(from[0]));
+    if (s->width == 2) s->keys[2 * j + 1] = from[1];
+  });
+  free(old.keys);
+  free(old.ctrl);
+}
+
+/* makes room for N more keys: full and deleted buckets stay under 7/8 */
+template <int64_t K>
+static void set_reserve(KrutSet *s, int64_t n) {
+  if ((s->used + n) * 8 <= s->cap * 7) return;
+  int64_t cap = s->cap ? s->cap : SET_GROUP;
+  while ((s->len + n) * 2 > cap) cap *= 2;
+  set_rehash<K>(s, cap);
+}
+
+int64_t krut_set_length(KrutSet *s) { return s->len; }
+
+void krut_set_clear(KrutSet *s) {
+  if (s->cap) memset(s->ctrl, CTRL_EMPTY, s->cap);
+  s->len = s->used = 0;
+}
+
+int64_t krut_set_is_empty(KrutSet *s) { return s->len == 0; }
+
+template <int64_t K>
+static void set_insert(KrutSet *s, int64_t v) {
+  uint64_t h = set_hash<K>(v);
+  if (set_find<K>(s, v, h) >= 0) return;
+  set_reserve<K>(s, 1);
+  set_put(s, v, h);
+}
+
+void krut_set_insert(KrutSet *s, int64_t v) {
+  SET_DISPATCH(s->kind, set_insert, s, v);
+}
+
+template <int64_t K>
+static int64_t set_remove(KrutSet *s, int64_t v) {
+  int64_t i = set_find<K>(s, v, set_hash<K>(v));
+  if (i < 0) return 0;
+  int64_t g = i - i % SET_GROUP;
+  if (SetGroup(s->ctrl + g).match_empty()) {
+    s->ctrl[i] = CTRL_EMPTY;
+    s->used--;
+  } else {
+    s->ctrl[i] = CTRL_DELETED;
+  }
+  s->len--;
+  return 1;
+}
+
+int64_t krut_set_remove(KrutSet *s, int64_t v) {
+  if (!s->len) return 0;
+  SET_DISPATCH(s->kind, set_remove, s, v);
+}
+
+template <int64_t K>
+static int64_t set_contains(KrutSet *s, int64_t v) {
+  return set_find<K>(s, v, set_hash<K>(v)) >= 0;
+}
+
+int64_t krut_set_contains(KrutSet *s, int64_t v) {
+  if (!s->len) return 0;
+  SET_DISPATCH(s->kind, set_contains, s, v);
+}
+
+/* A + B: a copy of A's table, sized for both, then B's keys that it lacks,
+   each hashed once */
+template <int64_t K>
+static KrutSet *set_union(KrutSet *a, KrutSet *b) {
+  KrutSet *s = krut_set_new(a->kind);
+  int64_t cap = SET_GROUP;
+  while ((a->len + b->len) * 2 > cap) cap *= 2;
+  if (cap <= a->cap && a->used == a->len) {
+    /* A has room and no deleted buckets: copy it as it is */
+    set_alloc(s, a->cap);
+    memcpy(s->keys, a->keys, a->cap * sizeof(int64_t));
+    memcpy(s->ctrl, a->ctrl, a->cap);
+    s->len = s->used = a->len;
+  } else {
+    set_alloc(s, cap);
+    set_each(a, [&](int64_t v) { set_put(s, v, set_hash<K>(v)); });
+  }
+  set_each(b, [&](int64_t v) {
+    uint64_t h = set_hash<K>(v);
+    if (set_find<K>(s, v, h) < 0) {
+      set_reserve<K>(s, 1);
+      set_put(s, v, h);
+    }
+  });
+  return s;
+}
+
+KrutSet *krut_set_union(KrutSet *a, KrutSet *b) {
+  SET_DISPATCH(a->kind, set_union, a, b);
+}
+
+/* A - B: A's keys that B lacks, each hashed once, into a table sized for
+   all of A */
+template <int64_t K>
+static KrutSet *set_difference(KrutSet *a, KrutSet *b) {
+  KrutSet *s = krut_set_new(a->kind);
+  set_reserve<K>(s, a->len);
+  set_each(a, [&](int64_t v) {
+    uint64_t h = set_hash<K>(v);
+    if (set_find<K>(b, v, h) < 0) set_put(s, v, h);
+  });
+  return s;
+}
+
+KrutSet *krut_set_difference(KrutSet *a, KrutSet *b) {
+  SET_DISPATCH(a->kind, set_difference, a, b);
+}
+
+int64_t krut_set_eq(KrutSet *a, KrutSet *b) {
+  if (a == b) return 1;
+  if (!a || !b || a->len != b->len) return 0;
+  bool eq = true;
+  set_each(a, [&](int64_t v) { eq = eq && krut_set_contains(b, v); });
+  return eq;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Dicts: a set of the keys, with a value beside each
+//
+//////////////////////////////////////////////////////////////
+
+/*
+  A dict is the Swiss table above with two slots per bucket, the key and
+  its value, so an int, bool or char key or value is stored in the table
+  itself and a value moves with its key when the table grows. Lookups go
+  through the set's probe, compiled for the key kind.
+*/
+
+KrutDict *krut_dict_new(int64_t kind, int64_t vkind) {
+  KrutDict *d = (KrutDict *)xmalloc(sizeof(KrutDict));
+  set_init(&d->keys, kind, 2);
+  d->vkind = vkind;
+  return d;
+}
+
+/* the value in bucket I */
+static int64_t &dict_val(KrutDict *d, int64_t i) {
+  return d->keys.keys[2 * i + 1];
+}
+
+template <int64_t K>
+static int64_t dict_find(const KrutDict *d, int64_t k) {
+  return set_find<K>(&d->keys, k, set_hash<K>(k));
+}
+
+/* the bucket holding key K, or -1 */
+static int64_t dict_bucket(const KrutDict *d, int64_t k) {
+  if (!d->keys.len) return -1;
+  SET_DISPATCH(d->keys.kind, dict_find, d, k);
+}
+
+int64_t krut_dict_length(KrutDict *d) { return d->keys.len; }
+
+void krut_dict_clear(KrutDict *d) { krut_set_clear(&d->keys); }
+
+int64_t krut_dict_is_empty(KrutDict *d) { return d->keys.len == 0; }
+
+int64_t krut_dict_get(KrutDict *d, int64_t k, int64_t line) {
+  int64_t i = dict_bucket(d, k);
+  if (i < 0) fail(line, "get() of a key not in the dict");
+  return dict_val(d, i);
+}
+
+template <int64_t K>
+static void dict_insert(KrutDict *d, int64_t k, int64_t v) {
+  uint64_t h = set_hash<K>(k);
+  int64_t i = set_find<K>(&d->keys, k, h);
+  if (i < 0) {
+    set_reserve<K>(&d->keys, 1);
+    i = set_put(&d->keys, k, h);
+  }
+  dict_val(d, i) = v;
+}
+
+void krut_dict_insert(KrutDict *d, int64_t k, int64_t v) {
+  SET_DISPATCH(d->keys.kind, dict_insert, d, k, v);
+}
+
+/* the value is left in its bucket, which is no longer full */
+int64_t krut_dict_remove(KrutDict *d, int64_t k) {
+  return krut_set_remove(&d->keys, k);
+}
+
+int64_t krut_dict_contains(KrutDict *d, int64_t k) {
+  return dict_bucket(d, k) >= 0;
+}
+
+KrutList *krut_dict_keys(KrutDict *d) {
+  KrutList *l = krut_list_new(d->keys.kind, d->keys.len);
+  set_each(&d->keys, [&](int64_t k) { krut_list_push_back(l, k); });
+  return l;
+}
+
+/* in the order of krut_dict_keys() */
+KrutList *krut_dict_values(KrutDict *d) {
+  KrutList *l = krut_list_new(d->vkind, d->keys.len);
+  set_each_bucket(&d->keys,
+                  [&](int64_t i) { krut_list_push_back(l, dict_val(d, i)); });
+  return l;
+}
+
+int64_t krut_dict_eq(KrutDict *a, KrutDict *b) {
+  if (a == b) return 1;
+  if (!a || !b || a->keys.len != b->keys.len) return 0;
+  bool eq = true;
+  set_each_bucket(&a->keys, [&](int64_t i) {
+    if (!eq) return;
+    int64_t j = dict_bucket(b, a->keys.keys[2 * i]);
+    eq = j >= 0 && elem_eq(a->vkind, dict_val(a, i), dict_val(b, j));
+  });
+  return eq;
+}
+
+//////////////////////////////////////////////////////////////
+//
+// Builtin global methods
+//
+//////////////////////////////////////////////////////////////
+
+void krut_print(KrutString *s) {
+  fwrite(str_data(s), 1, str_len(s), stdout);
+  fputc('\n', stdout);
+}
+
+KrutString *krut_input(KrutString *prompt) {
+  fwrite(str_data(prompt), 1, str_len(prompt), stdout);
+  fflush(stdout);
+  string line;
+  getline(cin, line);
+  return krut_str_new(line.data(), line.size());
+}
+
+KrutString *krut_to_string(int64_t i) {
+  string s = to_string((long long)i);
+  return krut_str_new(s.data(), s.size());
+}
+
+int64_t krut_sum(KrutList *l) {
+  if (l->kind == KRUT_KIND_DECI) {
+    double sum = 0;
+    for (int64_t i = 0; i < l->len; i++) sum += slot_deci(list_at(l, i));
+    return (int64_t)sum;
+  }
+  int64_t sum = 0;
+  for (int64_t i = 0; i < l->len; i++) sum += list_at(l, i);
+  return sum;
+}
+
+/* the least (SIGN 1) or greatest (SIGN -1) element of L */
+static int64_t list_extreme(KrutList *l, int sign, const char *name,
+                            int64_t line) {
+  if (!l->len) fail(line, string(name) + "() of an empty list");
+  if (l->kind == KRUT_KIND_DECI) {
+    double best = slot_deci(list_at(l, 0));
+    for (int64_t i = 1; i < l->len; i++) {
+      double d = slot_deci(list_at(l, i));
+      if (sign * d < sign * best) best = d;
+    }
+    return (int64_t)best;
+  }
+  int64_t best = list_at(l, 0);
+  for (int64_t i = 1; i < l->len; i++) {
+    int64_t v = list_at(l, i);
+    if (sign > 0 ? v < best : v > best) best = v;
+  }
+  return best;
+}
+
+int64_t krut_min(KrutList *l, int64_t line) {
+  return list_extreme(l, 1, "min", line);
+}
+
+int64_t krut_max(KrutList *l, int64_t line) {
+  return list_extreme(l, -1, "max", line);
+}
+
+void krut_kill(KrutString *err_msg) {
+  fflush(stdout);
+  fwrite(str_data(err_msg), 1, str_len(err_msg), stderr);
+  fputc('\n', stderr);
+  exit(1);
+}
@@ -0,0 +1,235 @@
+/*
+  runtime.h
+  The KrutC runtime library (libkrutrt): the builtin string, list, set and
+  dict classes, the builtin global methods, and runtime errors. Compiled KrutC
+  code calls these through the C ABI; codegen.cpp declares each one it uses
+  with a matching LLVM signature, so keep the two in sync.
+
+  Representation, as seen from generated code:
+    int -> int64_t, deci -> double, bool -> i1, char -> i8
+    string, list<T>, set<T>, dict<K, V>, class instances -> pointers
+    object -> a 64-bit slot holding the bits of any of the above
+  Sets and dicts store every key and value as a slot, and so do lists,
+  except that a list<bool> or list<char> stores one byte per element. The
+  element kind says which, and how to compare and hash elements, e.g.
+  strings by contents rather than by address. bools and chars cross the C
+  ABI as int64_t, chars as 0..255. Generated code reads and writes the
+  elements of a list whose element type it knows directly (see KrutList).
+  Short strings are stored inline and long ones share their bytes with
+  their slices (see KrutString).
+*/
+
+#ifndef KRUT_RUNTIME_H
+#define KRUT_RUNTIME_H
+
+#include <cstdint>
+
+/* how the slots of a list or set are compared and hashed */
+enum KrutKind : int64_t {
+  KRUT_KIND_BITS = 0, /* int, bool, char, object, class instances */
+  KRUT_KIND_DECI = 1,
+  KRUT_KIND_STR = 2,
+  KRUT_KIND_LIST = 3,
+  KRUT_KIND_SET = 4,
+  KRUT_KIND_BYTE = 5, /* bool, char: one byte each in a list */
+  KRUT_KIND_DICT = 6
+};
+
+/* the bytes that strings longer than KRUT_STR_INLINE live in; never
+   written once SHARED, except past USED (see krut_str_concat()). Never
+   freed, since the strings that point into it never are either. */
+struct KrutStrBuf {
+  int64_t shared; /* set once a second string points into it */
+  int64_t cap;
+  int64_t used; /* bytes that some string includes */
+  char bytes[];
+};
+
+#define KRUT_STR_INLINE 24
+
+/* LEN bytes from DATA on, which is either inline, or a view of BUF;
+   not NUL terminated */
+struct KrutString {
+  int64_t len;
+  char *data;
+  KrutStrBuf *buf; /* NULL when inline */
+  char inline_data[KRUT_STR_INLINE];
+};
+
+/* codegen.cpp reads and writes len, cap and data itself, so keep the
+   layout in sync with its list_field() */
+struct KrutList {
+  int64_t len;
+  int64_t cap;
+  void *data; /* int64_t slots, or uint8_t for KRUT_KIND_BYTE */
+  int64_t kind;
+  int64_t front; /* free elements before data, left by pop_front() */
+};
+
+struct KrutSet {
+  int64_t len;
+  int64_t cap;  /* number of buckets: 0, or a power of two of at least 16 */
+  int64_t used; /* full and deleted buckets */
+  int64_t *keys; /* WIDTH slots per bucket, the key first */
+  int8_t *ctrl;  /* per bucket: empty, deleted, or part of its key's hash */
+  int64_t kind;
+  int64_t width; /* 1, or 2 for a dict: its key, then its value */
+};
+
+/* a set of the keys, with each key's value in the slot after it */
+struct KrutDict {
+  KrutSet keys;
+  int64_t vkind; /* the values' kind, e.g. for values() and == */
+};
+
+extern "C" {
+
+/* program startup; FILENAME is used in runtime error messages */
+void krut_init(const char *filename, int argc, char **argv);
+KrutList *krut_args();
+
+[[noreturn]] void krut_div_by_zero(int64_t line);
+[[noreturn]] void krut_null_dispatch(int64_t line);
+[[noreturn]] void krut_unsupported(int64_t line, const char *what);
+
+/* zeroed memory for an object of SIZE bytes */
+void *krut_alloc(int64_t size);
+/* the name of an object's class, from slot 0 of its vtable */
+KrutString *krut_class_name(void *obj);
+
+/* strings */
+KrutString *krut_str_new(const char *data, int64_t len);
+KrutString *krut_str_concat(KrutString *a, KrutString *b);
+int64_t krut_str_eq(KrutString *a, KrutString *b);
+int64_t krut_str_cmp(KrutString *a, KrutString *b);
+int64_t krut_str_length(KrutString *s);
+void krut_str_clear(KrutString *s);
+int64_t krut_str_is_empty(KrutString *s);
+int64_t krut_str_front(KrutString *s, int64_t line);
+int64_t krut_str_back(KrutString *s, int64_t line);
+int64_t krut_str_get(KrutString *s, int64_t i, int64_t line);
+void krut_str_set(KrutString *s, int64_t i, int64_t c, int64_t line);
+KrutString *krut_str_slice(KrutString *s, int64_t start, int64_t end,
+                           int64_t line);
+
+/* lists */
+KrutList *krut_list_new(int64_t kind, int64_t cap);
+int64_t krut_list_length(KrutList *l);
+void krut_list_clear(KrutList *l);
+int64_t krut_list_is_empty(KrutList *l);
+void krut_list_push_back(KrutList *l, int64_t v);
+void krut_list_push_front(KrutList *l, int64_t v);
+void krut_list_pop_back(KrutList *l, int64_t line);
+void krut_list_pop_front(KrutList *l, int64_t line);
+int64_t krut_list_front(KrutList *l, int64_t line);
+int64_t krut_list_back(KrutList *l, int64_t line);
+int64_t krut_list_contains(KrutList *l, int64_t v);
+int64_t krut_list_get(KrutList *l, int64_t i, int64_t line);
+void krut_list_set(KrutList *l, int64_t i, int64_t v, int64_t line);
+KrutList *krut_list_slice(KrutList *l, int64_t start, int64_t end,
+                          int64_t line);
+KrutList *krut_list_concat(KrutList *a, KrutList *b);
+int64_t krut_list_eq(KrutList *a, KrutList *b);
+
+/* sets */
+KrutSet *krut_set_new(int64_t kind);
+int64_t krut_set_length(KrutSet *s);
+void krut_set_clear(KrutSet *s);
+int64_t krut_set_is_empty(KrutSet *s);
+void krut_set_insert(KrutSet *s, int64_t v);
+int64_t krut_set_remove(KrutSet *s, int64_t v);
+int64_t krut_set_contains(KrutSet *s, int64_t v);
+KrutSet *krut_set_union(KrutSet *a, KrutSet *b);
+KrutSet *krut_set_difference(KrutSet *a, KrutSet *b);
+int64_t krut_set_eq(KrutSet *a, KrutSet *b);
+
+/* dicts */
+KrutDict *krut_dict_new(int64_t kind, int64_t vkind);
+int64_t krut_dict_length(KrutDict *d);
+void krut_dict_clear(KrutDict *d);
+int64_t krut_dict_is_empty(KrutDict *d);
+int64_t krut_dict_get(KrutDict *d, int64_t k, int64_t line);
+void krut_dict_insert(KrutDict *d, int64_t k, int64_t v);
+int64_t krut_dict_remove(KrutDict *d, int64_t k);
+int64_t krut_dict_contains(KrutDict *d, int64_t k);
+KrutList *krut_dict_keys(KrutDict *d);
+KrutList *krut_dict_values(KrutDict *d);
+int64_t krut_dict_eq(KrutDict *a, KrutDict *b);
+
+/* builtin global methods */
+void krut_print(KrutString *s);
+KrutString *krut_input(KrutString *prompt);
+KrutString *krut_to_string(int64_t i);
+int64_t krut_sum(KrutList *l);
+int64_t krut_min(KrutList *l, int64_t line);
+int64_t krut_max(KrutList *l, int64_t line);
+[[noreturn]] void krut_kill(KrutString *err_msg);
+}
+
+/* every function above, for code that needs a table of them all */
+#define KRUT_RUNTIME_FUNCTIONS(X) \
+  X(krut_init)                    \
+  X(krut_args)                    \
+  X(krut_div_by_zero)             \
+  X(krut_null_dispatch)           \
+  X(krut_unsupported)             \
+  X(krut_alloc)                   \
+  X(krut_class_name)              \
+  X(krut_str_new)                 \
+  X(krut_str_concat)              \
+  X(krut_str_eq)                  \
+  X(krut_str_cmp)                 \
+  X(krut_str_length)              \
+  X(krut_str_clear)               \
+  X(krut_str_is_empty)            \
+  X(krut_str_front)               \
+  X(krut_str_back)                \
+  X(krut_str_get)                 \
+  X(krut_str_set)                 \
+  X(krut_str_slice)               \
+  X(krut_list_new)                \
+  X(krut_list_length)             \
+  X(krut_list_clear)              \
+  X(krut_list_is_empty)           \
+  X(krut_list_push_back)          \
+  X(krut_list_push_front)         \
+  X(krut_list_pop_back)           \
+  X(krut_list_pop_front)          \
+  X(krut_list_front)              \
+  X(krut_list_back)               \
+  X(krut_list_contains)           \
+  X(krut_list_get)                \
+  X(krut_list_set)                \
+  X(krut_list_slice)              \
+  X(krut_list_concat)             \
+  X(krut_list_eq)                 \
+  X(krut_set_new)                 \
+  X(krut_set_length)              \
+  X(krut_set_clear)               \
+  X(krut_set_is_empty)            \
+  X(krut_set_insert)              \
+  X(krut_set_remove)              \
+  X(krut_set_contains)            \
+  X(krut_set_union)               \
+  X(krut_set_difference)          \
+  X(krut_set_eq)                  \
+  X(krut_dict_new)                \
+  X(krut_dict_length)             \
+  X(krut_dict_clear)              \
+  X(krut_dict_is_empty)           \
+  X(krut_dict_get)                \
+  X(krut_dict_insert)             \
+  X(krut_dict_remove)             \
+  X(krut_dict_contains)           \
+  X(krut_dict_keys)               \
+  X(krut_dict_values)             \
+  X(krut_dict_eq)                 \
+  X(krut_print)                   \
+  X(krut_input)                   \
+  X(krut_to_string)               \
+  X(krut_sum)                     \
+  X(krut_min)                     \
+  X(krut_max)                     \
+  X(krut_kill)
+
+#endif  // KRUT_RUNTIME_H